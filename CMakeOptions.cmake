@@ -19,6 +19,12 @@ option(LOG_CPU_INSTR "Enable CPU instruction logging" ${LOG_CPU_INSTR_DEFAULT})
 
 option(LOG_SUPPORT "Enable logging support" ON)
 
+# CC_MIN_LOG_LEVEL: LOG calls below this level are compiled out (FATAL is always kept)
+# Every level is kept by default; production builds pass -DCC_MIN_LOG_LEVEL=WARNING
+set(CC_MIN_LOG_LEVEL "ALL" CACHE STRING "Lowest log level compiled into the core")
+set_property(CACHE CC_MIN_LOG_LEVEL PROPERTY STRINGS ALL TRACE DEBUG INFO WARNING ERROR FATAL)
+#
+
 #--------------------------------------------------------------------
 # Sanitize Options
 #--------------------------------------------------------------------
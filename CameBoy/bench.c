@@ -0,0 +1,244 @@
+#include "bench.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "camecore/camecore.h"
+
+#define BENCH_MIN_SECONDS 0.5     // Time each measurement runs for at least
+#define BENCH_BUS_BATCH   0x100000 // Bus accesses between two clock reads
+#define BENCH_RUN_FRAMES  60       // Frames emulated between two clock reads
+
+typedef struct BenchResult
+{
+    size_t PackedSize;
+    double CompressRate;   // MB/s
+    double DecompressRate; // MB/s
+} BenchResult;
+
+typedef struct BusResult
+{
+    double ReadTime;  // ns per ReadBus()
+    double WriteTime; // ns per WriteBus()
+    double RunRate;   // Emulated frames per second (opcode and operand fetches)
+} BusResult;
+
+static u32 WatchHits = 0;
+
+static double
+GetSeconds( void )
+{
+    return (double)SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
+}
+
+static void
+CountWatchHit( u16 Addr, u8 Value, WatchKind Kind )
+{
+    (void)Addr;
+    (void)Value;
+    (void)Kind;
+    ++WatchHits;
+}
+
+// Reads ROM and WRAM page 0xC0-0xCF, writes WRAM page 0xC0-0xCF, then runs the calling thread's machine
+static bool
+MeasureBus( BusResult * Result )
+{
+    double Start;
+    double Elapsed;
+    u64    Count;
+    u32    Sum   = 0;
+    bool   Valid = true;
+
+    for( Count = 0, Start = GetSeconds(), Elapsed = 0.0; Elapsed < BENCH_MIN_SECONDS; Count += BENCH_BUS_BATCH )
+        {
+            for( u32 i = 0; i < BENCH_BUS_BATCH; i += 2 )
+                {
+                    Sum += ReadBus( (u16)( i & 0x7FFF ) );
+                    Sum += ReadBus( (u16)( 0xC000 | ( i & 0x0FFF ) ) );
+                }
+            Elapsed = GetSeconds() - Start;
+        }
+    Result->ReadTime = Elapsed * 1e9 / (double)Count;
+
+    for( Count = 0, Start = GetSeconds(), Elapsed = 0.0; Elapsed < BENCH_MIN_SECONDS; Count += BENCH_BUS_BATCH )
+        {
+            for( u32 i = 0; i < BENCH_BUS_BATCH; ++i ) WriteBus( (u16)( 0xC000 | ( i & 0x0FFF ) ), (u8)( i + Sum ) );
+            Elapsed = GetSeconds() - Start;
+        }
+    Result->WriteTime = Elapsed * 1e9 / (double)Count;
+
+    for( Count = 0, Start = GetSeconds(), Elapsed = 0.0; Valid && Elapsed < BENCH_MIN_SECONDS;
+         Count += BENCH_RUN_FRAMES )
+        {
+            Valid   = RunInstance( GetCurrentInstance(), BENCH_RUN_FRAMES );
+            Elapsed = GetSeconds() - Start;
+        }
+    Result->RunRate = (double)Count / Elapsed;
+
+    return Valid;
+}
+
+// Runs compression and decompression of `Data` back to back until each took BENCH_MIN_SECONDS
+static bool
+MeasureCodec( const u8 * Data, size_t Size, u32 Threads, BenchResult * Result )
+{
+    const size_t Bound    = GetCompressBound( Size );
+    u8 *         Packed   = (u8 *)malloc( Bound );
+    u8 *         Unpacked = (u8 *)malloc( Size );
+    bool         Valid    = ( NULL != Packed && NULL != Unpacked );
+    double       Start;
+    double       Elapsed;
+    u32          Runs;
+
+    for( Runs = 0, Start = GetSeconds(), Elapsed = 0.0; Valid && Elapsed < BENCH_MIN_SECONDS; ++Runs )
+        {
+            Result->PackedSize = CompressData( Data, Size, Packed, Bound, Threads );
+            Valid              = ( 0 != Result->PackedSize );
+            Elapsed            = GetSeconds() - Start;
+        }
+    Result->CompressRate = (double)Size * Runs / Elapsed / 1e6;
+
+    for( Runs = 0, Start = GetSeconds(), Elapsed = 0.0; Valid && Elapsed < BENCH_MIN_SECONDS; ++Runs )
+        {
+            Valid   = ( Size == DecompressData( Packed, Result->PackedSize, Unpacked, Size, Threads ) );
+            Elapsed = GetSeconds() - Start;
+        }
+    Result->DecompressRate = (double)Size * Runs / Elapsed / 1e6;
+
+    Valid = Valid && ( 0 == memcmp( Data, Unpacked, Size ) );
+
+    free( Packed );
+    free( Unpacked );
+    return Valid;
+}
+
+int
+RunCodecBenchmark( const char * StatePath )
+{
+    static const struct
+    {
+        const char * Name;
+        u32          Threads;
+    } Modes[] = {
+        { "1 thread", 1 },
+        { "all cores", 0 },
+    };
+
+    size_t FileSize;
+    size_t StateSize;
+    u8 *   File = LoadFileData( StatePath, &FileSize );
+    u8 *   State;
+
+    if( NULL == File )
+        {
+            fprintf( stderr, "Error: Could not read the state file '%s'.\n", StatePath );
+            return EXIT_FAILURE;
+        }
+
+    // State files are stored compressed; measure on the raw dump
+    StateSize = GetDecompressedSize( File, FileSize );
+    if( 0 != StateSize )
+        {
+            State = (u8 *)malloc( StateSize );
+            if( NULL == State || StateSize != DecompressData( File, FileSize, State, StateSize, 1 ) )
+                {
+                    fprintf( stderr, "Error: The state file '%s' is corrupted.\n", StatePath );
+                    free( State );
+                    free( File );
+                    return EXIT_FAILURE;
+                }
+            free( File );
+        }
+    else
+        {
+            State     = File;
+            StateSize = FileSize;
+        }
+
+    printf( "%s: %zu bytes\n", StatePath, StateSize );
+    for( size_t i = 0; i < sizeof( Modes ) / sizeof( Modes[0] ); ++i )
+        {
+            BenchResult Result = { 0 };
+
+            if( !MeasureCodec( State, StateSize, Modes[i].Threads, &Result ) )
+                {
+                    fprintf( stderr, "Error: Codec round trip failed (%s).\n", Modes[i].Name );
+                    free( State );
+                    return EXIT_FAILURE;
+                }
+
+            printf( "  %-9s  %zu bytes (%.2f%%)  compress %.0f MB/s  decompress %.0f MB/s\n", Modes[i].Name,
+                    Result.PackedSize, 100.0 * (double)Result.PackedSize / (double)StateSize, Result.CompressRate,
+                    Result.DecompressRate );
+        }
+
+    free( State );
+    return EXIT_SUCCESS;
+}
+
+int
+RunBusBenchmark( const char * CartridgePath )
+{
+    static const struct
+    {
+        const char * Name;
+        u16          Addr; // Watched byte (0: none)
+    } Modes[] = {
+        { "no watchpoints", 0 },
+        { "watch elsewhere", 0xD000 },
+        { "watch same page", 0xC0FF },
+        { "cleared", 0 },
+    };
+
+    Machine * Instance;
+    Machine * Previous;
+    int       Result = EXIT_SUCCESS;
+
+    if( !LoadCartridge( (char *)CartridgePath ) )
+        {
+            fprintf( stderr, "Error: Could not load the cartridge '%s'.\n", CartridgePath );
+            return EXIT_FAILURE;
+        }
+
+    // Measure on a fork run by this thread; the CPU thread stays paused on the original
+    InitEmulator();
+    PauseEmulator();
+    Instance = ForkInstance( NULL );
+    if( NULL == Instance )
+        {
+            fprintf( stderr, "Error: Could not fork the machine.\n" );
+            StopEmulator();
+            return EXIT_FAILURE;
+        }
+    Previous = SetCurrentInstance( Instance );
+
+    printf( "%s\n", CartridgePath );
+    for( size_t i = 0; i < sizeof( Modes ) / sizeof( Modes[0] ); ++i )
+        {
+            BusResult Bus = { 0 };
+            i32       Id  = -1;
+
+            if( 0 != Modes[i].Addr )
+                {
+                    Id = AddWatchpoint( Modes[i].Addr, 1, WATCH_READ | WATCH_WRITE | WATCH_EXECUTE, CountWatchHit );
+                }
+
+            if( !MeasureBus( &Bus ) )
+                {
+                    fprintf( stderr, "Error: The CPU stopped (%s).\n", Modes[i].Name );
+                    Result = EXIT_FAILURE;
+                    break;
+                }
+
+            printf( "  %-15s  read %.2f ns  write %.2f ns  run %.0f frames/s\n", Modes[i].Name, Bus.ReadTime,
+                    Bus.WriteTime, Bus.RunRate );
+
+            if( 0 <= Id ) ClearWatchpoints();
+        }
+
+    SetCurrentInstance( Previous );
+    DestroyInstance( Instance );
+    StopEmulator();
+    return Result;
+}
@@ -0,0 +1,10 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Measures the state codec on a save state dump; returns a process exit code
+int RunCodecBenchmark( const char * StatePath );
+
+// Measures bus reads, writes and instruction fetches with and without watchpoints; returns a process exit code
+int RunBusBenchmark( const char * CartridgePath );
+
+#endif // BENCH_H
@@ -6,6 +6,8 @@
 #    include <emscripten.h>
 #endif
 
+#define REWIND_FRAMES_PER_UPDATE 2 // Frames stepped back per loop iteration while rewinding
+
 static int Running = 1;
 
 // This function implements one iteration of the emulator loop.
@@ -18,6 +20,9 @@ EmulatorLoop( void )
             if( Event.type == SDL_QUIT ) Running = 0;
         }
 
+    // Hold Backspace to rewind
+    if( SDL_GetKeyboardState( NULL )[SDL_SCANCODE_BACKSPACE] ) RewindEmulator( REWIND_FRAMES_PER_UPDATE );
+
     if( !StepEmulator() ) Running = 0;
 
     SDLWindowUpdate();
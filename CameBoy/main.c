@@ -2,10 +2,15 @@
 #include <stdlib.h>
 #include "argparse.h"
 
+#include "bench.h"
 #include "camecore/camecore.h"
 #include "emulator.h"
 #include "sdl_window.h"
 
+#define REWIND_INTERVAL    4                      // Frames between rewind snapshots
+#define REWIND_BUFFER_SIZE ( 64 * 1024 * 1024 ) // Bytes of rewind history
+#define WARM_CACHE_DIR     ".camecore-cache"     // Default warm-start cache directory
+
 static const char * const Usages[] = {
     "CameBoy [options]",
     NULL,
@@ -15,12 +20,22 @@ int
 main( int argc, char * argv[] )
 {
     char * CartridgePath       = NULL;
+    char * BenchStatePath      = NULL;
+    char * BenchBusPath        = NULL;
+    char * WarmCacheDir        = WARM_CACHE_DIR;
+    char * WarmScriptPath      = NULL;
+    int          WarmFrames          = 0;
     int          Debug               = 0;
 
     struct argparse_option Options[] = {
         OPT_HELP(),
         OPT_BOOLEAN( 'd', "debug", &Debug, "Enable debug logging", NULL, 0, 0 ),
         OPT_STRING( 'c', "cartridge", &CartridgePath, "Path to the cartridge file", NULL, 0, 0 ),
+        OPT_STRING( 'b', "bench", &BenchStatePath, "Benchmark the state codec on a save state file", NULL, 0, 0 ),
+        OPT_STRING( 0, "bench-bus", &BenchBusPath, "Benchmark the bus and watchpoints on a ROM", NULL, 0, 0 ),
+        OPT_INTEGER( 'w', "warm-start", &WarmFrames, "Start N frames in, from a cached state if any", NULL, 0, 0 ),
+        OPT_STRING( 0, "warm-cache", &WarmCacheDir, "Directory of the warm-start cache", NULL, 0, 0 ),
+        OPT_STRING( 0, "warm-script", &WarmScriptPath, "Only hashed into the cache key, never replayed", NULL, 0, 0 ),
         OPT_END(),
     };
 
@@ -33,6 +48,10 @@ main( int argc, char * argv[] )
     // Set debug
     SetLogLevel( ( Debug ) ? LOG_DEBUG : LOG_INFO );
 
+    // Benchmark and exit; no window needed
+    if( BenchStatePath ) return RunCodecBenchmark( BenchStatePath );
+    if( BenchBusPath ) return RunBusBenchmark( BenchBusPath );
+
     if( !CartridgePath )
         {
             fprintf( stderr,
@@ -42,6 +61,21 @@ main( int argc, char * argv[] )
 
     // Setup the emulator
     LoadCartridge( CartridgePath );
+    if( WarmFrames > 0 )
+        {
+            size_t ScriptSize = 0;
+            u8 *   Script     = ( WarmScriptPath ) ? LoadFileData( WarmScriptPath, &ScriptSize ) : NULL;
+
+            if( WarmScriptPath && !Script )
+                {
+                    fprintf( stderr, "Error: Could not read the input script '%s'.\n", WarmScriptPath );
+                    return EXIT_FAILURE;
+                }
+
+            SetWarmStart( WarmCacheDir, (u32)WarmFrames, Script, ScriptSize );
+            free( Script );
+        }
+    EnableRewind( REWIND_INTERVAL, REWIND_BUFFER_SIZE );
     InitEmulator();
 
     // Initialize window
@@ -57,7 +91,10 @@ main( int argc, char * argv[] )
     // Cleanup resources
     DestroySDLWindow();
 
-    //StopEmulator();
+    // Stop the CPU thread before the cartridge (and its save RAM) goes away
+    StopEmulator();
+    DisableRewind();
+    UnloadCartridge();
 
     return EXIT_SUCCESS;
 }
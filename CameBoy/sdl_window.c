@@ -1,9 +1,14 @@
 #include "sdl_window.h"
+#include "camecore/camecore.h"
 #include <SDL.h>
 #include <stdio.h>
 
 static SDL_Window *   Window   = NULL;
 static SDL_Renderer * Renderer = NULL;
+static SDL_Texture *  Screen   = NULL;
+
+// DMG shades, lightest first
+static const Uint32 ShadeColors[4] = { 0xFFE0F8D0, 0xFF88C070, 0xFF346856, 0xFF081820 };
 
 bool
 InitSDLWindow( const char * Title, int Width, int Height )
@@ -31,12 +36,24 @@ InitSDLWindow( const char * Title, int Width, int Height )
             return false;
         }
 
+    Screen = SDL_CreateTexture( Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH,
+                                SCREEN_HEIGHT );
+    if( !Screen )
+        {
+            fprintf( stderr, "SDL_CreateTexture Error: %s\n", SDL_GetError() );
+            SDL_DestroyRenderer( Renderer );
+            SDL_DestroyWindow( Window );
+            SDL_Quit();
+            return false;
+        }
+
     return true;
 }
 
 void
 DestroySDLWindow( void )
 {
+    if( Screen ) SDL_DestroyTexture( Screen );
     if( Renderer ) SDL_DestroyRenderer( Renderer );
     if( Window ) SDL_DestroyWindow( Window );
     SDL_Quit();
@@ -48,7 +65,26 @@ SDLWindowUpdate( void )
     SDL_SetRenderDrawColor( Renderer, 0, 0, 0, 255 );
     SDL_RenderClear( Renderer );
 
-    /** TODO: Frame Rendering */
+    // Upload the emulated frame only when a new one is complete; otherwise the last one is shown again
+    if( IsFrameReady() )
+        {
+            const u8 * Frame = GetFrameBuffer();
+            void *     Pixels;
+            int        Pitch;
+
+            if( Frame && 0 == SDL_LockTexture( Screen, NULL, &Pixels, &Pitch ) )
+                {
+                    for( int y = 0; y < SCREEN_HEIGHT; ++y )
+                        {
+                            const u8 * Shades = Frame + y * SCREEN_WIDTH;
+                            Uint32 *   Row    = (Uint32 *)( (Uint8 *)Pixels + y * Pitch );
+
+                            for( int x = 0; x < SCREEN_WIDTH; ++x ) Row[x] = ShadeColors[Shades[x] & 3];
+                        }
+                    SDL_UnlockTexture( Screen );
+                }
+        }
 
+    SDL_RenderCopy( Renderer, Screen, NULL, NULL );
     SDL_RenderPresent( Renderer );
 }
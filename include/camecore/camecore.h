@@ -226,6 +226,13 @@ typedef uint64_t u64;
 
 #define IE_REGISTER               0xFFFF /**< Address of the Interrupt Enable Register */
 
+// Screen
+#define SCREEN_WIDTH              160 /**< LCD width in pixels */
+#define SCREEN_HEIGHT             144 /**< LCD height in pixels */
+
+// Timing
+#define FRAME_TICKS               70224 /**< T-cycles per video frame (154 lines of 456 dots) */
+
 //----------------------------------------------------------------------------------------------------------------------
 // Enumerators Definition
 //----------------------------------------------------------------------------------------------------------------------
@@ -241,6 +248,14 @@ typedef enum
     LOG_NONE     // Disable logging
 } TraceLogLevel;
 
+// Memory watchpoint access kinds (combinable flags)
+typedef enum
+{
+    WATCH_READ    = 0x01, // Data read from the watched range
+    WATCH_WRITE   = 0x02, // Data written to the watched range
+    WATCH_EXECUTE = 0x04  // Opcode fetched from the watched range
+} WatchKind;
+
 // Addressing modes
 typedef enum
 {
@@ -466,11 +481,54 @@ typedef struct CPUContext
 
 } CPUContext;
 
+/**
+ * @brief 128-bit ROM content identity
+ *
+ * Stable across runs and platforms; computed once when a ROM is loaded.
+ */
+typedef struct RomHash
+{
+    u64 lo;
+    u64 hi;
+} RomHash;
+
+/**
+ * @brief ROM library index record
+ *
+ * One cartridge found by `ScanRomLibrary`, decoded from its 0100-014F header only.
+ * Records are fixed-size and stored as-is in the index file, which is mapped on load.
+ */
+typedef struct RomLibraryEntry
+{
+    u64  mtime_ns;        /**< File modification time (ns since the epoch), used to invalidate the record */
+    u64  file_size;       /**< File size in bytes, used to invalidate the record */
+    u64  header_hash;     /**< Hash of the 0100-014F header block, seeded with the file size */
+    u32  path_offset;     /**< Offset of the null-terminated path (see GetRomLibraryPath) */
+    u16  global_checksum; /**< 014E-014F: Global checksum as stored in the header */
+    u8   type;            /**< 0147: Cartridge type */
+    u8   rom_size;        /**< 0148: ROM size code */
+    u8   ram_size;        /**< 0149: RAM size code */
+    u8   cgb_flag;        /**< 0143: CGB flag */
+    u8   sgb_flag;        /**< 0146: SGB flag */
+    u8   header_checksum; /**< 014D: Header checksum */
+    u8   header_valid;    /**< 1 when the header checksum matches the 0134-014C bytes (u8: stable layout) */
+    char title[16];       /**< Null-terminated title */
+    u8   reserved[11];    /**< Pads the record to 64 bytes */
+} RomLibraryEntry;
+
+typedef struct RomLibrary RomLibrary; // Loaded (mapped) library index
+
+typedef struct Machine Machine; // Emulated machine state; one per instance (see machine.h)
+
+typedef struct CodecStream CodecStream; // Streaming compressor or decompressor (see OpenCodecStream)
+
 //----------------------------------------------------------------------------------------------------------------------
 // Functions callbacks
 //----------------------------------------------------------------------------------------------------------------------
 typedef void ( *CPUInstructionProc )( CPUContext * /* ctx */ );
 typedef void ( *TraceLogCallback )( int logLevel, const char * text, va_list args ); // Custom trace log
+typedef void ( *WatchpointCallback )( u16 addr, u8 value, WatchKind kind );         // Watchpoint hit
+typedef bool ( *CodecWriteCallback )( const u8 * data, size_t size, void * user ); // Codec stream output
 
 //----------------------------------------------------------------------------------------------------------------------
 // Functions Declaration
@@ -488,6 +546,7 @@ CCAPI EmuContext * GetEmulatorContext( void );
 CCAPI void         PauseEmulator( void );
 CCAPI void         ResumeEmulator( void );
 CCAPI void         StopEmulator( void );
+CCAPI void         ResetEmulator( void ); // Back to the state after InitEmulator(); cartridge RAM and clock are kept
 
 // CPU
 //------------------------------------------------------------------
@@ -508,32 +567,113 @@ CCAPI void WriteBus( u16 addr, u8 value );
 CCAPI void WriteBusWord( u16 address, u16 value );
 CCAPI u16  ReadBusWord( u16 address );
 
+CCAPI void       TrackDirtyPages( bool enable );
+CCAPI void       ClearDirtyPages( void );
+CCAPI const u8 * GetDirtyPages( void ); // One bit per 256-byte bus page (banks switched out are not tracked)
+
 // RAM
 //------------------------------------------------------------------
 CCAPI u8   ReadWRAM( u16 addr );
 CCAPI void WriteWRAM( u16 addr, u8 value );
 
+CCAPI u8   ReadEcho( u16 addr );
+CCAPI void WriteEcho( u16 addr, u8 value );
+
+CCAPI u8   ReadVRAM( u16 addr );
+CCAPI void WriteVRAM( u16 addr, u8 value );
+
+CCAPI u8   ReadOAM( u16 addr );
+CCAPI void WriteOAM( u16 addr, u8 value );
+
 CCAPI u8   ReadHRAM( u16 addr );
 CCAPI void WriteHRAM( u16 addr, u8 value );
 
+// PPU
+//------------------------------------------------------------------
+CCAPI const u8 * GetFrameBuffer( void ); // SCREEN_WIDTH x SCREEN_HEIGHT shades (0: lightest); valid until the next call
+CCAPI bool       IsFrameReady( void );   // A frame completed since the last GetFrameBuffer()
+
 // Cart
 //------------------------------------------------------------------
-CCAPI bool LoadCartridge( char * cart );
-CCAPI u8   ReadCartridge( u16 address );
-CCAPI void WriteCartridge( u16 address, u8 value );
+CCAPI bool    LoadCartridge( char * cart );
+CCAPI void    UnloadCartridge( void );
+CCAPI bool    SaveCartridgeRAM( void );               // Persist battery-backed RAM now (blocking)
+CCAPI RomHash GetCartridgeHash( void );               // Content identity of the loaded ROM
+CCAPI bool    IsCartridgeHeaderValid( void );         // Header checksum (014D) matches
+CCAPI bool    IsCartridgeGlobalChecksumValid( void ); // Global checksum (014E-014F) matches
+CCAPI bool    IsCartridgeCGB( void );                 // ROM runs in CGB mode (0143 bit 7)
+CCAPI u8      ReadCartridge( u16 address );
+CCAPI void    WriteCartridge( u16 address, u8 value );
+
+// State
+//------------------------------------------------------------------
+CCAPI size_t GetStateSize( void );                                // Bytes a save state of the machine takes
+CCAPI size_t SaveStateToMemory( u8 * buffer, size_t capacity );   // Returns the bytes written, 0 on failure
+CCAPI bool   LoadStateFromMemory( const u8 * data, size_t size ); // Rejects states taken on another ROM
+CCAPI bool   SaveState( const char * filename );
+CCAPI bool   LoadState( const char * filename );
+
+// InitEmulator() then starts `frames` frames after power on, from a state cached in `cacheDirectory` when one matches
+CCAPI bool SetWarmStart( const char * cacheDirectory, u32 frames, const u8 * inputScript, size_t scriptSize );
+
+CCAPI bool EnableRewind( u32 interval, size_t bufferSize ); // Snapshot every `interval` frames into a ring
+CCAPI void DisableRewind( void );
+CCAPI u32  RewindEmulator( u32 frames ); // Step back at least `frames` frames; returns the frames rewound
+
+// Instances
+//------------------------------------------------------------------
+CCAPI Machine * ForkInstance( const Machine * src );           // Copy-on-write clone (NULL: this thread's machine)
+CCAPI void      DestroyInstance( Machine * instance );
+CCAPI Machine * GetCurrentInstance( void );
+CCAPI Machine * SetCurrentInstance( Machine * instance );      // Machine the calling thread runs; returns the last
+CCAPI bool      RunInstance( Machine * instance, u32 frames ); // Run on the calling thread; false once the CPU stops
+
+// Codec
+//------------------------------------------------------------------
+CCAPI size_t GetCompressBound( size_t size );                     // Output capacity CompressData() needs
+CCAPI size_t GetDecompressedSize( const u8 * data, size_t size ); // 0 if `data` is not a complete frame
+CCAPI size_t CompressData( const u8 * data, size_t size, u8 * out, size_t capacity, u32 threads ); // 0: all cores
+CCAPI size_t DecompressData( const u8 * data, size_t size, u8 * out, size_t capacity, u32 threads );
+
+CCAPI CodecStream * OpenCodecStream( bool compress, CodecWriteCallback write, void * user );
+CCAPI bool          WriteCodecStream( CodecStream * stream, const u8 * data, size_t size );
+CCAPI bool          CloseCodecStream( CodecStream * stream ); // Flushes, then frees; false if anything failed
+
+// ROM Library
+//------------------------------------------------------------------
+CCAPI bool                    ScanRomLibrary( const char * directory, const char * indexPath );
+CCAPI RomLibrary *            LoadRomLibrary( const char * indexPath );
+CCAPI void                    UnloadRomLibrary( RomLibrary * library );
+CCAPI u32                     GetRomLibraryCount( const RomLibrary * library );
+CCAPI const RomLibraryEntry * GetRomLibraryEntry( const RomLibrary * library, u32 index );
+CCAPI const char *            GetRomLibraryPath( const RomLibrary * library, const RomLibraryEntry * entry );
 
 // IO
 //------------------------------------------------------------------
 CCAPI u8   ReadIO( u16 addr );
 CCAPI void WriteIO( u16 addr, u8 value );
 
+// Watchpoints
+//------------------------------------------------------------------
+CCAPI i32  AddWatchpoint( u16 addr, u16 len, WatchKind kind, WatchpointCallback callback );
+CCAPI bool RemoveWatchpoint( i32 id );
+CCAPI void ClearWatchpoints( void );
+
 // Utils
 //------------------------------------------------------------------
 CCAPI void TraceLog( i32 logLevel, const char * text, ... );
+CCAPI void TraceLogLimited( i32 logLevel, u32 count, const char * text, ... ); // Used by LOG_LIMITED
 CCAPI void SetLogLevel( i32 logLevel );
+CCAPI bool SetTraceLogAsync( bool enabled ); // Log through a background writer; returns whether it is active
+CCAPI void FlushTraceLog( void );            // Wait for queued log records to be written
 
 CCAPI u8 * LoadFileData( const char * filename, size_t * outBytesRead );
 CCAPI bool SaveFileData( const char * filename, const u8 * data, size_t dataSize );
+CCAPI u8 * MapFileData( const char * filename, size_t * outSize ); // Read-only shared pages, NULL if unsupported
+CCAPI void UnmapFileData( u8 * data, size_t size );
+CCAPI u8 * MapFileShared( const char * filename, size_t size, u8 * address ); // Writable, NULL if unsupported
+CCAPI bool SyncMappedFile( u8 * data, size_t size, bool wait );
+CCAPI void SleepMilliseconds( u32 ms );
 
 CCAPI void SetTraceLogCallback( TraceLogCallback callback ); // Set custom trace log
 
@@ -0,0 +1,257 @@
+/****************************** CameCore *********************************
+ *
+ * Module: Machine
+ *
+ * Layout of the emulated machine state. Every mutable piece of guest state lives in one
+ * `Machine` arena, so that snapshots, restores and instance clones are a single copy.
+ *
+ * Key Features:
+ * - Hot fields first: CPU registers, cycle counter, PPU deadline and the bus page table share the first lines
+ * - I/O registers, MBC/RTC registers, WRAM/VRAM/OAM/HRAM follow, then the decoded tiles and frame buffers
+ * - Cartridge RAM last, page aligned, so battery RAM can be mapped in place from the `.sav` file
+ * - Host pointers inside the arena are rebased when it is copied to another address
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *      wrote the original software. If you use this software in a product, an acknowledgment
+ *      in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#ifndef CAMECORE_MACHINE_H
+#define CAMECORE_MACHINE_H
+
+#include "camecore/camecore.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------------------------------------------------------
+// Arena
+#define MACHINE_PAGE_SIZE  0x1000  /**< Host page size the cartridge RAM is aligned to */
+#define CART_RAM_MAX_SIZE  0x20000 /**< Largest cartridge RAM (MBC5, 16 banks of 8 KiB) */
+#define CART_RAM_TAIL_SIZE 0x1000  /**< Room after cartridge RAM for the `.sav` clock footer */
+
+// Bus
+#define BUS_PAGE_SHIFT     8                              /**< Page granularity (256 bytes) */
+#define BUS_PAGE_SIZE      ( 1U << BUS_PAGE_SHIFT )       /**< Bytes covered by one page */
+#define BUS_PAGE_COUNT     ( 0x10000U >> BUS_PAGE_SHIFT ) /**< Pages covering the whole address space */
+#define BUS_TRAP_CLEAN     0x80                           /**< Trap: page not written since the last clear */
+
+// RAM
+#define OAM_PAGE_SIZE      0x100  /**< OAM followed by the unusable range (0xFE00-0xFEFF) */
+#define WRAM_BANK_SIZE     0x1000 /**< Size of one WRAM bank (4 KiB) */
+#define WRAM_BANKS         8      /**< WRAM banks on CGB (DMG only uses 0 and 1) */
+#define VRAM_BANKS         2      /**< VRAM banks on CGB (DMG only uses 0) */
+
+// PPU
+#define TILE_COUNT         384 /**< Tiles in the VRAM tile data (8000-97FF) */
+#define TILE_SIZE          8   /**< Tile width and height in pixels */
+#define TILE_BYTES         16  /**< Bytes per 2bpp tile */
+#define FRAME_BUFFERS      3   /**< Drawn, latest completed, held by the reader */
+
+// LCD registers (I/O addresses shared by the I/O map and the PPU)
+#define LCDC_ADDR          0xFF40 /**< LCD control */
+#define STAT_ADDR          0xFF41 /**< LCD status */
+#define SCY_ADDR           0xFF42 /**< Viewport Y position */
+#define SCX_ADDR           0xFF43 /**< Viewport X position */
+#define LY_ADDR            0xFF44 /**< LCD Y coordinate */
+#define LYC_ADDR           0xFF45 /**< LY compare */
+#define DMA_ADDR           0xFF46 /**< OAM DMA source address & start */
+#define BGP_ADDR           0xFF47 /**< BG palette data (DMG only) */
+#define OBP0_ADDR          0xFF48 /**< OBJ palette 0 data (DMG only) */
+#define OBP1_ADDR          0xFF49 /**< OBJ palette 1 data (DMG only) */
+#define WY_ADDR            0xFF4A /**< Window Y position */
+#define WX_ADDR            0xFF4B /**< Window X position plus 7 */
+
+// Cartridge
+#define RTC_REG_COUNT      5 /**< MBC3 clock registers (S, M, H, DL, DH) */
+
+// Watchpoints
+#define MAX_WATCHPOINTS    64              /**< Simultaneous watchpoints */
+#define WATCH_KIND_COUNT   3               /**< Read, write and execute */
+#define WATCH_BITMAP_SIZE  ( 0x10000U / 8 ) /**< One bit per address */
+
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+typedef u8 ( *IOReadHandler )( u16 addr );
+typedef void ( *IOWriteHandler )( u16 addr, u8 value );
+
+// Memory bank controller family
+typedef enum
+{
+    MBC_NONE = 0, // ROM only (optionally with a single RAM bank)
+    MBC_1,
+    MBC_3,
+    MBC_5,
+} MBCType;
+
+// Host view of the directly mapped region containing PC, cached by the opcode fetch
+typedef struct FetchRegion
+{
+    const u8 * base;  /**< Host pointer backing `start` */
+    u32        size;  /**< Bytes covered by the region (0: no cached region) */
+    u16        start; /**< First guest address of the region */
+} FetchRegion;
+
+// Bus page table
+typedef struct BusContext
+{
+    FetchRegion fetch;                 /**< Dropped whenever a page mapping or trap changes */
+    u8 * read_map[BUS_PAGE_COUNT];     /**< Direct read pointer per page (NULL: handler or trapped) */
+    u8 * write_map[BUS_PAGE_COUNT];    /**< Direct write pointer per page (NULL: handler or trapped) */
+    u8 * read_direct[BUS_PAGE_COUNT];  /**< Host memory backing each page for reads (NULL: handler) */
+    u8 * write_direct[BUS_PAGE_COUNT]; /**< Host memory backing each page for writes (NULL: handler) */
+    u8   trap[BUS_PAGE_COUNT];         /**< `WatchKind` flags and BUS_TRAP_CLEAN trapped on each page */
+    u8   dirty[BUS_PAGE_COUNT / 8];    /**< Pages written or remapped since the last clear, one bit each */
+    bool track_dirty;                  /**< Clean pages are trapped to catch their first write */
+} BusContext;
+
+/**
+ * @brief IO register table entry
+ *
+ * A register with no handlers is plain storage: reads return the backing byte with the
+ * unreadable bits forced to 1, and writes only update the writable bits.
+ */
+typedef struct IORegister
+{
+    IOReadHandler  read;       /**< Read side effect handler (NULL: plain storage) */
+    IOWriteHandler write;      /**< Write side effect handler (NULL: plain storage) */
+    u8             read_mask;  /**< Readable bits; the others read back as 1 */
+    u8             write_mask; /**< Bits the CPU is allowed to change */
+    u8             value;      /**< Backing byte */
+} IORegister;
+
+typedef struct IOContext
+{
+    IORegister regs[IO_SIZE];
+} IOContext;
+
+typedef struct RAMContext
+{
+    u8 wram[WRAM_BANKS][WRAM_BANK_SIZE]; // Bank 0 at C000-CFFF, `wram_bank` at D000-DFFF
+    u8 vram[VRAM_BANKS][VRAM_SIZE];      // `vram_bank` at 8000-9FFF
+    u8 oam[OAM_PAGE_SIZE];               // Tail past OAM_SIZE is never written and reads as UNUSABLE_VALUE
+    u8 hram[HRAM_SIZE];
+    u8 wram_bank;                        // Bank mapped at D000-DFFF (1-7)
+    u8 vram_bank;                        // Bank mapped at 8000-9FFF (0-1)
+} RAMContext;
+
+// PPU timing and tile cache bookkeeping; the mode and LY live in STAT and LY
+typedef struct PPUState
+{
+    u64  deadline;                   // Tick of the next mode change (UINT64_MAX: LCD off)
+    u8   window_line;                // Window row drawn by the next line that shows the window
+    u8   back;                       // Frame buffer being drawn
+    u8   front;                      // Frame buffer handed out by GetFrameBuffer() (reader thread)
+    u32  latest;                     // Last completed frame buffer, flagged until a reader takes it (atomic)
+    u8   tile_dirty[TILE_COUNT / 8]; // Tiles written since they were decoded, one bit each
+} PPUState;
+
+// Pixels derived from VRAM and the LCD registers: rebuilt by the PPU, never saved
+typedef struct VideoContext
+{
+    u8 tiles[TILE_COUNT][TILE_SIZE][TILE_SIZE];  // Decoded VRAM bank 0 tiles: one color index (0-3) per pixel
+    u8 frames[FRAME_BUFFERS][SCREEN_HEIGHT][SCREEN_WIDTH]; // Shades (0-3), swapped through `PPUState.latest`
+} VideoContext;
+
+// Memory bank controller registers
+typedef struct MBCState
+{
+    MBCType type;        // Controller family
+    u16     rom_mask;    // ROM bank count - 1 (power of two)
+    u16     rom_bank;    // Selected switchable ROM bank register (MBC1: low 5 bits)
+    u8      bank_hi;     // MBC1: upper bank bits; MBC3/MBC5: RAM bank register
+    u8      mode;        // MBC1 banking mode (0: simple, 1: advanced)
+    bool    ram_enabled; // External RAM access enabled
+    u32     rom0_offset; // ROM offset mapped at 0000-3FFF
+    u32     romx_offset; // ROM offset mapped at 4000-7FFF
+    i32     ram_offset;  // RAM offset mapped at A000-BFFF (-1: unmapped)
+} MBCState;
+
+// MBC3 real-time clock
+// NOTE: Only `seconds` at host time `base` is kept; registers are derived when latched
+typedef struct ClockState
+{
+    bool present;                // Cartridge has a clock (MBC3+TIMER)
+    bool halted;                 // DH halt flag; `seconds` is frozen while set
+    bool carry;                  // DH day carry flag
+    u8   latch;                  // Last value written to 6000-7FFF (00 -> 01 latches)
+    u8   latched[RTC_REG_COUNT]; // Registers as seen by the game (S, M, H, DL, DH)
+    u64  seconds;                // Clock value at `base`, below the 512-day wrap
+    i64  base;                   // Host unix time at which `seconds` was current
+} ClockState;
+
+// Cartridge registers; the ROM image and file information stay outside the arena
+typedef struct CartState
+{
+    MBCState   mbc;
+    ClockState rtc;
+} CartState;
+
+// One watched address range
+typedef struct Watchpoint
+{
+    WatchpointCallback callback; /**< Hit callback (NULL: free slot) */
+    u32                start;    /**< First watched address */
+    u32                end;      /**< One past the last watched address */
+    WatchKind          kind;     /**< Watched access kinds */
+} Watchpoint;
+
+// Watchpoints trapped by a machine: its own copy of the shared list, swapped in by the thread running it
+typedef struct WatchState
+{
+    u32        serial;                                      // Edit of the shared list this copy reflects
+    Watchpoint points[MAX_WATCHPOINTS];
+    u8         bitmap[WATCH_KIND_COUNT][WATCH_BITMAP_SIZE]; // Watched bytes, one map per kind
+} WatchState;
+
+/**
+ * @brief Emulated machine state arena
+ *
+ * Allocated once, cache-line (and page) aligned. The first lines hold what every instruction
+ * touches; bulk memory follows. Copying the whole struct captures the machine completely.
+ *
+ * @note The bus page table points into the arena (RAM) and into the shared ROM image;
+ *       use CopyMachine() rather than memcpy() when the destination is another arena.
+ */
+struct Machine
+{
+    // Hot: every instruction
+    CPUContext cpu;   /**< Registers, decode state, interrupt state */
+    u64        ticks; /**< T-cycles executed since power on */
+    PPUState   ppu;   /**< LCD timing (deadline checked every cycle) */
+    BusContext bus;   /**< Fetch window and page table (read/write maps first) */
+
+    // Registers
+    IOContext io;
+    CartState cart;
+
+    // Memory
+    RAMContext   ram;
+    VideoContext video;
+
+    // Debugging
+    WatchState watch;
+
+    // External RAM, then the clock footer; page aligned so the `.sav` file can be mapped over it
+    u8 cart_ram[CART_RAM_MAX_SIZE + CART_RAM_TAIL_SIZE] ALIGNED( MACHINE_PAGE_SIZE );
+};
+
+#endif // !CAMECORE_MACHINE_H
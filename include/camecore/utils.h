@@ -8,6 +8,7 @@
  * Key Features:
  * - SetLogLevel: Configures the minimum log level for message display.
  * - TraceLog: Logs messages based on the specified log level.
+ * - LOG_LIMITED: Rate-limited logging for hot paths, keyed by call site plus argument.
  * - LoadFileData: Loads a binary file into memory, returning the data and its size.
  * - SaveFileData: Saves binary data to a specified file.
  *
@@ -52,17 +53,57 @@
 //----------------------------------------------------------------------------------------------------------------------
 // Logging Macros
 //----------------------------------------------------------------------------------------------------------------------
+// Rate limiting: each key prints LOG_LIMIT_BURST times, then one summary every LOG_LIMIT_PERIOD occurrences
+#define LOG_LIMIT_BURST  8       /**< Messages printed per key before suppression */
+#define LOG_LIMIT_PERIOD 0x10000 /**< Suppressed occurrences between two summaries (power of two) */
+#define LOG_LIMIT_SLOTS  256     /**< Keys tracked per call site (keys are folded by their low bits) */
+
+// Compile-time threshold: calls below CC_MIN_LOG_LEVEL fold away without evaluating their arguments.
+// Accepts a number or one of the CC_LOG_LEVEL_* names below; LOG_FATAL is never compiled out.
+#define CC_LOG_LEVEL_LOG_ALL     0
+#define CC_LOG_LEVEL_LOG_TRACE   1
+#define CC_LOG_LEVEL_LOG_DEBUG   2
+#define CC_LOG_LEVEL_LOG_INFO    3
+#define CC_LOG_LEVEL_LOG_WARNING 4
+#define CC_LOG_LEVEL_LOG_ERROR   5
+#define CC_LOG_LEVEL_LOG_FATAL   6
+#define CC_LOG_LEVEL_LOG_NONE    7
+
+#ifndef CC_MIN_LOG_LEVEL
+#    define CC_MIN_LOG_LEVEL CC_LOG_LEVEL_LOG_ALL
+#endif
+
+// `level` must be a literal LOG_* enumerator
+#define LOG_LEVEL_ENABLED( level )                                                                                     \
+    ( CC_LOG_LEVEL_##level >= CC_MIN_LOG_LEVEL || CC_LOG_LEVEL_##level == CC_LOG_LEVEL_LOG_FATAL )
+
 #if defined( LOG_SUPPORT )
-#    define LOG( level, ... ) TraceLog( level, __VA_ARGS__ )
+#    define LOG( level, ... ) ( LOG_LEVEL_ENABLED( level ) ? TraceLog( level, __VA_ARGS__ ) : (void)0 )
+
+// Rate-limited log: the check before formatting is a single atomic increment of a per call site counter
+#    define LOG_LIMITED( level, key, ... )                                                                             \
+        do                                                                                                             \
+            {                                                                                                          \
+                static unsigned int log_limit_counts_[LOG_LIMIT_SLOTS];                                                \
+                if( !LOG_LEVEL_ENABLED( level ) ) break;                                                               \
+                const unsigned int log_limit_n_                                                                        \
+                    = ATOMIC_INC( &log_limit_counts_[(unsigned int)( key ) & ( LOG_LIMIT_SLOTS - 1 )] );             \
+                if( log_limit_n_ <= LOG_LIMIT_BURST || 0 == ( ( log_limit_n_ - LOG_LIMIT_BURST ) % LOG_LIMIT_PERIOD ) ) \
+                    {                                                                                                  \
+                        TraceLogLimited( level, log_limit_n_, __VA_ARGS__ );                                           \
+                    }                                                                                                  \
+            }                                                                                                          \
+        while( 0 )
 
 #    if defined( SUPPORT_LOG_DEBUG )
-#        define LOGD( ... ) TraceLog( LOG_DEBUG, __VA_ARGS__ )
+#        define LOGD( ... ) LOG( LOG_DEBUG, __VA_ARGS__ )
 #    else
 #        define LOGD( ... ) ( (void)0 )
 #    endif
 #else
-#    define LOG( level, ... ) ( (void)0 )
-#    define LOGD( ... )       ( (void)0 )
+#    define LOG( level, ... )              ( (void)0 )
+#    define LOG_LIMITED( level, key, ... ) ( (void)0 )
+#    define LOGD( ... )                    ( (void)0 )
 #endif
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -74,7 +115,9 @@
 #    if defined( __STDC_VERSION__ ) && ( __STDC_VERSION__ >= 201112L )
 #        define STATIC_ASSERT( cond, msg ) _Static_assert( cond, msg )
 #    else
-#        define STATIC_ASSERT( cond, msg ) typedef char static_assert_##__LINE__[( cond ) ? 1 : -1]
+#        define STATIC_ASSERT_NAME( line ) STATIC_ASSERT_PASTE( static_assert_, line )
+#        define STATIC_ASSERT_PASTE( a, b ) a##b // Second expansion step, so `__LINE__` becomes a number
+#        define STATIC_ASSERT( cond, msg )  typedef char STATIC_ASSERT_NAME( __LINE__ )[( cond ) ? 1 : -1]
 #    endif
 #endif
 
@@ -108,27 +151,63 @@
         WaitForSingleObject( handle, INFINITE );                                                                       \
         CloseHandle( handle )
 #    define THREAD_SLEEP( ms )     Sleep( ms )
+#    define THREAD_LOCAL           __declspec( thread )
 // Synchronization primitives
 #    define MUTEX_HANDLE           CRITICAL_SECTION
 #    define MUTEX_INIT( mutex )    InitializeCriticalSection( &mutex )
 #    define MUTEX_LOCK( mutex )    EnterCriticalSection( &mutex )
 #    define MUTEX_UNLOCK( mutex )  LeaveCriticalSection( &mutex )
 #    define MUTEX_DESTROY( mutex ) DeleteCriticalSection( &mutex )
+// Condition variables (waited on with a MUTEX_HANDLE)
+#    define COND_HANDLE              CONDITION_VARIABLE
+#    define COND_INIT( cond )        InitializeConditionVariable( &cond )
+#    define COND_WAIT( cond, mutex ) SleepConditionVariableCS( &cond, &mutex, INFINITE )
+#    define COND_SIGNAL( cond )      WakeConditionVariable( &cond )
+#    define COND_DESTROY( cond )     ( (void)0 )
+// Atomics
+#    define ATOMIC_INC( ptr )       ( (unsigned int)InterlockedIncrement( (volatile LONG *)( ptr ) ) )
+#    define ATOMIC_ADD( ptr, v )    ( (unsigned int)InterlockedExchangeAdd( (volatile LONG *)( ptr ), ( v ) ) + ( v ) )
+#    define ATOMIC_LOAD( ptr )      ( MemoryBarrier(), *( ptr ) )
+#    define ATOMIC_STORE( ptr, v )  ( *( ptr ) = ( v ), MemoryBarrier() )
+#    define ATOMIC_XCHG( ptr, v )   InterlockedExchangePointer( (PVOID volatile *)( ptr ), ( v ) )
+#    define ATOMIC_XCHG32( ptr, v ) ( (u32)InterlockedExchange( (volatile LONG *)( ptr ), (LONG)( v ) ) )
+#    define ATOMIC_FENCE()          MemoryBarrier()
+#    define SPIN_LOCK( lock )                                                                                          \
+        while( InterlockedExchange( (volatile LONG *)&( lock ), 1 ) ) SwitchToThread()
+#    define SPIN_UNLOCK( lock ) InterlockedExchange( (volatile LONG *)&( lock ), 0 )
 #else
 #    include <pthread.h>
+#    include <sched.h>
 #    include <unistd.h>
 #    define THREAD_HANDLE                      pthread_t
 #    define THREAD_RETURN                      void *
 #    define THREAD_PARAM                       void *
 #    define THREAD_CREATE( handle, func, arg ) pthread_create( &handle, NULL, func, arg )
 #    define THREAD_JOIN( handle )              pthread_join( handle, NULL )
-#    define THREAD_SLEEP( ms )                 sleep( ms * 1000 )
+#    define THREAD_SLEEP( ms )                 SleepMilliseconds( ms )
+#    define THREAD_LOCAL                       __thread __attribute__( ( tls_model( "initial-exec" ) ) ) // One load
 // Synchronization primitives
 #    define MUTEX_HANDLE                       pthread_mutex_t
 #    define MUTEX_INIT( mutex )                pthread_mutex_init( &mutex, NULL )
 #    define MUTEX_LOCK( mutex )                pthread_mutex_lock( &mutex )
 #    define MUTEX_UNLOCK( mutex )              pthread_mutex_unlock( &mutex )
 #    define MUTEX_DESTROY( mutex )             pthread_mutex_destroy( &mutex )
+// Condition variables (waited on with a MUTEX_HANDLE)
+#    define COND_HANDLE                        pthread_cond_t
+#    define COND_INIT( cond )                  pthread_cond_init( &cond, NULL )
+#    define COND_WAIT( cond, mutex )           pthread_cond_wait( &cond, &mutex )
+#    define COND_SIGNAL( cond )                pthread_cond_signal( &cond )
+#    define COND_DESTROY( cond )               pthread_cond_destroy( &cond )
+// Atomics
+#    define ATOMIC_INC( ptr )                  __atomic_add_fetch( ( ptr ), 1, __ATOMIC_RELAXED )
+#    define ATOMIC_ADD( ptr, v )               __atomic_add_fetch( ( ptr ), ( v ), __ATOMIC_SEQ_CST )
+#    define ATOMIC_LOAD( ptr )                 __atomic_load_n( ( ptr ), __ATOMIC_ACQUIRE )
+#    define ATOMIC_STORE( ptr, v )             __atomic_store_n( ( ptr ), ( v ), __ATOMIC_RELEASE )
+#    define ATOMIC_XCHG( ptr, v )              __atomic_exchange_n( ( ptr ), ( v ), __ATOMIC_ACQ_REL )
+#    define ATOMIC_XCHG32( ptr, v )            __atomic_exchange_n( ( ptr ), ( v ), __ATOMIC_ACQ_REL )
+#    define ATOMIC_FENCE()                     __atomic_thread_fence( __ATOMIC_SEQ_CST )
+#    define SPIN_LOCK( lock )                  while( __atomic_exchange_n( &( lock ), 1, __ATOMIC_ACQUIRE ) ) sched_yield()
+#    define SPIN_UNLOCK( lock )                __atomic_store_n( &( lock ), 0, __ATOMIC_RELEASE )
 #endif
 
 #endif // !CAMECORE_UTILS_H
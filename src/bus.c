@@ -9,6 +9,23 @@
  * - I/O Registers and High RAM (HRAM)
  * - Interrupt Enable Register (IE)
  *
+ * Every access is resolved through a 256-entry page table (256 bytes per page) holding direct host
+ * pointers for reads and writes. Plain memory (ROM, VRAM, WRAM, ...) is served by a single indexed load;
+ * pages left as NULL fall back to the region handlers (I/O, banking registers, HRAM, IE). Echo RAM pages
+ * alias the WRAM pages they mirror, so mirroring costs nothing on the hot path.
+ *
+ * Watchpoints swap the affected pages to NULL ("trapping") while keeping their real backing aside, so
+ * unwatched pages keep the direct path and an emulator without watchpoints pays nothing for them.
+ *
+ * Dirty tracking reuses the same trap: while enabled, pages not written since the last clear are trapped,
+ * and the first write to one sets its bit in the dirty bitmap and flips it back to its direct pointer. Each
+ * page costs at most one slow write per clear, however often it is written afterwards. Registers the core
+ * updates by itself (LY, STAT, IF, latched clock) mark their page through MarkBusRangeDirty().
+ *
+ * NOTE: The bitmap describes what the bus shows, not the memory behind it. A page remapped to other memory
+ * (bank switch) is reported dirty, but writes to a bank that is switched out by the next clear are not:
+ * consumers keeping banked memory must compare the banks themselves.
+ *
  * Memory Map Layout:
  *  16-bit address bus
  *
@@ -55,21 +72,48 @@
  *************************************************************************/
 
 #include "camecore/camecore.h"
+#include "camecore/machine.h"
 #include "camecore/utils.h"
 
+#include <string.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Defines and Macros
+//----------------------------------------------------------------------------------------------------------------------
+#define PAGE_OF( addr )     ( ( addr ) >> BUS_PAGE_SHIFT )       /**< Page index of an address */
+#define PAGE_OFFSET( addr ) ( ( addr ) & ( BUS_PAGE_SIZE - 1 ) ) /**< Offset of an address inside its page */
+
+#define WATCH_TRAPS         ( WATCH_READ | WATCH_WRITE | WATCH_EXECUTE ) /**< Trap bits owned by watchpoints */
+#define ECHO_PAGE_DELTA     PAGE_OF( ECHO_START - WRAM_START )          /**< Pages between WRAM and its echo */
+
+//----------------------------------------------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------------------------------------------
+extern THREAD_LOCAL Machine * machine_ctx; // Page table lives in the machine arena
+
 //----------------------------------------------------------------------------------------------------------------------
 // Functions Declarations
 //----------------------------------------------------------------------------------------------------------------------
 extern u8   GetIERegister( void );
 extern void SetIERegister( u8 v );
+extern void InvalidateFetchRegion( void );
+extern void CheckWatchpoint( u16 addr, u8 value, WatchKind kind );
+
+void MapBusPages( u16 start, u32 size, u8 * readBase, u8 * writeBase );
+void SetBusPageTrap( u8 page, u8 kinds );
+void MarkAllBusPagesDirty( void );
+void MarkBusRangeDirty( u16 start, u32 size );
+u32  GetBusReadRegion( u16 addr, const u8 ** outBase, u16 * outStart );
+u8   ReadBusFetch( u16 addr, bool opcode );
 
 //----------------------------------------------------------------------------------------------------------------------
-// Module Functions Definition
+// Module Internal Functions Definitions
 //----------------------------------------------------------------------------------------------------------------------
-u8
-ReadBus( u16 addr )
+// Resolve a read whose page has no direct host memory
+static u8
+ReadBusHandler( u16 addr )
 {
-    if( LIKELY( addr <= ROM_BANKN_END ) )
+    if( addr <= ROM_BANKN_END )
         {
             // Cartridge ROM: 0x0000–0x7FFF
             return ReadCartridge( addr );
@@ -77,7 +121,7 @@ ReadBus( u16 addr )
     else if( addr <= VRAM_END )
         {
             // Video RAM (VRAM): 0x8000–0x9FFF
-            NO_IMPL();
+            return ReadVRAM( addr );
         }
     else if( addr <= EXTRAM_END )
         {
@@ -92,17 +136,13 @@ ReadBus( u16 addr )
     else if( addr <= ECHO_END )
         {
             // Echo RAM: 0xE000–0xFDFF
-            return 0;
-        }
-    else if( addr <= OAM_END )
-        {
-            // Object Attribute Memory (OAM): 0xFE00–0xFE9F
-            NO_IMPL();
+            return ReadEcho( addr );
         }
     else if( addr <= 0xFEFF )
         {
+            // Object Attribute Memory (OAM): 0xFE00–0xFE9F
             // Unusable / Reserved memory: 0xFEA0–0xFEFF
-            NO_IMPL();
+            return ReadOAM( addr );
         }
     else if( addr <= IO_END )
         {
@@ -123,8 +163,9 @@ ReadBus( u16 addr )
     return 0;
 }
 
-void
-WriteBus( u16 addr, u8 value )
+// Resolve a write whose page has no direct host memory
+static void
+WriteBusHandler( u16 addr, u8 value )
 {
     // Cartridge ROM: 0x0000–0x7FFF
     if( addr <= ROM_BANKN_END )
@@ -135,7 +176,7 @@ WriteBus( u16 addr, u8 value )
     else if( addr <= VRAM_END )
         {
             // Video RAM (VRAM): 0x8000–0x9FFF
-            NO_IMPL();
+            WriteVRAM( addr, value );
         }
     else if( addr <= EXTRAM_END )
         {
@@ -150,17 +191,13 @@ WriteBus( u16 addr, u8 value )
     else if( addr <= ECHO_END )
         {
             // Echo RAM: 0xE000–0xFDFF
-            return;
-        }
-    else if( addr <= OAM_END )
-        {
-            // Object Attribute Memory (OAM): 0xFE00–0xFE9F
-            NO_IMPL();
+            WriteEcho( addr, value );
         }
     else if( addr <= 0xFEFF )
         {
-            // Unusable / Reserved memory: 0xFEA0–0xFEFF
-            return;
+            // Object Attribute Memory (OAM): 0xFE00–0xFE9F
+            // Unusable / Reserved memory: 0xFEA0–0xFEFF (writes ignored)
+            WriteOAM( addr, value );
         }
     else if( addr <= IO_END )
         {
@@ -180,6 +217,259 @@ WriteBus( u16 addr, u8 value )
         }
 }
 
+// Publish the effective pointers of a page: trapped accesses are routed to the slow path
+static void
+UpdateBusPage( u32 page )
+{
+    BusContext * const bus  = &machine_ctx->bus;
+    const u8           trap = bus->trap[page];
+
+    bus->read_map[page]     = ( trap & ( WATCH_READ | WATCH_EXECUTE ) ) ? NULL : bus->read_direct[page];
+    bus->write_map[page]    = ( trap & ( WATCH_WRITE | BUS_TRAP_CLEAN ) ) ? NULL : bus->write_direct[page];
+}
+
+// Flag one page as dirty and stop trapping its writes for tracking
+static void
+SetBusPageDirty( u32 page )
+{
+    BusContext * const bus = &machine_ctx->bus;
+
+    bus->dirty[page >> 3] |= (u8)BIT( page & 7 );
+    if( bus->trap[page] & BUS_TRAP_CLEAN )
+        {
+            bus->trap[page] &= (u8)~BUS_TRAP_CLEAN;
+            UpdateBusPage( page );
+        }
+}
+
+// Record the first write to a clean page; WRAM and echo pages alias the same memory and are marked together
+static void
+MarkBusPageDirty( u32 page )
+{
+    SetBusPageDirty( page );
+
+    if( BETWEEN( page, PAGE_OF( WRAM_START ), PAGE_OF( ECHO_END ) - ECHO_PAGE_DELTA ) )
+        {
+            SetBusPageDirty( page + ECHO_PAGE_DELTA );
+        }
+    else if( BETWEEN( page, PAGE_OF( ECHO_START ), PAGE_OF( ECHO_END ) ) )
+        {
+            SetBusPageDirty( page - ECHO_PAGE_DELTA );
+        }
+}
+
+// Read a page without a direct pointer, reporting trapped data reads
+static u8
+ReadBusSlow( u16 addr )
+{
+    const u32  page   = PAGE_OF( addr );
+    const u8 * direct = machine_ctx->bus.read_direct[page];
+    const u8   value  = ( NULL != direct ) ? direct[PAGE_OFFSET( addr )] : ReadBusHandler( addr );
+
+    if( UNLIKELY( machine_ctx->bus.trap[page] & WATCH_READ ) ) CheckWatchpoint( addr, value, WATCH_READ );
+
+    return value;
+}
+
+// Write a page without a direct pointer, reporting trapped writes before they land
+static void
+WriteBusSlow( u16 addr, u8 value )
+{
+    const u32 page   = PAGE_OF( addr );
+    u8 *      direct = machine_ctx->bus.write_direct[page];
+
+    if( UNLIKELY( machine_ctx->bus.trap[page] & WATCH_WRITE ) ) CheckWatchpoint( addr, value, WATCH_WRITE );
+    if( machine_ctx->bus.trap[page] & BUS_TRAP_CLEAN ) MarkBusPageDirty( page );
+
+    if( NULL != direct )
+        {
+            direct[PAGE_OFFSET( addr )] = value;
+            return;
+        }
+
+    WriteBusHandler( addr, value );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------------------------------------------
+// Point the pages covering [start, start + size) at host memory (NULL routes the pages to the handlers)
+// NOTE: `start` and `size` must be multiples of the page size
+void
+MapBusPages( u16 start, u32 size, u8 * readBase, u8 * writeBase )
+{
+    ASSERT( 0 == PAGE_OFFSET( start ) && 0 == PAGE_OFFSET( size ), "UNALIGNED BUS MAPPING %04X+%X", start, size );
+    ASSERT( 0x10000U >= start + size, "BUS MAPPING OUT OF RANGE %04X+%X", start, size );
+
+    BusContext * const bus = &machine_ctx->bus;
+
+    for( u32 i = 0; i < ( size >> BUS_PAGE_SHIFT ); ++i )
+        {
+            const u32  page   = PAGE_OF( start ) + i;
+            const u32  offset = i << BUS_PAGE_SHIFT;
+            u8 * const read   = ( NULL != readBase ) ? readBase + offset : NULL;
+            u8 * const write  = ( NULL != writeBase ) ? writeBase + offset : NULL;
+
+            // Different memory behind the page (bank switch): its contents changed as far as the bus can tell
+            if( bus->track_dirty && ( read != bus->read_direct[page] || write != bus->write_direct[page] ) )
+                {
+                    SetBusPageDirty( page );
+                }
+
+            bus->read_direct[page]  = read;
+            bus->write_direct[page] = write;
+            UpdateBusPage( page );
+        }
+
+    // Any cached view of the old mapping (e.g. the opcode fetch window) is now stale
+    InvalidateFetchRegion();
+}
+
+// Set the `WatchKind` flags trapped on a page; untrapped pages keep their direct pointers
+void
+SetBusPageTrap( u8 page, u8 kinds )
+{
+    u8 * const trap  = &machine_ctx->bus.trap[page];
+    const u8   value = (u8)( ( *trap & ~WATCH_TRAPS ) | ( kinds & WATCH_TRAPS ) );
+
+    if( value == *trap ) return;
+
+    *trap = value;
+    UpdateBusPage( page );
+
+    InvalidateFetchRegion();
+}
+
+// Flag every page as dirty (the whole machine was overwritten, e.g. by a state load)
+void
+MarkAllBusPagesDirty( void )
+{
+    if( !machine_ctx->bus.track_dirty ) return;
+
+    for( u32 page = 0; page < BUS_PAGE_COUNT; ++page ) SetBusPageDirty( page );
+}
+
+// Flag the pages covering [start, start + size) as written by the core itself, outside the bus
+// NOTE: Costs a single test once a page is dirty, and nothing while tracking is off
+void
+MarkBusRangeDirty( u16 start, u32 size )
+{
+    const u32 last = PAGE_OF( start + size - 1 );
+
+    for( u32 page = PAGE_OF( start ); page <= last; ++page )
+        {
+            if( machine_ctx->bus.trap[page] & BUS_TRAP_CLEAN ) MarkBusPageDirty( page );
+        }
+}
+
+// Start or stop tracking the pages the CPU writes; starting begins with every page clean
+void
+TrackDirtyPages( bool enable )
+{
+    if( enable )
+        {
+            machine_ctx->bus.track_dirty = true;
+            ClearDirtyPages();
+            return;
+        }
+
+    MarkAllBusPagesDirty(); // Drops the remaining traps
+    machine_ctx->bus.track_dirty = false;
+}
+
+// Mark every page clean again, trapping each one until its next write
+// NOTE: Call from the emulation thread, or while it is paused
+void
+ClearDirtyPages( void )
+{
+    BusContext * const bus = &machine_ctx->bus;
+
+    if( !bus->track_dirty ) return;
+
+    memset( bus->dirty, 0, sizeof( bus->dirty ) );
+    for( u32 page = 0; page < BUS_PAGE_COUNT; ++page )
+        {
+            bus->trap[page] |= BUS_TRAP_CLEAN;
+            UpdateBusPage( page );
+        }
+}
+
+// Get the dirty bitmap (bit `page & 7` of byte `page >> 3`), or NULL while tracking is off
+const u8 *
+GetDirtyPages( void )
+{
+    return ( machine_ctx->bus.track_dirty ) ? machine_ctx->bus.dirty : NULL;
+}
+
+// Get the largest run of readable pages around `addr` that is contiguous in host memory
+// NOTE: Returns the run size in bytes, or 0 when `addr` has no direct host memory
+u32
+GetBusReadRegion( u16 addr, const u8 ** outBase, u16 * outStart )
+{
+    u8 * const * const map   = machine_ctx->bus.read_map;
+    u32                first = PAGE_OF( addr );
+    u32                last  = PAGE_OF( addr );
+
+    if( NULL == map[first] ) return 0;
+
+    while( 0 < first && NULL != map[first - 1] && map[first - 1] + BUS_PAGE_SIZE == map[first] )
+        {
+            --first;
+        }
+
+    while( BUS_PAGE_COUNT - 1 > last && NULL != map[last + 1] && map[last] + BUS_PAGE_SIZE == map[last + 1] )
+        {
+            ++last;
+        }
+
+    *outBase  = map[first];
+    *outStart = (u16)( first << BUS_PAGE_SHIFT );
+
+    return ( last - first + 1 ) << BUS_PAGE_SHIFT;
+}
+
+u8
+ReadBus( u16 addr )
+{
+    const u8 * page = machine_ctx->bus.read_map[PAGE_OF( addr )];
+
+    // Direct host memory: a single indexed load
+    if( LIKELY( NULL != page ) ) return page[PAGE_OFFSET( addr )];
+
+    return ReadBusSlow( addr );
+}
+
+// Read from the instruction stream, reporting trapped opcode fetches
+// NOTE: Operand bytes are not data reads, so they never trigger read watchpoints
+u8
+ReadBusFetch( u16 addr, bool opcode )
+{
+    const u32  page   = PAGE_OF( addr );
+    const u8 * direct = machine_ctx->bus.read_direct[page];
+    const u8   value  = ( NULL != direct ) ? direct[PAGE_OFFSET( addr )] : ReadBusHandler( addr );
+
+    if( UNLIKELY( opcode && ( machine_ctx->bus.trap[page] & WATCH_EXECUTE ) ) )
+        {
+            CheckWatchpoint( addr, value, WATCH_EXECUTE );
+        }
+
+    return value;
+}
+
+void
+WriteBus( u16 addr, u8 value )
+{
+    u8 * page = machine_ctx->bus.write_map[PAGE_OF( addr )];
+
+    if( LIKELY( NULL != page ) )
+        {
+            page[PAGE_OFFSET( addr )] = value;
+            return;
+        }
+
+    WriteBusSlow( addr, value );
+}
+
 u16
 ReadBusWord( u16 address )
 {
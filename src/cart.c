@@ -7,9 +7,15 @@
  *
  * Key Features:
  * - Parsing and validating ROM header data
- * - Loading cartridge data from file
+ * - Loading cartridge data from file through the shared ROM image cache (one read-only copy per game)
+ * - 128-bit content hash and global checksum verification, both from a single pass at load
  * - Providing utility functions for cartridge type and licensee lookup
  * - Exposing functions for read and write operations on cartridge memory
+ * - Battery-backed RAM mapped straight from the `.sav` file, flushed in the background
+ * - MBC1/MBC3/MBC5 banking: a bank switch repoints the bus pages of 4000-7FFF / A000-BFFF
+ *   at the new bank, so reads never do bank arithmetic
+ * - MBC3 real-time clock kept as a host timestamp plus a seconds count, evaluated only on latch
+ *   or register write (no per-cycle cost), persisted as the common 48-byte `.sav` footer
  *
  *
  *                               LICENSE
@@ -34,9 +40,11 @@
  *************************************************************************/
 
 #include "camecore/camecore.h"
+#include "camecore/machine.h"
 #include "camecore/utils.h"
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 //----------------------------------------------------------------------------------------------------------------------
 // Module Defines and Macros
@@ -46,6 +54,24 @@
 #define HEADER_CHECKSUM_START   0x0134 // Checksum calculation start offset
 #define HEADER_CHECKSUM_END     0x014C // Checksum calculation end offset
 #define HEADER_TITLE_STR_LENGTH 15     // Max index for null-terminated title
+#define GLOBAL_CHECKSUM_OFFSET  0x014E // Big-endian sum of every other ROM byte
+
+// Banking Defines
+#define EXTRAM_BANK_SIZE        0x2000 // Size of one external RAM bank (8 KiB)
+#define MBC_RAM_ENABLE_VALUE    0x0A   // Low nibble that enables external RAM
+#define OPEN_BUS_VALUE          0xFF   // Read value when nothing drives the bus
+
+// Save Defines
+#define SAVE_FLUSH_INTERVAL_MS  1000   // Period between background write-backs of battery RAM
+#define SAVE_POLL_MS            50     // Flusher wake-up granularity (bounds shutdown latency)
+
+// Clock Defines
+#define RTC_REG_SECONDS         0x08   // First clock register select (08: S, 09: M, 0A: H, 0B: DL, 0C: DH)
+#define RTC_DAY_SECONDS         86400ULL
+#define RTC_DAY_WRAP            ( 512 * RTC_DAY_SECONDS ) // 9-bit day counter overflow
+#define RTC_DH_HALT             0x40   // DH bit 6: clock stopped
+#define RTC_DH_CARRY            0x80   // DH bit 7: day counter overflowed (sticky)
+#define RTC_FOOTER_SIZE         48     // 10 little-endian u32 registers + u64 unix timestamp
 
 //----------------------------------------------------------------------------------------------------------------------
 // Types and Structures Definition
@@ -97,20 +123,48 @@ typedef struct PACKED CartContext
     // ROM file/data information
     struct
     {
-        char        filename[1024]; // Path to ROM file
-        size_t      size;           // Size of ROM data
-        u8 *        data;           // Raw ROM data
-        RomHeader * header;         // Decoded ROM header
+        char              filename[1024];                    // Path to ROM file
+        char              title[HEADER_TITLE_STR_LENGTH + 1]; // Null-terminated copy of the header title
+        size_t            size;                              // Size of ROM data
+        u8 *              data;                              // Raw ROM data (read-only, shared)
+        const RomHeader * header;                            // Decoded ROM header
+        RomHash           hash;                              // Content identity (whole image)
+        bool              header_valid;                      // Header checksum (014D) matches
+        bool              global_valid;                      // Global checksum (014E-014F) matches
     } rom;
 
+    // Cartridge RAM
+    struct
+    {
+        size_t size;      // Size of external RAM in bytes
+        u8     banks;     // Number of 8 KiB banks (a 2 KiB RAM counts as one)
+        size_t save_size; // Size of the `.sav` image: RAM, then the clock footer when present
+        bool   battery;   // Contents persist in the `.sav` file
+        bool   mapped;    // `Machine::cart_ram` is a shared mapping of the `.sav` file
+    } ram;
+
+    // NOTE: MBC and clock registers live in `Machine::cart`, RAM contents in `Machine::cart_ram`
 } CartContext;
 
+// Background write-back of mapped battery RAM
+typedef struct SaveContext
+{
+    THREAD_HANDLE flusher; // Thread issuing periodic asynchronous msyncs
+    bool          running; // Flusher keeps running while set
+} SaveContext;
+
 //----------------------------------------------------------------------------------------------------------------------
 // Global Variables Definition
 //----------------------------------------------------------------------------------------------------------------------
 // Cart state context
 CartContext cart_ctx            = { 0 };
 
+// Battery RAM write-back state
+static SaveContext save_ctx     = { 0 };
+
+// Registers and RAM contents live in the machine arena
+extern THREAD_LOCAL Machine * machine_ctx;
+
 // Kind of hardware is present on the cartridge
 static const char * ROM_TYPES[] = {
     "ROM ONLY",
@@ -215,6 +269,22 @@ static const char * LIC_CODE[0xA5] = {
     [0xA4] = "Konami (Yu-Gi-Oh!)",
 };
 
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Declarations
+//----------------------------------------------------------------------------------------------------------------------
+extern bool  InitMachine( void );
+extern void  ResetMachineRange( u8 * data, size_t size );
+extern void  PinMachineRange( u8 * data, size_t size );
+extern void  MapBusPages( u16 start, u32 size, u8 * readBase, u8 * writeBase );
+extern void  MarkBusRangeDirty( u16 start, u32 size );
+extern u8 *  AcquireRomImage( const char * filename, size_t * outSize, RomHash * outHash, u64 * outByteSum );
+extern void  ReleaseRomImage( const u8 * data );
+
+size_t GetCartridgeRAMSize( void );
+void   RestoreCartridgeBanks( void );
+
+static bool InitCartridgeRAM( void );
+
 //----------------------------------------------------------------------------------------------------------------------
 // Module Functions Definition: Getters
 //----------------------------------------------------------------------------------------------------------------------
@@ -256,6 +326,615 @@ GetHeaderChecksum( void )
     return LOW_BYTE( checksumCalc );
 }
 
+// Get the global checksum from the sum of every ROM byte
+// NOTE: The stored checksum bytes are excluded; the header field is big-endian, unlike `RomHeader`'s u16
+static u16
+GetGlobalChecksum( u64 byteSum )
+{
+    return (u16)( byteSum - cart_ctx.rom.data[GLOBAL_CHECKSUM_OFFSET] - cart_ctx.rom.data[GLOBAL_CHECKSUM_OFFSET + 1] );
+}
+
+// Get the size of the external RAM contents (the `.sav` clock footer excluded)
+size_t
+GetCartridgeRAMSize( void )
+{
+    return cart_ctx.ram.size;
+}
+
+// Get the content identity of the loaded ROM (zero when none is loaded)
+RomHash
+GetCartridgeHash( void )
+{
+    return cart_ctx.rom.hash;
+}
+
+// Check the header checksum of the loaded ROM (the boot ROM refuses to run without it)
+bool
+IsCartridgeHeaderValid( void )
+{
+    return cart_ctx.rom.header_valid;
+}
+
+// Check the global checksum of the loaded ROM (never verified by hardware; flags bad dumps)
+bool
+IsCartridgeGlobalChecksumValid( void )
+{
+    return cart_ctx.rom.global_valid;
+}
+
+// Check whether the loaded ROM runs in CGB mode (0143: $80 enhanced, $C0 CGB only)
+bool
+IsCartridgeCGB( void )
+{
+    return NULL != cart_ctx.rom.header && 0 != ( (u8)cart_ctx.rom.header->title[15] & 0x80 );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definition: Clock
+//----------------------------------------------------------------------------------------------------------------------
+// Check whether the cartridge type carries an MBC3 real-time clock
+static bool
+HasCartClock( u8 type )
+{
+    return ( 0x0F == type || 0x10 == type );
+}
+
+// Bring `seconds` up to the current host time, folding day overflows into the carry flag
+static u64
+UpdateClock( void )
+{
+    ClockState * const rtc = &machine_ctx->cart.rtc;
+    const i64          now = (i64)time( NULL );
+
+    if( !rtc->halted && now > rtc->base ) rtc->seconds += (u64)( now - rtc->base );
+    rtc->base = now;
+
+    if( rtc->seconds >= RTC_DAY_WRAP )
+        {
+            rtc->carry    = true;
+            rtc->seconds %= RTC_DAY_WRAP;
+        }
+
+    return rtc->seconds;
+}
+
+// Split a seconds count into the S, M, H, DL, DH register values
+static void
+GetClockRegisters( u64 seconds, u8 * regs )
+{
+    const ClockState * const rtc  = &machine_ctx->cart.rtc;
+    const u32                days = (u32)( seconds / RTC_DAY_SECONDS );
+
+    regs[0] = (u8)( seconds % 60 );
+    regs[1] = (u8)( ( seconds / 60 ) % 60 );
+    regs[2] = (u8)( ( seconds / 3600 ) % 24 );
+    regs[3] = (u8)( days & 0xFF );
+    regs[4] = (u8)( ( ( days >> 8 ) & 0x01 ) | ( rtc->halted ? RTC_DH_HALT : 0 ) | ( rtc->carry ? RTC_DH_CARRY : 0 ) );
+}
+
+// Join register values back into a seconds count
+// NOTE: Out-of-range values (e.g. 63 seconds) wrap instead of counting up to the next overflow
+static u64
+GetClockSeconds( const u8 * regs )
+{
+    const u64 days = (u64)regs[3] | ( (u64)( regs[4] & 0x01 ) << 8 );
+
+    return ( regs[0] % 60 ) + ( regs[1] % 60 ) * 60ULL + ( regs[2] % 24 ) * 3600ULL + days * RTC_DAY_SECONDS;
+}
+
+// Write the clock state into the `.sav` footer that follows RAM
+// NOTE: The footer holds the registers at `base`, so it stays valid while the clock runs
+static void
+StoreClockFooter( void )
+{
+    const ClockState * const rtc    = &machine_ctx->cart.rtc;
+    u8 * const               footer = machine_ctx->cart_ram + cart_ctx.ram.size;
+    u8                       regs[RTC_REG_COUNT];
+
+    if( !rtc->present ) return;
+
+    GetClockRegisters( rtc->seconds, regs );
+
+    memset( footer, 0, RTC_FOOTER_SIZE );
+    for( int i = 0; i < RTC_REG_COUNT; ++i )
+        {
+            footer[4 * i]                     = regs[i];
+            footer[4 * ( i + RTC_REG_COUNT )] = rtc->latched[i];
+        }
+    for( int i = 0; i < 8; ++i ) footer[40 + i] = (u8)( (u64)rtc->base >> ( 8 * i ) );
+}
+
+// Restore the clock from the `.sav` footer, counting the time spent powered off
+static void
+LoadClockFooter( void )
+{
+    ClockState * const rtc    = &machine_ctx->cart.rtc;
+    const u8 * const   footer = machine_ctx->cart_ram + cart_ctx.ram.size;
+    u8                 regs[RTC_REG_COUNT];
+    u64                base = 0;
+
+    for( int i = 0; i < 8; ++i ) base |= (u64)footer[40 + i] << ( 8 * i );
+
+    // No footer yet (new save, or one written without a clock): start from zero now
+    if( 0 == base )
+        {
+            rtc->base = (i64)time( NULL );
+            StoreClockFooter();
+            return;
+        }
+
+    for( int i = 0; i < RTC_REG_COUNT; ++i )
+        {
+            regs[i]         = footer[4 * i];
+            rtc->latched[i] = footer[4 * ( i + RTC_REG_COUNT )];
+        }
+
+    rtc->halted  = ( 0 != ( regs[4] & RTC_DH_HALT ) );
+    rtc->carry   = ( 0 != ( regs[4] & RTC_DH_CARRY ) );
+    rtc->seconds = GetClockSeconds( regs );
+    rtc->base    = (i64)base;
+
+    UpdateClock();
+}
+
+// Copy the running clock into the registers the game reads (00 then 01 written to 6000-7FFF)
+static void
+LatchClock( u8 value )
+{
+    ClockState * const rtc = &machine_ctx->cart.rtc;
+
+    if( 0x00 == rtc->latch && 0x01 == value )
+        {
+            GetClockRegisters( UpdateClock(), rtc->latched );
+            StoreClockFooter();
+            MarkBusRangeDirty( EXTRAM_START, EXTRAM_SIZE ); // What A000-BFFF reads when a register is selected
+        }
+
+    rtc->latch = value;
+}
+
+// Write a clock register; the clock is brought up to date first so elapsed time is kept
+static void
+WriteClockRegister( u8 reg, u8 value )
+{
+    ClockState * const rtc = &machine_ctx->cart.rtc;
+    u8                 regs[RTC_REG_COUNT];
+
+    GetClockRegisters( UpdateClock(), regs );
+
+    switch( reg )
+        {
+            case 0: regs[0] = value & 0x3F; break; // Also restarts the sub-second divider (base is now)
+            case 1: regs[1] = value & 0x3F; break;
+            case 2: regs[2] = value & 0x1F; break;
+            case 3: regs[3] = value; break;
+            case 4:
+                regs[4]     = value & 0x01;
+                rtc->halted = ( 0 != ( value & RTC_DH_HALT ) );
+                rtc->carry  = ( 0 != ( value & RTC_DH_CARRY ) ); // Only cleared by software
+                break;
+        }
+
+    rtc->seconds = GetClockSeconds( regs );
+    StoreClockFooter();
+}
+
+// Check whether A000-BFFF currently addresses a clock register
+static INLINE bool
+IsClockSelected( void )
+{
+    const MBCState * const mbc = &machine_ctx->cart.mbc;
+
+    return machine_ctx->cart.rtc.present && mbc->ram_enabled && mbc->bank_hi >= RTC_REG_SECONDS
+           && mbc->bank_hi < RTC_REG_SECONDS + RTC_REG_COUNT;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definition: Banking
+//----------------------------------------------------------------------------------------------------------------------
+// Get the memory bank controller family from the header cartridge type
+static MBCType
+GetCartMBCType( u8 type )
+{
+    switch( type )
+        {
+            case 0x00:
+            case 0x08:
+            case 0x09: return MBC_NONE;
+
+            case 0x01:
+            case 0x02:
+            case 0x03: return MBC_1;
+
+            case 0x0F:
+            case 0x10:
+            case 0x11:
+            case 0x12:
+            case 0x13: return MBC_3;
+
+            case 0x19:
+            case 0x1A:
+            case 0x1B:
+            case 0x1C:
+            case 0x1D:
+            case 0x1E: return MBC_5;
+
+            default:
+                LOG( LOG_WARNING, "Unsupported cartridge type %02X, running as ROM ONLY", type );
+                return MBC_NONE;
+        }
+}
+
+// Get the external RAM size declared by the header
+static size_t
+GetCartRAMSize( void )
+{
+    static const size_t RAM_SIZES[] = { 0, 0x800, 0x2000, 0x8000, 0x20000, 0x10000 };
+    const u8            code        = cart_ctx.rom.header->ram_size;
+
+    if( MBC_NONE != machine_ctx->cart.mbc.type || 0x08 == cart_ctx.rom.header->type
+        || 0x09 == cart_ctx.rom.header->type )
+        {
+            return ( code < ARRAY_LEN( RAM_SIZES ) ) ? RAM_SIZES[code] : 0;
+        }
+
+    return 0;
+}
+
+// Get the ROM bank mask, trusting the file size over a header that undersells it
+static u16
+GetCartROMBankMask( void )
+{
+    u32 banks = ( 8 >= cart_ctx.rom.header->rom_size ) ? 2U << cart_ctx.rom.header->rom_size : 2U;
+
+    while( (size_t)banks * ROM_BANK_SIZE < cart_ctx.rom.size && banks < 512 ) banks <<= 1;
+
+    return (u16)( banks - 1 );
+}
+
+// Point a 16 KiB ROM window at `offset`; bytes past the end of the image fall to the handler
+static void
+MapCartridgeROM( u16 start, u32 offset )
+{
+    u32 mapped = 0;
+
+    if( offset < cart_ctx.rom.size )
+        {
+            const size_t left = cart_ctx.rom.size - offset;
+            mapped            = (u32)( ( left < ROM_BANK_SIZE ) ? left : ROM_BANK_SIZE ) & ~0xFFU;
+        }
+
+    if( mapped < ROM_BANK_SIZE ) MapBusPages( start, ROM_BANK_SIZE, NULL, NULL );
+    if( mapped > 0 ) MapBusPages( start, mapped, cart_ctx.rom.data + offset, NULL );
+}
+
+// Point the external RAM window at `offset` (negative: disabled, reads float)
+static void
+MapCartridgeRAM( i32 offset )
+{
+    const u32 mapped = ( cart_ctx.ram.size < EXTRAM_BANK_SIZE ) ? (u32)cart_ctx.ram.size : EXTRAM_BANK_SIZE;
+
+    if( offset < 0 || mapped < EXTRAM_SIZE ) MapBusPages( EXTRAM_START, EXTRAM_SIZE, NULL, NULL );
+    if( offset >= 0 )
+        {
+            MapBusPages( EXTRAM_START, mapped, machine_ctx->cart_ram + offset, machine_ctx->cart_ram + offset );
+        }
+}
+
+// Derive the bank offsets from the MBC registers and repoint only the windows that moved
+static void
+UpdateCartridgeBanks( bool force )
+{
+    MBCState * const mbc         = &machine_ctx->cart.mbc;
+    u32              rom0        = 0;
+    u32              romx        = mbc->rom_bank & mbc->rom_mask;
+    u8               ramBank     = mbc->bank_hi;
+    bool             ramSelected = true;
+    i32              ram         = -1;
+
+    switch( mbc->type )
+        {
+            case MBC_1:
+                // Upper bits extend the ROM bank; mode 1 also applies them to bank 0 and the RAM bank
+                romx    = ( ( (u32)mbc->bank_hi << 5 ) | mbc->rom_bank ) & mbc->rom_mask;
+                rom0    = ( mbc->mode ) ? ( ( (u32)mbc->bank_hi << 5 ) & mbc->rom_mask ) : 0;
+                ramBank = ( mbc->mode ) ? mbc->bank_hi : 0;
+                break;
+
+            case MBC_3:
+                // 08-0C select the clock registers instead of a RAM bank
+                ramSelected = ( 0x04 > mbc->bank_hi );
+                break;
+
+            case MBC_5:
+            case MBC_NONE: break;
+        }
+
+    if( mbc->ram_enabled && ramSelected && 0 != cart_ctx.ram.banks )
+        {
+            ram = (i32)( ( ramBank % cart_ctx.ram.banks ) * EXTRAM_BANK_SIZE );
+        }
+
+    rom0 *= ROM_BANK_SIZE;
+    romx *= ROM_BANK_SIZE;
+
+    if( force || rom0 != mbc->rom0_offset )
+        {
+            mbc->rom0_offset = rom0;
+            MapCartridgeROM( ROM_BANK0_START, rom0 );
+        }
+
+    if( force || romx != mbc->romx_offset )
+        {
+            mbc->romx_offset = romx;
+            MapCartridgeROM( ROM_BANKN_START, romx );
+        }
+
+    if( force || ram != mbc->ram_offset )
+        {
+            mbc->ram_offset = ram;
+            MapCartridgeRAM( ram );
+        }
+}
+
+// Latch a write to the MBC register space (0000-7FFF)
+static void
+WriteMBCRegister( u16 address, u8 value )
+{
+    MBCState * const mbc    = &machine_ctx->cart.mbc;
+    const u8         region = (u8)( address >> 13 ); // 0: 0000-1FFF, 1: 2000-3FFF, 2: 4000-5FFF, 3: 6000-7FFF
+
+    switch( mbc->type )
+        {
+            case MBC_1:
+                switch( region )
+                    {
+                        case 0: mbc->ram_enabled = ( MBC_RAM_ENABLE_VALUE == ( value & 0x0F ) ); break;
+                        case 1: mbc->rom_bank = ( value & 0x1F ) ? ( value & 0x1F ) : 1; break;
+                        case 2: mbc->bank_hi = value & 0x03; break;
+                        case 3: mbc->mode = value & 0x01; break;
+                    }
+                break;
+
+            case MBC_3:
+                switch( region )
+                    {
+                        case 0: mbc->ram_enabled = ( MBC_RAM_ENABLE_VALUE == ( value & 0x0F ) ); break;
+                        case 1: mbc->rom_bank = ( value & 0x7F ) ? ( value & 0x7F ) : 1; break;
+                        case 2: mbc->bank_hi = value & 0x0F; break;
+                        case 3: LatchClock( value ); return; // Banks are unaffected
+                    }
+                break;
+
+            case MBC_5:
+                switch( region )
+                    {
+                        case 0: mbc->ram_enabled = ( MBC_RAM_ENABLE_VALUE == value ); break;
+                        case 1:
+                            if( address < 0x3000 )
+                                mbc->rom_bank = (u16)( ( mbc->rom_bank & 0x100 ) | value );
+                            else
+                                mbc->rom_bank = (u16)( ( mbc->rom_bank & 0xFF ) | ( ( value & 0x01 ) << 8 ) );
+                            break;
+                        case 2: mbc->bank_hi = value & 0x0F; break;
+                        case 3: break;
+                    }
+                break;
+
+            case MBC_NONE:
+                // ROM-only cartridges ignore writes; games still poke MBC registers, so keep this quiet
+                LOG_LIMITED( LOG_WARNING, address >> 8, "UNSUPPORTED CART WRITE %04X -> %02X", address, value );
+                return;
+        }
+
+    UpdateCartridgeBanks( false );
+}
+
+// Allocate external RAM and map the power-on banks
+static bool
+InitCartridgeBanks( void )
+{
+    MBCState * const mbc = &machine_ctx->cart.mbc;
+
+    mbc->type     = GetCartMBCType( cart_ctx.rom.header->type );
+    mbc->rom_mask = GetCartROMBankMask();
+    mbc->rom_bank = 1;
+
+    // Plain ROM+RAM carts have no enable register
+    mbc->ram_enabled = ( MBC_NONE == mbc->type );
+
+    if( !InitCartridgeRAM() ) return false;
+
+    UpdateCartridgeBanks( true );
+    return true;
+}
+
+// Remap the bus after the MBC and clock registers were overwritten (state load)
+void
+RestoreCartridgeBanks( void )
+{
+    if( NULL == cart_ctx.rom.data ) return;
+
+    UpdateCartridgeBanks( true );
+    StoreClockFooter();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definition: Save RAM
+//----------------------------------------------------------------------------------------------------------------------
+// Check whether the cartridge type keeps its RAM alive with a battery
+static bool
+IsCartBatteryBacked( u8 type )
+{
+    switch( type )
+        {
+            case 0x03:
+            case 0x06:
+            case 0x09:
+            case 0x0D:
+            case 0x0F:
+            case 0x10:
+            case 0x13:
+            case 0x1B:
+            case 0x1E:
+            case 0x22: return true;
+
+            default:   return false;
+        }
+}
+
+// Whole pages covered by the `.sav` mapping
+static size_t
+GetCartRAMMappedSize( void )
+{
+    return ( cart_ctx.ram.save_size + MACHINE_PAGE_SIZE - 1 ) & ~(size_t)( MACHINE_PAGE_SIZE - 1 );
+}
+
+// Build the save file path next to the ROM ("game.gb" -> "game.sav")
+static void
+GetCartSavePath( char * path, size_t size )
+{
+    const char * name  = cart_ctx.rom.filename;
+    const char * dot   = strrchr( name, '.' );
+    const char * slash = strrchr( name, '/' );
+    const char * back  = strrchr( name, '\\' );
+    int          stem  = (int)strlen( name );
+
+    if( NULL != back && ( NULL == slash || back > slash ) ) slash = back;
+    if( NULL != dot && ( NULL == slash || dot > slash ) ) stem = (int)( dot - name );
+
+    snprintf( path, size, "%.*s.sav", stem, name );
+}
+
+// Periodically push dirty save pages to storage, off the emulation thread
+// NOTE: `param` is the mapped RAM; the machine pointer is per thread and not set here
+static THREAD_RETURN
+RunSaveFlusher( THREAD_PARAM param )
+{
+    u8 * const data    = (u8 *)param;
+    u32        elapsed = 0;
+
+    while( ATOMIC_LOAD( &save_ctx.running ) )
+        {
+            THREAD_SLEEP( SAVE_POLL_MS );
+
+            elapsed += SAVE_POLL_MS;
+            if( elapsed >= SAVE_FLUSH_INTERVAL_MS )
+                {
+                    // Asynchronous: only schedules the pages the guest actually dirtied
+                    SyncMappedFile( data, cart_ctx.ram.save_size, false );
+                    elapsed = 0;
+                }
+        }
+
+    return 0;
+}
+
+// Back external RAM with the `.sav` file (shared mapping) or, failing that, with a copy of it
+static bool
+InitCartridgeRAM( void )
+{
+    ClockState * const rtc = &machine_ctx->cart.rtc;
+    char               savePath[sizeof( cart_ctx.rom.filename ) + 4];
+
+    cart_ctx.ram.size      = GetCartRAMSize();
+    rtc->present           = HasCartClock( cart_ctx.rom.header->type );
+    cart_ctx.ram.save_size = cart_ctx.ram.size + ( rtc->present ? RTC_FOOTER_SIZE : 0 );
+    if( 0 == cart_ctx.ram.save_size ) return true;
+
+    cart_ctx.ram.banks   = (u8)( ( cart_ctx.ram.size + EXTRAM_BANK_SIZE - 1 ) / EXTRAM_BANK_SIZE );
+    cart_ctx.ram.battery = IsCartBatteryBacked( cart_ctx.rom.header->type );
+
+    if( cart_ctx.ram.battery )
+        {
+            GetCartSavePath( savePath, sizeof( savePath ) );
+
+            // Mapped in place over the arena: guest writes land in the page cache, the flusher and unload write
+            // them back, and bus pages keep pointing at the same addresses
+            if( NULL != MapFileShared( savePath, cart_ctx.ram.save_size, machine_ctx->cart_ram ) )
+                {
+                    cart_ctx.ram.mapped = true;
+                    PinMachineRange( machine_ctx->cart_ram, GetCartRAMMappedSize() );
+                    ATOMIC_STORE( &save_ctx.running, true );
+                    if( 0 != THREAD_CREATE( save_ctx.flusher, RunSaveFlusher, machine_ctx->cart_ram ) )
+                        {
+                            ATOMIC_STORE( &save_ctx.running, false );
+                            LOG( LOG_WARNING, "SAVE: Failed to start flusher, saving on unload only" );
+                        }
+                    if( rtc->present ) LoadClockFooter();
+                    return true;
+                }
+        }
+
+    // Without a mapping, restore the previous save into the arena
+    if( cart_ctx.ram.battery )
+        {
+            FILE * const file = fopen( savePath, "rb" );
+            if( NULL != file )
+                {
+                    const size_t bytesRead = fread( machine_ctx->cart_ram, 1, cart_ctx.ram.save_size, file );
+                    const bool   failed    = ( 0 != ferror( file ) );
+                    fclose( file );
+
+                    // Same as the mapping: a short save is zero-filled past its end, an unreadable one not trusted
+                    if( failed )
+                        {
+                            LOG( LOG_WARNING, "SAVE: [%s] Failed to read, starting from a blank save", savePath );
+                            memset( machine_ctx->cart_ram, 0, cart_ctx.ram.save_size );
+                        }
+                    else if( bytesRead < cart_ctx.ram.save_size )
+                        {
+                            LOG( LOG_WARNING, "SAVE: [%s] Short read (%zu of %zu bytes), zero-filling the rest",
+                                 savePath, bytesRead, cart_ctx.ram.save_size );
+                            memset( machine_ctx->cart_ram + bytesRead, 0, cart_ctx.ram.save_size - bytesRead );
+                        }
+                    else
+                        {
+                            LOG( LOG_INFO, "SAVE: [%s] Restored %zu bytes", savePath, bytesRead );
+                        }
+                }
+        }
+
+    if( rtc->present ) LoadClockFooter();
+
+    return true;
+}
+
+// Persist battery-backed RAM now, blocking until it reached storage
+bool
+SaveCartridgeRAM( void )
+{
+    char savePath[sizeof( cart_ctx.rom.filename ) + 4];
+
+    if( !cart_ctx.ram.battery || 0 == cart_ctx.ram.save_size ) return false;
+
+    if( cart_ctx.ram.mapped ) return SyncMappedFile( machine_ctx->cart_ram, cart_ctx.ram.save_size, true );
+
+    GetCartSavePath( savePath, sizeof( savePath ) );
+    return SaveFileData( savePath, machine_ctx->cart_ram, cart_ctx.ram.save_size );
+}
+
+// Stop the flusher, write the save back and clear external RAM
+static void
+ReleaseCartridgeRAM( void )
+{
+    if( ATOMIC_LOAD( &save_ctx.running ) )
+        {
+            ATOMIC_STORE( &save_ctx.running, false );
+            THREAD_JOIN( save_ctx.flusher );
+        }
+
+    if( 0 == cart_ctx.ram.save_size ) return;
+
+    SaveCartridgeRAM();
+
+    // Drop the file pages from the arena; fresh zero pages take their place
+    if( cart_ctx.ram.mapped )
+        ResetMachineRange( machine_ctx->cart_ram, GetCartRAMMappedSize() );
+    else
+        memset( machine_ctx->cart_ram, 0, cart_ctx.ram.save_size );
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // Module Functions Definition: File
 //----------------------------------------------------------------------------------------------------------------------
@@ -263,9 +942,11 @@ GetHeaderChecksum( void )
 bool
 LoadCartridge( char * cartPath )
 {
-    size_t bytesRead;
-    u8 *   fileData;
-    bool   chkValid;
+    size_t  bytesRead;
+    u8 *    fileData;
+    RomHash hash;
+    u64     byteSum;
+    u16     globalChecksum;
 
     if( false == IS_STR_VALID( cartPath ) )
         {
@@ -273,60 +954,131 @@ LoadCartridge( char * cartPath )
             return false;
         }
 
-    // Init context
-    memset( &cart_ctx, 0, sizeof( cart_ctx ) );
+    // Init context, releasing any previous cartridge
+    if( !InitMachine() ) return false;
+    UnloadCartridge();
     snprintf( cart_ctx.rom.filename, sizeof( cart_ctx.rom.filename ), "%s", cartPath );
 
-    // Load cartrige file
-    fileData = LoadFileData( cartPath, &bytesRead );
+    // Load cartrige file, sharing the image with any instance running the same ROM
+    // NOTE: Hashing and the global checksum sum share the one pass over the image
+    fileData = AcquireRomImage( cartPath, &bytesRead, &hash, &byteSum );
     if( NULL == fileData || 0 == bytesRead ) return false;
 
+    cart_ctx.rom.size   = bytesRead;
+    cart_ctx.rom.data   = fileData;
+    cart_ctx.rom.hash   = hash;
+
     // Validate file size
     if( ( HEADER_OFFSET + sizeof( RomHeader ) ) > bytesRead )
         {
             LOG( LOG_ERROR, "File too small for valid header: %s", cartPath );
-            free( fileData );
+            UnloadCartridge();
             return false;
         }
 
-    cart_ctx.rom.size   = bytesRead;
-    cart_ctx.rom.data   = fileData;
+    // Setup header; the ROM is never written, so the title is copied out to terminate it
+    cart_ctx.rom.header = (const RomHeader *)( cart_ctx.rom.data + HEADER_OFFSET );
+    memcpy( cart_ctx.rom.title, cart_ctx.rom.header->title, HEADER_TITLE_STR_LENGTH );
+    cart_ctx.rom.title[HEADER_TITLE_STR_LENGTH] = '\0';
 
-    // Setup header and null-terminate title
-    cart_ctx.rom.header = (RomHeader *)( cart_ctx.rom.data + HEADER_OFFSET );
-    cart_ctx.rom.header->title[sizeof( cart_ctx.rom.header->title ) - 1] = '\0';
+    // Verify checksums
+    globalChecksum            = MAKE_WORD( cart_ctx.rom.data[GLOBAL_CHECKSUM_OFFSET], cart_ctx.rom.data[GLOBAL_CHECKSUM_OFFSET + 1] );
+    cart_ctx.rom.header_valid = ( GetHeaderChecksum() == cart_ctx.rom.header->checksum );
+    cart_ctx.rom.global_valid = ( GetGlobalChecksum( byteSum ) == globalChecksum );
 
-    // Verify checksum
-    chkValid = ( GetHeaderChecksum() == cart_ctx.rom.header->checksum );
+    // Expose the ROM as read-only bus pages; writes reach the cartridge handler
+    if( !InitCartridgeBanks() )
+        {
+            UnloadCartridge();
+            return false;
+        }
 
     // Log cart info
     LOG( LOG_INFO, "Cartridge Loaded:" );
-    LOG( LOG_INFO, "    > Title    : %s", cart_ctx.rom.header->title );
+    LOG( LOG_INFO, "    > Title    : %s", cart_ctx.rom.title );
     LOG( LOG_INFO, "    > Type     : %02X (%s)", cart_ctx.rom.header->type, GetCartTypeName() );
     LOG( LOG_INFO, "    > ROM Size : %zu KB", (size_t)( 32UL << cart_ctx.rom.header->rom_size ) );
-    LOG( LOG_INFO, "    > RAM Size : %02X", cart_ctx.rom.header->ram_size );
+    LOG( LOG_INFO, "    > ROM Banks: %u", machine_ctx->cart.mbc.rom_mask + 1U );
+    LOG( LOG_INFO, "    > RAM Size : %02X (%zu KB)", cart_ctx.rom.header->ram_size, cart_ctx.ram.size >> 10 );
     LOG( LOG_INFO, "    > LIC Code : %02X (%s)", cart_ctx.rom.header->lic_code, GetCartLicenseeName() );
     LOG( LOG_INFO, "    > ROM Vers : %02X", cart_ctx.rom.header->version );
-    LOG( LOG_INFO, "    > Checksum : %02X (%s)", cart_ctx.rom.header->checksum, ( chkValid ) ? "PASSED" : "FAILED" );
+    LOG( LOG_INFO, "    > Checksum : %02X (%s)", cart_ctx.rom.header->checksum, ( cart_ctx.rom.header_valid ) ? "PASSED" : "FAILED" );
+    LOG( LOG_INFO, "    > Global   : %04X (%s)", globalChecksum, ( cart_ctx.rom.global_valid ) ? "PASSED" : "FAILED" );
+    LOG( LOG_INFO, "    > Hash     : %016llX%016llX", (unsigned long long)cart_ctx.rom.hash.hi,
+         (unsigned long long)cart_ctx.rom.hash.lo );
 
     return true;
 }
 
+// Detach the cartridge from the bus and drop its reference to the ROM image
+void
+UnloadCartridge( void )
+{
+    if( NULL != cart_ctx.rom.data )
+        {
+            MapBusPages( ROM_BANK0_START, 2 * ROM_BANK_SIZE, NULL, NULL );
+            MapBusPages( EXTRAM_START, EXTRAM_SIZE, NULL, NULL );
+            ReleaseRomImage( cart_ctx.rom.data );
+        }
+
+    ReleaseCartridgeRAM();
+
+    memset( &cart_ctx, 0, sizeof( cart_ctx ) );
+    if( NULL != machine_ctx ) memset( &machine_ctx->cart, 0, sizeof( machine_ctx->cart ) );
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // Module Functions Definition: Operations
 //----------------------------------------------------------------------------------------------------------------------
 // Perform read operation on cartridge
+// NOTE: Only reached for bytes without a direct bus page (image tail, disabled or partial RAM)
 u8
 ReadCartridge( u16 address )
 {
-    return cart_ctx.rom.data[address];
+    const MBCState * const mbc = &machine_ctx->cart.mbc;
+
+    if( address <= ROM_BANKN_END )
+        {
+            const u32 base   = ( address < ROM_BANKN_START ) ? mbc->rom0_offset : mbc->romx_offset;
+            const u32 offset = base + ( address & ( ROM_BANK_SIZE - 1 ) );
+
+            if( LIKELY( NULL != cart_ctx.rom.data && offset < cart_ctx.rom.size ) ) return cart_ctx.rom.data[offset];
+
+            // Open bus: the image is shorter than the selected bank
+            LOG_LIMITED( LOG_WARNING, address >> 8, "UNSUPPORTED CART READ %04X", address );
+            return OPEN_BUS_VALUE;
+        }
+
+    // External RAM; small RAMs mirror across the window
+    if( mbc->ram_offset >= 0 )
+        {
+            return machine_ctx->cart_ram[( (u32)mbc->ram_offset + ( address - EXTRAM_START ) ) % cart_ctx.ram.size];
+        }
+
+    // Clock registers read back the latched values, so nothing is computed here
+    if( IsClockSelected() ) return machine_ctx->cart.rtc.latched[mbc->bank_hi - RTC_REG_SECONDS];
+
+    return OPEN_BUS_VALUE;
 }
 
 // Perform write operation on cartridge
 void
 WriteCartridge( u16 address, u8 value )
 {
-    UNUSED( address );
-    UNUSED( value );
-    NO_IMPL();
+    const MBCState * const mbc = &machine_ctx->cart.mbc;
+
+    if( address <= ROM_BANKN_END )
+        {
+            WriteMBCRegister( address, value );
+            return;
+        }
+
+    if( mbc->ram_offset >= 0 )
+        {
+            machine_ctx->cart_ram[( (u32)mbc->ram_offset + ( address - EXTRAM_START ) ) % cart_ctx.ram.size] = value;
+        }
+    else if( IsClockSelected() )
+        {
+            WriteClockRegister( mbc->bank_hi - RTC_REG_SECONDS, value );
+        }
 }
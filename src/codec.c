@@ -0,0 +1,856 @@
+/****************************** CameCore *********************************
+ *
+ * Module: Codec
+ *
+ * Small LZ compressor for save states, rewind history and traces; no external dependency.
+ *
+ * Key Features:
+ * - LZ4 block format (token, literals, 16-bit offset, match length), 64 KiB blocks
+ * - Greedy single-probe hash matcher that speeds up over incompressible input
+ * - Zero runs and repeated bytes become offset-1 matches, decoded as a memset
+ * - Framed output: independent blocks with raw and packed sizes, stored verbatim when they do not shrink
+ * - CompressData / DecompressData: one-shot, optionally spread over several threads by groups of blocks
+ * - CodecStream: push-style streaming in either direction, output delivered through a callback
+ *
+ * Frame layout:
+ *   [u32 magic] then per block [u32 raw size][u32 packed size | CODEC_STORED][payload], ending with [u32 0]
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *      wrote the original software. If you use this software in a product, an acknowledgment
+ *      in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#include "camecore/camecore.h"
+#include "camecore/utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Defines and Macros
+//----------------------------------------------------------------------------------------------------------------------
+#define CODEC_MAGIC        0x315A4343 /**< "CCZ1" */
+#define CODEC_BLOCK_SIZE   0x10000    /**< Raw bytes per block (offsets and hash positions fit 16 bits) */
+#define CODEC_STORED       0x80000000 /**< Packed size flag: payload is the raw block */
+#define CODEC_BLOCK_HEADER 8          /**< Raw size + packed size */
+
+// Encoded block worst case, before the stored fallback replaces it
+#define CODEC_BLOCK_BOUND( size ) ( CODEC_BLOCK_HEADER + ( size ) + ( size ) / 255 + 16 )
+
+#define CODEC_MIN_MATCH    4  /**< Shortest match worth an offset */
+#define CODEC_END_LITERALS 5  /**< A block always ends with at least this many literals */
+#define CODEC_MATCH_LIMIT  12 /**< No match starts closer than this to the end of a block */
+#define CODEC_HASH_LOG     12 /**< 4096-entry match table */
+#define CODEC_SKIP_TRIGGER 6  /**< Search step grows by one byte every 1 << 6 misses */
+
+#define CODEC_JOB_BLOCKS   16 /**< Blocks per job in the multithreaded modes (1 MiB of raw data) */
+#define CODEC_MAX_THREADS  32 /**< Upper bound for codec workers */
+
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+// Streaming state; `buffer` collects raw input (compressing) or one framed block (decompressing)
+struct CodecStream
+{
+    bool               compress;
+    bool               failed;
+    bool               header_done; // Frame magic written (compressing) or checked (decompressing)
+    bool               ended;       // End marker seen (decompressing)
+    CodecWriteCallback write;
+    void *             user;
+    size_t             fill;        // Bytes held in `buffer`
+    u8 *               buffer;      // CODEC_BLOCK_HEADER + CODEC_BLOCK_SIZE bytes
+    u8 *               output;      // One encoded or decoded block
+};
+
+// Location of one block inside a frame
+typedef struct CodecBlock
+{
+    size_t input;  // Offset of the block header in the frame (decompressing) or of the raw data (compressing)
+    size_t output; // Offset of the raw data (decompressing) or of the encoded block in the job buffer
+    u32    size;   // Raw size
+    u32    packed; // Packed size, with CODEC_STORED
+} CodecBlock;
+
+// Work shared by the threads of one multithreaded call
+typedef struct CodecJobs
+{
+    const u8 *   input;
+    u8 *         output;
+    CodecBlock * blocks;
+    u32          block_count;
+    u32          job_count;
+    unsigned int next_job; // Work counter shared by the workers
+    bool         failed;
+} CodecJobs;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+static INLINE u32
+Read32( const u8 * p )
+{
+    u32 v;
+    memcpy( &v, p, sizeof( v ) );
+    return v;
+}
+
+static INLINE u64
+Read64( const u8 * p )
+{
+    u64 v;
+    memcpy( &v, p, sizeof( v ) );
+    return v;
+}
+
+static INLINE void
+Write32( u8 * p, u32 v )
+{
+    memcpy( p, &v, sizeof( v ) );
+}
+
+// Raw size of the block starting at `offset`
+static INLINE u32
+GetBlockLength( size_t size, size_t offset )
+{
+    return (u32)( ( size - offset < CODEC_BLOCK_SIZE ) ? size - offset : CODEC_BLOCK_SIZE );
+}
+
+static INLINE u32
+HashPosition( const u8 * p )
+{
+    return ( Read32( p ) * 2654435761U ) >> ( 32 - CODEC_HASH_LOG );
+}
+
+// Number of equal leading bytes of two differing little-endian words
+static INLINE u32
+CountEqualBytes( u64 diff )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return (u32)__builtin_ctzll( diff ) >> 3;
+#else
+    u32 n = 0;
+    while( 0 == ( diff & 0xFF ) )
+        {
+            diff >>= 8;
+            ++n;
+        }
+    return n;
+#endif
+}
+
+// Length of the common run of `a` and `b`, stopping at `limit` (on the `a` side)
+static INLINE size_t
+CountMatch( const u8 * a, const u8 * b, const u8 * limit )
+{
+    const u8 * const start = a;
+
+    while( a + sizeof( u64 ) <= limit )
+        {
+            const u64 diff = Read64( a ) ^ Read64( b );
+            if( 0 != diff ) return (size_t)( a - start ) + CountEqualBytes( diff );
+            a += sizeof( u64 );
+            b += sizeof( u64 );
+        }
+
+    while( a < limit && *a == *b )
+        {
+            ++a;
+            ++b;
+        }
+
+    return (size_t)( a - start );
+}
+
+static INLINE u8 *
+WriteLength( u8 * op, size_t length )
+{
+    while( length >= 255 )
+        {
+            *op++   = 255;
+            length -= 255;
+        }
+    *op++ = (u8)length;
+    return op;
+}
+
+// Emit one sequence: literals [anchor, ip), then a match of `length` bytes at `offset` (0: literals only)
+static INLINE u8 *
+WriteSequence( u8 * op, const u8 * anchor, const u8 * ip, u32 offset, size_t length )
+{
+    const size_t literals = (size_t)( ip - anchor );
+    u8 * const   token    = op++;
+
+    *token = (u8)( ( literals >= 15 ? 15 : literals ) << 4 );
+    if( literals >= 15 ) op = WriteLength( op, literals - 15 );
+    memcpy( op, anchor, literals );
+    op += literals;
+
+    if( 0 == offset ) return op;
+
+    op[0]   = (u8)offset;
+    op[1]   = (u8)( offset >> 8 );
+    op     += 2;
+    length -= CODEC_MIN_MATCH;
+    *token |= (u8)( length >= 15 ? 15 : length );
+    if( length >= 15 ) op = WriteLength( op, length - 15 );
+
+    return op;
+}
+
+// Compress one block (at most CODEC_BLOCK_SIZE bytes); `out` holds at least `size + size / 255 + 16` bytes
+static size_t
+CompressBlock( const u8 * src, size_t size, u8 * out )
+{
+    u16              table[1 << CODEC_HASH_LOG];
+    const u8 * const end      = src + size;
+    const u8 * const mflimit  = end - CODEC_MATCH_LIMIT;
+    const u8 * const matchEnd = end - CODEC_END_LITERALS;
+    const u8 *       ip       = src;
+    const u8 *       anchor   = src;
+    u8 *             op       = out;
+
+    if( size < CODEC_MATCH_LIMIT + 1 ) return (size_t)( WriteSequence( op, anchor, end, 0, 0 ) - out );
+
+    memset( table, 0, sizeof( table ) );
+    table[HashPosition( ip )] = 0;
+    ++ip;
+
+    for( ;; )
+        {
+            const u8 * match;
+            u32        misses = 1U << CODEC_SKIP_TRIGGER;
+            size_t     length;
+
+            // Find a 4-byte match, stepping faster the longer nothing is found
+            for( ;; )
+                {
+                    const u32 h = HashPosition( ip );
+
+                    match    = src + table[h];
+                    table[h] = (u16)( ip - src );
+                    if( match < ip && Read32( match ) == Read32( ip ) ) break;
+
+                    ip += misses++ >> CODEC_SKIP_TRIGGER;
+                    if( ip > mflimit ) goto last_literals;
+                }
+
+            // Grow the match backwards over pending literals
+            while( ip > anchor && match > src && ip[-1] == match[-1] )
+                {
+                    --ip;
+                    --match;
+                }
+
+            length = CODEC_MIN_MATCH
+                   + CountMatch( ip + CODEC_MIN_MATCH, match + CODEC_MIN_MATCH, matchEnd );
+            op     = WriteSequence( op, anchor, ip, (u32)( ip - match ), length );
+            ip    += length;
+            anchor = ip;
+
+            if( ip > mflimit ) break;
+
+            // Seed the table with a position inside the match, so runs chain cheaply
+            table[HashPosition( ip - 2 )] = (u16)( ip - 2 - src );
+        }
+
+last_literals:
+    op = WriteSequence( op, anchor, end, 0, 0 );
+    return (size_t)( op - out );
+}
+
+// Decompress one block into exactly `size` bytes; returns false on malformed input
+static bool
+DecompressBlock( const u8 * ip, size_t packed, u8 * out, size_t size )
+{
+    const u8 * const iend = ip + packed;
+    u8 * const       oend = out + size;
+    u8 *             op   = out;
+
+    while( ip < iend )
+        {
+            const u32 token    = *ip++;
+            size_t    literals = token >> 4;
+            size_t    length;
+            size_t    offset;
+            const u8 *match;
+            u8 *      stop;
+
+            if( 15 == literals )
+                {
+                    u32 b;
+                    do
+                        {
+                            if( UNLIKELY( ip >= iend ) ) return false;
+                            b         = *ip++;
+                            literals += b;
+                        }
+                    while( 255 == b );
+                }
+
+            if( UNLIKELY( literals > (size_t)( iend - ip ) || literals > (size_t)( oend - op ) ) ) return false;
+
+            // Short literal runs: one over-long copy when both sides have room
+            if( LIKELY( literals <= 16 && ip + 16 <= iend && op + 16 <= oend ) )
+                memcpy( op, ip, 16 );
+            else
+                memcpy( op, ip, literals );
+            op += literals;
+            ip += literals;
+
+            if( ip == iend ) break; // Last sequence has no match
+
+            if( UNLIKELY( iend - ip < 2 ) ) return false;
+            offset  = (size_t)ip[0] | ( (size_t)ip[1] << 8 );
+            ip     += 2;
+            if( UNLIKELY( 0 == offset || offset > (size_t)( op - out ) ) ) return false;
+
+            length = token & 15;
+            if( 15 == length )
+                {
+                    u32 b;
+                    do
+                        {
+                            if( UNLIKELY( ip >= iend ) ) return false;
+                            b       = *ip++;
+                            length += b;
+                        }
+                    while( 255 == b );
+                }
+            length += CODEC_MIN_MATCH;
+            if( UNLIKELY( length > (size_t)( oend - op ) ) ) return false;
+
+            stop  = op + length;
+            match = op - offset;
+            if( 1 == offset )
+                {
+                    memset( op, *match, length ); // Byte runs (zero fill)
+                }
+            else if( LIKELY( offset >= sizeof( u64 ) && length <= 16 && op + 16 <= oend ) )
+                {
+                    // Short match: two fixed-size copies, the second may read what the first wrote
+                    memcpy( op, match, sizeof( u64 ) );
+                    memcpy( op + sizeof( u64 ), match + sizeof( u64 ), sizeof( u64 ) );
+                }
+            else
+                {
+                    // The source repeats every `offset` bytes, so each copy can span everything written so far
+                    while( op < stop )
+                        {
+                            size_t chunk = (size_t)( op - match );
+                            if( chunk > (size_t)( stop - op ) ) chunk = (size_t)( stop - op );
+                            memcpy( op, match, chunk );
+                            op += chunk;
+                        }
+                }
+            op = stop;
+        }
+
+    return op == oend;
+}
+
+// Encode one framed block; stored verbatim when compression does not pay
+// NOTE: `out` holds at least CODEC_BLOCK_BOUND( size ) bytes
+static size_t
+EncodeBlock( const u8 * src, u32 size, u8 * out )
+{
+    size_t packed = CompressBlock( src, size, out + CODEC_BLOCK_HEADER );
+    u32    flags  = 0;
+
+    if( packed >= size )
+        {
+            memcpy( out + CODEC_BLOCK_HEADER, src, size );
+            packed = size;
+            flags  = CODEC_STORED;
+        }
+
+    Write32( out, size );
+    Write32( out + 4, (u32)packed | flags );
+    return CODEC_BLOCK_HEADER + packed;
+}
+
+// Threads to use for `jobs` jobs (`threads` 0: one per online core)
+static u32
+GetWorkerCount( u32 threads, u32 jobs )
+{
+    if( jobs <= 1 ) return 1; // Nothing to share; skip the core count query
+
+    if( 0 == threads )
+        {
+#if defined( _WIN32 ) || defined( _WIN64 )
+            SYSTEM_INFO info;
+            GetSystemInfo( &info );
+            threads = (u32)info.dwNumberOfProcessors;
+#else
+            const long cores = sysconf( _SC_NPROCESSORS_ONLN );
+            threads          = ( cores > 0 ) ? (u32)cores : 1;
+#endif
+        }
+
+    if( threads > jobs ) threads = jobs;
+    if( threads > CODEC_MAX_THREADS ) threads = CODEC_MAX_THREADS;
+    return ( 0 == threads ) ? 1 : threads;
+}
+
+// Run `worker` on `count` threads; the calling thread is one of them
+static void
+RunCodecWorkers( THREAD_RETURN ( *worker )( THREAD_PARAM ), CodecJobs * jobs, u32 count )
+{
+    THREAD_HANDLE threads[CODEC_MAX_THREADS];
+    u32           started = 0;
+
+    for( u32 i = 1; i < count; ++i )
+        {
+            if( 0 == THREAD_CREATE( threads[started], worker, jobs ) ) ++started;
+        }
+
+    worker( jobs );
+
+    for( u32 i = 0; i < started; ++i ) THREAD_JOIN( threads[i] );
+}
+
+// Worker: compress groups of blocks into their slot of the job buffer until the counter runs out
+static THREAD_RETURN
+CompressJobs( THREAD_PARAM param )
+{
+    CodecJobs * const jobs = (CodecJobs *)param;
+    unsigned int      job;
+
+    while( ( job = ATOMIC_INC( &jobs->next_job ) - 1 ) < jobs->job_count )
+        {
+            const u32 first = job * CODEC_JOB_BLOCKS;
+            const u32 last  = ( first + CODEC_JOB_BLOCKS < jobs->block_count ) ? first + CODEC_JOB_BLOCKS
+                                                                                : jobs->block_count;
+
+            for( u32 b = first; b < last; ++b )
+                {
+                    CodecBlock * const block = &jobs->blocks[b];
+                    block->packed = (u32)EncodeBlock( jobs->input + block->input, block->size,
+                                                      jobs->output + block->output );
+                }
+        }
+
+    return 0;
+}
+
+// Worker: decode groups of blocks straight into their place in the output
+static THREAD_RETURN
+DecompressJobs( THREAD_PARAM param )
+{
+    CodecJobs * const jobs = (CodecJobs *)param;
+    unsigned int      job;
+
+    while( ( job = ATOMIC_INC( &jobs->next_job ) - 1 ) < jobs->job_count )
+        {
+            const u32 first = job * CODEC_JOB_BLOCKS;
+            const u32 last  = ( first + CODEC_JOB_BLOCKS < jobs->block_count ) ? first + CODEC_JOB_BLOCKS
+                                                                                : jobs->block_count;
+
+            for( u32 b = first; b < last; ++b )
+                {
+                    const CodecBlock * const block   = &jobs->blocks[b];
+                    const u8 * const         payload = jobs->input + block->input + CODEC_BLOCK_HEADER;
+                    u8 * const               out     = jobs->output + block->output;
+                    const u32                packed  = block->packed & ~CODEC_STORED;
+
+                    if( block->packed & CODEC_STORED )
+                        memcpy( out, payload, block->size );
+                    else if( !DecompressBlock( payload, packed, out, block->size ) )
+                        ATOMIC_STORE( &jobs->failed, true );
+                }
+        }
+
+    return 0;
+}
+
+// Walk the block headers of a frame; fills `blocks` when given and returns the block count (-1: malformed)
+static i64
+ScanFrame( const u8 * data, size_t size, CodecBlock * blocks, size_t * outRawSize )
+{
+    size_t pos = sizeof( u32 );
+    size_t raw = 0;
+    i64    count = 0;
+
+    if( NULL == data || size < 2 * sizeof( u32 ) || CODEC_MAGIC != Read32( data ) ) return -1;
+
+    for( ;; )
+        {
+            u32 blockSize;
+            u32 packed;
+
+            if( size - pos < sizeof( u32 ) ) return -1;
+            blockSize = Read32( data + pos );
+            if( 0 == blockSize ) break; // End marker
+
+            if( size - pos < CODEC_BLOCK_HEADER ) return -1;
+            packed = Read32( data + pos + 4 ) & ~CODEC_STORED;
+            if( blockSize > CODEC_BLOCK_SIZE || packed > CODEC_BLOCK_SIZE || packed > size - pos - CODEC_BLOCK_HEADER )
+                return -1;
+            if( ( Read32( data + pos + 4 ) & CODEC_STORED ) && packed != blockSize ) return -1;
+
+            if( NULL != blocks )
+                {
+                    blocks[count].input  = pos;
+                    blocks[count].output = raw;
+                    blocks[count].size   = blockSize;
+                    blocks[count].packed = Read32( data + pos + 4 );
+                }
+
+            pos += CODEC_BLOCK_HEADER + packed;
+            raw += blockSize;
+            ++count;
+        }
+
+    if( NULL != outRawSize ) *outRawSize = raw;
+    return count;
+}
+
+// Compressing stream: encode the buffered block and hand it out
+static bool
+FlushStreamBlock( CodecStream * stream, const u8 * data, size_t size )
+{
+    const size_t encoded = EncodeBlock( data, (u32)size, stream->output );
+    return stream->write( stream->output, encoded, stream->user );
+}
+
+// Decompressing stream: decode one complete framed block held at `block`
+static bool
+DecodeStreamBlock( CodecStream * stream, const u8 * block )
+{
+    const u32 size   = Read32( block );
+    const u32 packed = Read32( block + 4 );
+
+    if( packed & CODEC_STORED ) return stream->write( block + CODEC_BLOCK_HEADER, size, stream->user );
+
+    if( !DecompressBlock( block + CODEC_BLOCK_HEADER, packed, stream->output, size ) ) return false;
+    return stream->write( stream->output, size, stream->user );
+}
+
+// Bytes still missing before the decompressing stream holds a complete header or block (0: complete)
+static size_t
+GetStreamNeed( const CodecStream * stream )
+{
+    const size_t header = stream->header_done ? sizeof( u32 ) : 2 * sizeof( u32 );
+    u32          size;
+    u32          packed;
+
+    if( !stream->header_done ) return ( stream->fill < sizeof( u32 ) ) ? sizeof( u32 ) - stream->fill : 0;
+
+    if( stream->fill < header ) return header - stream->fill;
+    size = Read32( stream->buffer );
+    if( 0 == size ) return 0;
+
+    if( stream->fill < CODEC_BLOCK_HEADER ) return CODEC_BLOCK_HEADER - stream->fill;
+    packed = Read32( stream->buffer + 4 ) & ~CODEC_STORED;
+    return ( stream->fill < CODEC_BLOCK_HEADER + packed ) ? CODEC_BLOCK_HEADER + packed - stream->fill : 0;
+}
+
+// Consume the complete header or block held by a decompressing stream
+static bool
+ConsumeStreamBuffer( CodecStream * stream )
+{
+    u32 size;
+    u32 packed;
+
+    stream->fill = 0;
+
+    if( !stream->header_done )
+        {
+            stream->header_done = true;
+            return CODEC_MAGIC == Read32( stream->buffer );
+        }
+
+    size = Read32( stream->buffer );
+    if( 0 == size )
+        {
+            stream->ended = true;
+            return true;
+        }
+
+    packed = Read32( stream->buffer + 4 );
+    if( size > CODEC_BLOCK_SIZE || ( ( packed & CODEC_STORED ) && ( packed & ~CODEC_STORED ) != size ) ) return false;
+
+    return DecodeStreamBlock( stream, stream->buffer );
+}
+
+// Feed compressed bytes to a decompressing stream
+static bool
+DecompressStream( CodecStream * stream, const u8 * data, size_t size )
+{
+    while( size > 0 )
+        {
+            size_t need;
+
+            if( stream->ended ) return false; // Data after the end marker
+
+            need = GetStreamNeed( stream );
+            if( 0 == need )
+                {
+                    if( !ConsumeStreamBuffer( stream ) ) return false;
+                    continue;
+                }
+
+            // Blocks that do not shrink are stored, so no payload is larger than a raw block
+            if( stream->fill >= CODEC_BLOCK_HEADER )
+                {
+                    if( ( Read32( stream->buffer + 4 ) & ~CODEC_STORED ) > CODEC_BLOCK_SIZE ) return false;
+                }
+
+            if( need > size ) need = size;
+            memcpy( stream->buffer + stream->fill, data, need );
+            stream->fill += need;
+            data         += need;
+            size         -= need;
+        }
+
+    return 0 != GetStreamNeed( stream ) || ConsumeStreamBuffer( stream );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Largest frame CompressData() can produce for `size` input bytes
+size_t
+GetCompressBound( size_t size )
+{
+    const size_t blocks = ( size + CODEC_BLOCK_SIZE - 1 ) / CODEC_BLOCK_SIZE;
+
+    return 2 * sizeof( u32 ) + blocks * CODEC_BLOCK_HEADER + size;
+}
+
+// Compress `size` bytes into a frame; `threads` 1 keeps the work on the caller, 0 uses every core
+// NOTE: Returns the frame size, or 0 when `capacity` is below GetCompressBound( size )
+size_t
+CompressData( const u8 * data, size_t size, u8 * out, size_t capacity, u32 threads )
+{
+    const u32 blockCount = (u32)( ( size + CODEC_BLOCK_SIZE - 1 ) / CODEC_BLOCK_SIZE );
+    const u32 jobCount   = ( blockCount + CODEC_JOB_BLOCKS - 1 ) / CODEC_JOB_BLOCKS;
+    const u32 workers    = GetWorkerCount( threads, jobCount );
+    CodecJobs jobs       = { 0 };
+    size_t    pos        = sizeof( u32 );
+
+    if( NULL == out || capacity < GetCompressBound( size ) || ( NULL == data && 0 != size ) ) return 0;
+
+    Write32( out, CODEC_MAGIC );
+
+    if( workers <= 1 )
+        {
+            u8 block[CODEC_BLOCK_BOUND( CODEC_BLOCK_SIZE )];
+
+            for( size_t offset = 0; offset < size; offset += CODEC_BLOCK_SIZE )
+                {
+                    const u32 blockSize = GetBlockLength( size, offset );
+
+                    // Encode in place while the worst case fits; near the end, go through `block`
+                    if( capacity - pos >= CODEC_BLOCK_BOUND( blockSize ) )
+                        {
+                            pos += EncodeBlock( data + offset, blockSize, out + pos );
+                        }
+                    else
+                        {
+                            const size_t encoded = EncodeBlock( data + offset, blockSize, block );
+                            memcpy( out + pos, block, encoded );
+                            pos += encoded;
+                        }
+                }
+
+            Write32( out + pos, 0 );
+            return pos + sizeof( u32 );
+        }
+
+    // Blocks are encoded into fixed slots of a scratch buffer, then packed together
+    jobs.blocks = (CodecBlock *)malloc( blockCount * sizeof( CodecBlock ) );
+    jobs.output = (u8 *)malloc( (size_t)blockCount * CODEC_BLOCK_BOUND( CODEC_BLOCK_SIZE ) );
+    if( NULL == jobs.blocks || NULL == jobs.output )
+        {
+            free( jobs.blocks );
+            free( jobs.output );
+            return 0;
+        }
+
+    for( u32 b = 0; b < blockCount; ++b )
+        {
+            const size_t offset = (size_t)b * CODEC_BLOCK_SIZE;
+
+            jobs.blocks[b].input  = offset;
+            jobs.blocks[b].output = (size_t)b * CODEC_BLOCK_BOUND( CODEC_BLOCK_SIZE );
+            jobs.blocks[b].size   = GetBlockLength( size, offset );
+        }
+
+    jobs.input       = data;
+    jobs.block_count = blockCount;
+    jobs.job_count   = jobCount;
+    RunCodecWorkers( CompressJobs, &jobs, workers );
+
+    for( u32 b = 0; b < blockCount; ++b )
+        {
+            memcpy( out + pos, jobs.output + jobs.blocks[b].output, jobs.blocks[b].packed );
+            pos += jobs.blocks[b].packed;
+        }
+
+    free( jobs.blocks );
+    free( jobs.output );
+    Write32( out + pos, 0 );
+    return pos + sizeof( u32 );
+}
+
+// Raw size of a frame, or 0 when `data` is not a complete frame
+size_t
+GetDecompressedSize( const u8 * data, size_t size )
+{
+    size_t raw = 0;
+
+    return ( ScanFrame( data, size, NULL, &raw ) < 0 ) ? 0 : raw;
+}
+
+// Decompress a frame; `threads` as in CompressData()
+// NOTE: Returns the raw size, or 0 when the frame is malformed or does not fit `capacity`
+size_t
+DecompressData( const u8 * data, size_t size, u8 * out, size_t capacity, u32 threads )
+{
+    CodecJobs  jobs  = { 0 };
+    size_t     raw   = 0;
+    const i64  count = ScanFrame( data, size, NULL, &raw );
+
+    if( count < 0 || raw > capacity || ( NULL == out && 0 != raw ) ) return 0;
+    if( 0 == count ) return 0;
+
+    jobs.blocks = (CodecBlock *)malloc( (size_t)count * sizeof( CodecBlock ) );
+    if( NULL == jobs.blocks ) return 0;
+
+    ScanFrame( data, size, jobs.blocks, NULL );
+    jobs.input       = data;
+    jobs.output      = out;
+    jobs.block_count = (u32)count;
+    jobs.job_count   = ( jobs.block_count + CODEC_JOB_BLOCKS - 1 ) / CODEC_JOB_BLOCKS;
+    RunCodecWorkers( DecompressJobs, &jobs, GetWorkerCount( threads, jobs.job_count ) );
+
+    free( jobs.blocks );
+    return jobs.failed ? 0 : raw;
+}
+
+// Open a stream; everything it produces (frame bytes or raw bytes) is handed to `write`
+CodecStream *
+OpenCodecStream( bool compress, CodecWriteCallback write, void * user )
+{
+    CodecStream * stream;
+
+    if( NULL == write ) return NULL;
+
+    stream = (CodecStream *)calloc( 1, sizeof( CodecStream ) );
+    if( NULL == stream ) return NULL;
+
+    stream->compress = compress;
+    stream->write    = write;
+    stream->user     = user;
+    stream->buffer   = (u8 *)malloc( CODEC_BLOCK_BOUND( CODEC_BLOCK_SIZE ) );
+    stream->output   = (u8 *)malloc( CODEC_BLOCK_BOUND( CODEC_BLOCK_SIZE ) );
+    if( NULL == stream->buffer || NULL == stream->output )
+        {
+            free( stream->buffer );
+            free( stream->output );
+            free( stream );
+            return NULL;
+        }
+
+    return stream;
+}
+
+// Push bytes through a stream; returns false once the stream or its callback failed
+bool
+WriteCodecStream( CodecStream * stream, const u8 * data, size_t size )
+{
+    if( NULL == stream || stream->failed ) return false;
+    if( NULL == data && 0 != size ) return false;
+
+    if( !stream->compress )
+        {
+            stream->failed = !DecompressStream( stream, data, size );
+            return !stream->failed;
+        }
+
+    if( !stream->header_done )
+        {
+            u8 magic[sizeof( u32 )];
+            Write32( magic, CODEC_MAGIC );
+            stream->header_done = true;
+            if( !stream->write( magic, sizeof( magic ), stream->user ) ) return !( stream->failed = true );
+        }
+
+    while( size > 0 )
+        {
+            size_t take;
+
+            // Whole blocks straight from the caller's buffer
+            if( 0 == stream->fill && size >= CODEC_BLOCK_SIZE )
+                {
+                    if( !FlushStreamBlock( stream, data, CODEC_BLOCK_SIZE ) ) return !( stream->failed = true );
+                    data += CODEC_BLOCK_SIZE;
+                    size -= CODEC_BLOCK_SIZE;
+                    continue;
+                }
+
+            take = CODEC_BLOCK_SIZE - stream->fill;
+            if( take > size ) take = size;
+            memcpy( stream->buffer + stream->fill, data, take );
+            stream->fill += take;
+            data         += take;
+            size         -= take;
+
+            if( CODEC_BLOCK_SIZE == stream->fill )
+                {
+                    stream->fill = 0;
+                    if( !FlushStreamBlock( stream, stream->buffer, CODEC_BLOCK_SIZE ) )
+                        return !( stream->failed = true );
+                }
+        }
+
+    return true;
+}
+
+// Finish and free a stream: a compressing stream writes its last block and the end marker,
+// a decompressing one checks that the frame was complete
+bool
+CloseCodecStream( CodecStream * stream )
+{
+    bool result;
+
+    if( NULL == stream ) return false;
+
+    result = !stream->failed;
+    if( result && stream->compress )
+        {
+            u8 end[sizeof( u32 )] = { 0 };
+
+            if( !stream->header_done ) result = WriteCodecStream( stream, NULL, 0 );
+            if( result && 0 != stream->fill ) result = FlushStreamBlock( stream, stream->buffer, stream->fill );
+            if( result ) result = stream->write( end, sizeof( end ), stream->user );
+        }
+    else if( result )
+        {
+            result = stream->ended;
+        }
+
+    free( stream->buffer );
+    free( stream->output );
+    free( stream );
+    return result;
+}
@@ -3,7 +3,7 @@
  * Module: Core
  *
  * It provides emulation initialization, CPU stepping, cycle management,
- * and runtime state control.
+ * runtime state control and resets to the power-on state.
  *
  *                               LICENSE
  * ------------------------------------------------------------------------
@@ -27,56 +27,118 @@
  *************************************************************************/
 
 #include "camecore/camecore.h"
+#include "camecore/machine.h"
 #include "camecore/utils.h"
 
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+// Machine state right after load and boot; the bus, cartridge RAM and clock are not part of it
+typedef struct PristineMachine
+{
+    bool       valid;
+    CPUContext cpu;
+    u64        ticks;
+    IOContext  io;
+    MBCState   mbc;
+    RAMContext ram;
+} PristineMachine;
+
 //----------------------------------------------------------------------------------------------------------------------
 // Global Variables Definition
 //----------------------------------------------------------------------------------------------------------------------
 static EmuContext ctx ALIGNED( 16 ) = { 0 }; // Aligned EmuContext
 static THREAD_HANDLE  cpu_thread    = { 0 };
-static MUTEX_HANDLE   ctx_mutex     = { 0 }; // Mutex to protect access to ctx
+static MUTEX_HANDLE   ctx_mutex     = { 0 };   // Mutex to protect access to ctx
+static Machine *      cpu_machine   = NULL;    // Machine run by the CPU thread
+static bool           cpu_alive     = false;   // CPU thread started and not exited yet (under ctx_mutex)
+static bool           reset_pending = false;   // ResetEmulator() request for the CPU thread (under ctx_mutex)
+
+static THREAD_LOCAL bool on_cpu_thread = false; // Set on the CPU thread, which owns the machine it runs
+
+static PristineMachine pristine_ctx = { 0 }; // Captured by InitEmulator()
+
+// Tick at which the CPU thread serves pending requests (rewind snapshots, watchpoint edits); cleared to force one
+u64 service_deadline = UINT64_MAX;
+
+extern THREAD_LOCAL Machine * machine_ctx; // The cycle counter is machine state
 
 //----------------------------------------------------------------------------------------------------------------------
 // Module Internal Functions Declarations
 //----------------------------------------------------------------------------------------------------------------------
+extern void InitRAM( void );
+extern void InitIO( void );
+extern void InitPPU( void );
+extern void UpdatePPU( void );
 extern void CPUInit( void );
 extern bool CPUStep( void );
+extern void UpdateRewind( void );
+extern void UpdateWatchpoints( void );
+extern void RestartRewind( void );
+extern void SetWRAMBank( u8 bank );
+extern void SetVRAMBank( u8 bank );
+extern void RestoreCartridgeBanks( void );
+extern void MarkAllBusPagesDirty( void );
+extern void ApplyWarmStart( void );
+
+bool IsMachineOnOtherThread( void );
 
 static THREAD_RETURN RunCPU( THREAD_PARAM param );
+static void          RestorePristine( void );
 
 //----------------------------------------------------------------------------------------------------------------------
 // Module Functions Definitions
 //----------------------------------------------------------------------------------------------------------------------
 
+// Put this thread's machine back into its power-on state, then remap the banks it selects
+// NOTE: Battery RAM and the clock live in the cartridge and survive, as on a console reset; so do watchpoints
+static void
+RestorePristine( void )
+{
+    machine_ctx->cpu      = pristine_ctx.cpu;
+    machine_ctx->ticks    = pristine_ctx.ticks;
+    machine_ctx->io       = pristine_ctx.io;
+    machine_ctx->cart.mbc = pristine_ctx.mbc;
+    machine_ctx->ram      = pristine_ctx.ram;
+
+    SetWRAMBank( machine_ctx->ram.wram_bank );
+    SetVRAMBank( machine_ctx->ram.vram_bank );
+    RestoreCartridgeBanks();
+    MarkAllBusPagesDirty();
+    InitPPU(); // Derived from the restored registers and cycle counter
+
+    if( machine_ctx == cpu_machine ) RestartRewind(); // History from before the reset no longer chains on
+}
+
 // CPU thread function
 static THREAD_RETURN
 RunCPU( THREAD_PARAM param )
 {
-    UNUSED( param );
-
-    // Initialize CPU
-    CPUInit();
-
-    // Setup context
-    MUTEX_LOCK( ctx_mutex );
-    ctx.running = true;
-    ctx.paused  = false;
-    ctx.ticks   = 0;
-    MUTEX_UNLOCK( ctx_mutex );
+    // Run the machine of the thread that started the emulation (initialized by InitEmulator)
+    SetCurrentInstance( (Machine *)param );
+    on_cpu_thread = true;
+    UpdateWatchpoints();
 
     bool running = true;
     bool paused  = false;
+    bool reset   = false;
 
     while( running )
         {
             // Check running and paused state atomically
             MUTEX_LOCK( ctx_mutex );
-            running = ctx.running;
-            paused  = ctx.paused;
+            running       = ctx.running;
+            paused        = ctx.paused;
+            reset         = reset_pending;
+            reset_pending = false;
             MUTEX_UNLOCK( ctx_mutex );
 
+            if( UNLIKELY( reset ) ) RestorePristine();
+
             if( paused )
                 {
+                    UpdateWatchpoints(); // Requests are still served while paused
+                    UpdateRewind();
                     THREAD_SLEEP( 10 );
                     continue;
                 }
@@ -90,8 +152,19 @@ RunCPU( THREAD_PARAM param )
                     MUTEX_UNLOCK( ctx_mutex );
                     break;
                 }
+
+            if( UNLIKELY( machine_ctx->ticks >= ATOMIC_LOAD( &service_deadline ) ) )
+                {
+                    UpdateWatchpoints();
+                    UpdateRewind(); // Sets the next deadline
+                }
         }
 
+    // Requests made from now on are served by their callers
+    MUTEX_LOCK( ctx_mutex );
+    cpu_alive = false;
+    MUTEX_UNLOCK( ctx_mutex );
+
 #if defined( _WIN32 ) || defined( _WIN64 )
     return 0;
 #else
@@ -108,8 +181,75 @@ InitEmulator( void )
     // Initialize mutex
     MUTEX_INIT( ctx_mutex );
 
-    // Start CPU thread
-    THREAD_CREATE( cpu_thread, RunCPU, NULL );
+    // Clear memory and map it onto the bus
+    InitRAM();
+    InitIO();
+
+    // Initialize CPU
+    CPUInit();
+    machine_ctx->ticks = 0;
+    InitPPU();
+
+    // Keep the power-on state for ResetEmulator()
+    pristine_ctx.cpu   = machine_ctx->cpu;
+    pristine_ctx.ticks = machine_ctx->ticks;
+    pristine_ctx.io    = machine_ctx->io;
+    pristine_ctx.mbc   = machine_ctx->cart.mbc;
+    pristine_ctx.ram   = machine_ctx->ram;
+    pristine_ctx.valid = true;
+
+    // Skip ahead to the warm-start checkpoint, from the on-disk cache when possible
+    ApplyWarmStart();
+
+    // Start CPU thread; the run state is set first, so pausing or stopping right away is not undone by it
+    MUTEX_LOCK( ctx_mutex );
+    ctx.running = true;
+    ctx.paused  = false;
+    cpu_machine = machine_ctx;
+    cpu_alive   = true;
+    MUTEX_UNLOCK( ctx_mutex );
+    THREAD_CREATE( cpu_thread, RunCPU, machine_ctx );
+}
+
+// Restart the calling thread's machine (the emulation, or an instance) from the state InitEmulator() left it in
+// NOTE: Restores a few fixed-size blocks; the CPU thread serves the request between two instructions, or while paused
+void
+ResetEmulator( void )
+{
+    bool pending;
+
+    if( NULL == machine_ctx || !pristine_ctx.valid ) return;
+
+    MUTEX_LOCK( ctx_mutex );
+    pending       = cpu_alive && !on_cpu_thread && machine_ctx == cpu_machine;
+    reset_pending = pending;
+    MUTEX_UNLOCK( ctx_mutex );
+
+    // Without a CPU thread on this machine (or on that thread itself), the caller owns it
+    if( !pending )
+        {
+            RestorePristine();
+            return;
+        }
+
+    // Otherwise wait for the CPU thread to take the request
+    for( ;; )
+        {
+            bool stopped;
+
+            THREAD_SLEEP( 0 );
+
+            MUTEX_LOCK( ctx_mutex );
+            pending = reset_pending;
+            stopped = !cpu_alive;
+            if( stopped ) reset_pending = false;
+            MUTEX_UNLOCK( ctx_mutex );
+
+            if( !pending ) return;
+            if( stopped ) break; // CPU stopped before serving it
+        }
+
+    RestorePristine();
 }
 
 // Step once the emulation execution (only used when paused)
@@ -147,22 +287,40 @@ StepEmulator( void )
 }
 
 // Process N CPU cycles (4 ticks/cycle: timers+PPU+APU per tick, DMA post-cycle)
+// NOTE: Only touches the calling thread's machine, so instances on other threads never contend here
 void
 AddEmulatorCycles( u32 cpu_cycles )
 {
-    MUTEX_LOCK( ctx_mutex );
     for( u32 i = 0; i < cpu_cycles; ++i )
         {
             for( int n = 0; n < 4; ++n )
                 {
-                    ++ctx.ticks;
+                    ++machine_ctx->ticks;
                     //TickTimer();
-                    //TickPPU();
                 }
 
             //TickDMA();
         }
-    MUTEX_UNLOCK( ctx_mutex );
+
+    // The PPU only runs at its mode changes
+    if( UNLIKELY( machine_ctx->ticks >= machine_ctx->ppu.deadline ) ) UpdatePPU();
+}
+
+// Run `instance` for `frames` frames on the calling thread (e.g. a worker), independently of the emulator
+// NOTE: An instance must only be run by one thread at a time
+bool
+RunInstance( Machine * instance, u32 frames )
+{
+    Machine * const previous = SetCurrentInstance( instance );
+    const u64       end      = instance->ticks + (u64)frames * FRAME_TICKS;
+    bool            result   = true;
+
+    UpdateWatchpoints(); // Edits made since the instance last ran
+
+    while( result && instance->ticks < end ) result = CPUStep();
+
+    SetCurrentInstance( previous );
+    return result;
 }
 
 // Get the current running state of the emulation
@@ -176,11 +334,28 @@ IsEmulatorRunning( void )
     return running;
 }
 
+// Check whether the CPU thread runs the calling thread's machine from another thread (otherwise the caller owns it)
+// NOTE: False on the CPU thread itself, e.g. in a watchpoint callback: requests are applied inline there
+bool
+IsMachineOnOtherThread( void )
+{
+    bool result;
+
+    if( on_cpu_thread ) return false;
+
+    MUTEX_LOCK( ctx_mutex );
+    result = ctx.running && machine_ctx == cpu_machine;
+    MUTEX_UNLOCK( ctx_mutex );
+
+    return result;
+}
+
 // Get the emulator context
 DEPRECATED EmuContext *
 GetEmulatorContext( void )
 {
     // WARN: This function is problematic for thread safety
+    if( NULL != machine_ctx ) ctx.ticks = machine_ctx->ticks;
     return &ctx;
 }
 
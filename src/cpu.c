@@ -36,6 +36,7 @@
  *************************************************************************/
 
 #include "camecore/camecore.h"
+#include "camecore/machine.h"
 #include "camecore/utils.h"
 #include <stdio.h>
 
@@ -50,13 +51,13 @@
 #define INITIAL_HL          (short)0x4D01
 
 // Flag access
-#define GET_FLAG( flag )    BIT_CHECK( cpu_ctx.regs.f, FLAG_##flag##_BIT )
+#define GET_FLAG( flag )    BIT_CHECK( machine_ctx->cpu.regs.f, FLAG_##flag##_BIT )
 #define FLAG_CHAR( flag )   ( GET_FLAG( flag ) ? #flag[0] : '-' )
 
 //----------------------------------------------------------------------------------------------------------------------
 // Global Variables Definition
 //----------------------------------------------------------------------------------------------------------------------
-CPUContext cpu_ctx = { 0 };
+extern THREAD_LOCAL Machine * machine_ctx; // CPU state lives in the machine arena
 
 //----------------------------------------------------------------------------------------------------------------------
 // Module Internal Functions Declarations
@@ -71,6 +72,9 @@ extern char *             GetInstructionName( InsType t );         // Get the gi
 extern void FetchInstruction( void ); // Fetch next instruction
 extern void FetchData( void );        // Fetch current instruction data
 
+// Bus related
+extern void MarkBusRangeDirty( u16 start, u32 size );
+
 // Debug related
 extern void Disassemble( CPUContext * cpu_ctx, char * str, size_t str_size );
 
@@ -81,6 +85,8 @@ bool CPUStep( void );
 // Registers
 u8   GetIERegister( void );
 void SetIERegister( u8 v );
+u8   GetIFRegister( void );
+void SetIFRegister( u8 v );
 
 //----------------------------------------------------------------------------------------------------------------------
 // Module Internal Functions Definitions
@@ -89,14 +95,14 @@ void SetIERegister( u8 v );
 static void
 Execute( void )
 {
-    CPUInstructionProc proc = GetInstructionProcessor( cpu_ctx.inst_state.cur_inst->type );
+    CPUInstructionProc proc = GetInstructionProcessor( machine_ctx->cpu.inst_state.cur_inst->type );
 
     if( UNLIKELY( NULL == proc ) )
         {
             NO_IMPL();
         }
 
-    proc( &cpu_ctx );
+    proc( &machine_ctx->cpu );
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -106,21 +112,25 @@ Execute( void )
 void
 CPUInit( void )
 {
-    cpu_ctx.regs.pc               = BOOT_ROM_START_ADDR;
-    cpu_ctx.regs.sp               = INITIAL_STACK_PTR;
-    *( (short *)&cpu_ctx.regs.a ) = INITIAL_AF;
-    *( (short *)&cpu_ctx.regs.b ) = INITIAL_BC;
-    *( (short *)&cpu_ctx.regs.d ) = INITIAL_DE;
-    *( (short *)&cpu_ctx.regs.h ) = INITIAL_HL;
+    machine_ctx->cpu.regs.pc               = BOOT_ROM_START_ADDR;
+    machine_ctx->cpu.regs.sp               = INITIAL_STACK_PTR;
+    *( (short *)&machine_ctx->cpu.regs.a ) = INITIAL_AF;
+    *( (short *)&machine_ctx->cpu.regs.b ) = INITIAL_BC;
+    *( (short *)&machine_ctx->cpu.regs.d ) = INITIAL_DE;
+    *( (short *)&machine_ctx->cpu.regs.h ) = INITIAL_HL;
 }
 
 // Performs a single CPU step
 bool
 CPUStep( void )
 {
-    if( false == cpu_ctx.status.halted )
+    CPUContext * const cpu = &machine_ctx->cpu;
+
+    if( false == cpu->status.halted )
         {
-            const u16 pc = cpu_ctx.regs.pc;
+#if defined( LOG_CPU_INSTR )
+            const u16 pc = cpu->regs.pc;
+#endif
 
             FetchInstruction();
             AddEmulatorCycles( 1 );
@@ -129,18 +139,18 @@ CPUStep( void )
 #if defined( LOG_CPU_INSTR )
             {
                 char inst[32];
-                Disassemble( &cpu_ctx, inst, sizeof( inst ) );
+                Disassemble( cpu, inst, sizeof( inst ) );
 
                 LOG( LOG_INFO, "%08llX PC:%04X | %s | A:%02X F:%c%c%c%c | BC:%02X%02X DE:%02X%02X HL:%02X%02X",
-                     GetEmulatorContext()->ticks, pc, inst, cpu_ctx.regs.a, FLAG_CHAR( Z ), FLAG_CHAR( N ),
-                     FLAG_CHAR( H ), FLAG_CHAR( C ), cpu_ctx.regs.b, cpu_ctx.regs.c, cpu_ctx.regs.d, cpu_ctx.regs.e,
-                     cpu_ctx.regs.h, cpu_ctx.regs.l );
+                     (unsigned long long)machine_ctx->ticks, pc, inst, cpu->regs.a, FLAG_CHAR( Z ), FLAG_CHAR( N ),
+                     FLAG_CHAR( H ), FLAG_CHAR( C ), cpu->regs.b, cpu->regs.c, cpu->regs.d, cpu->regs.e, cpu->regs.h,
+                     cpu->regs.l );
             }
 #endif
 
-            if( UNLIKELY( NULL == cpu_ctx.inst_state.cur_inst ) )
+            if( UNLIKELY( NULL == cpu->inst_state.cur_inst ) )
                 {
-                    LOG( LOG_FATAL, "Unknown Instruction! %02X\n", cpu_ctx.inst_state.cur_opcode );
+                    LOG( LOG_FATAL, "Unknown Instruction! %02X\n", cpu->inst_state.cur_opcode );
                     return false;
                 }
 
@@ -153,19 +163,34 @@ CPUStep( void )
 u8
 GetIERegister( void )
 {
-    return cpu_ctx.interupt_state.ie_reg;
+    return machine_ctx->cpu.interupt_state.ie_reg;
 }
 
 // Set the Interrupt Enable(IE) register
 void
 SetIERegister( u8 v )
 {
-    cpu_ctx.interupt_state.ie_reg = v;
+    machine_ctx->cpu.interupt_state.ie_reg = v;
+}
+
+// Get the Interrupt Flag(IF) register
+u8
+GetIFRegister( void )
+{
+    return machine_ctx->cpu.interupt_state.if_reg;
+}
+
+// Set the Interrupt Flag(IF) register
+void
+SetIFRegister( u8 v )
+{
+    machine_ctx->cpu.interupt_state.if_reg = v;
+    MarkBusRangeDirty( IO_START, IO_SIZE ); // Also raised and acknowledged outside the bus
 }
 
 // Retrieve the CPU registers pointer
 CPURegisters *
 GetRegisters( void )
 {
-    return &cpu_ctx.regs;
+    return &machine_ctx->cpu.regs;
 }
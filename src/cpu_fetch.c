@@ -33,12 +33,15 @@
  *************************************************************************/
 
 #include "camecore/camecore.h"
+#include "camecore/machine.h"
 #include "camecore/utils.h"
 
+#include <string.h>
+
 //----------------------------------------------------------------------------------------------------------------------
 // Global Variables Definition
 //----------------------------------------------------------------------------------------------------------------------
-extern CPUContext cpu_ctx;
+extern THREAD_LOCAL Machine * machine_ctx; // CPU state and the fetch window live in the machine arena
 
 //----------------------------------------------------------------------------------------------------------------------
 // Address Mode Handler Function Declarations
@@ -51,6 +54,10 @@ typedef void ( *AddressModeHandler )( void );
 // CPU Fetch
 void FetchInstruction( void );
 void FetchData( void );
+void InvalidateFetchRegion( void );
+
+extern u32 GetBusReadRegion( u16 addr, const u8 ** outBase, u16 * outStart ); // Get the direct region around addr
+extern u8  ReadBusFetch( u16 addr, bool opcode );                             // Read the instruction stream
 
 extern Instruction * GetInstructionByOpCode( u8 opcode ); // Get the given opcode `Instruction`
 extern u16           GetRegister( RegType rt );           // Get the given register data
@@ -59,19 +66,86 @@ extern void          SetRegister( RegType rt, u16 val );  // Get the given regis
 //----------------------------------------------------------------------------------------------------------------------
 // Module Internal Functions Definitions
 //----------------------------------------------------------------------------------------------------------------------
+// Load a 16-bit little-endian value from unaligned host memory
+static INLINE u16
+LoadLE16( const u8 * ptr )
+{
+#if defined( _MSC_VER ) || ( defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ )
+    u16 value;
+    memcpy( &value, ptr, sizeof( value ) );
+    return value;
+#else
+    return MAKE_WORD( ptr[1], ptr[0] );
+#endif
+}
+
+// Re-resolve the cached fetch region so that it contains `addr`
+static void
+RefreshFetchRegion( u16 addr )
+{
+    FetchRegion * const region = &machine_ctx->bus.fetch;
+
+    region->size               = GetBusReadRegion( addr, &region->base, &region->start );
+}
+
+// Fetch a byte at `addr` when it is outside of the cached region
+static u8
+FetchByteSlow( u16 addr, bool opcode )
+{
+    RefreshFetchRegion( addr );
+
+    // PC sits on a handler-backed or trapped page (I/O, HRAM, watchpoints, ...)
+    if( UNLIKELY( 0 == machine_ctx->bus.fetch.size ) ) return ReadBusFetch( addr, opcode );
+
+    return machine_ctx->bus.fetch.base[(u16)( addr - machine_ctx->bus.fetch.start )];
+}
+
+// Fetch an operand byte from the instruction stream
+static INLINE u8
+FetchByte( u16 addr )
+{
+    const FetchRegion * const region = &machine_ctx->bus.fetch;
+    const u32                 offset = (u16)( addr - region->start );
+
+    if( LIKELY( offset < region->size ) ) return region->base[offset];
+
+    return FetchByteSlow( addr, false );
+}
+
+// Fetch an opcode byte from the instruction stream
+static INLINE u8
+FetchOpcode( u16 addr )
+{
+    const FetchRegion * const region = &machine_ctx->bus.fetch;
+    const u32                 offset = (u16)( addr - region->start );
+
+    if( LIKELY( offset < region->size ) ) return region->base[offset];
+
+    return FetchByteSlow( addr, true );
+}
+
 // Fetch 16-bit little-endian from pc (lo, hi)
-static inline u16
+static INLINE u16
 FETCH_LO_HI( u16 pc )
 {
-    u8 lo;
-    u8 hi;
+    const FetchRegion * const region = &machine_ctx->bus.fetch;
+    const u32                 offset = (u16)( pc - region->start );
+    u8                        lo;
+    u8                        hi;
+
+    // Both bytes inside the cached region: a single unaligned load
+    if( LIKELY( offset + 1 < region->size ) )
+        {
+            AddEmulatorCycles( 2 );
+            return LoadLE16( region->base + offset );
+        }
 
     /* Get low byte */
-    lo = ReadBus( pc );
+    lo = FetchByte( pc );
     AddEmulatorCycles( 1 );
 
     /* Get high byte */
-    hi = ReadBus( pc + 1 );
+    hi = FetchByte( pc + 1 );
     AddEmulatorCycles( 1 );
 
     return MAKE_WORD( hi, lo );
@@ -91,52 +165,52 @@ AM_Handler_IMP( void )
 static void
 AM_Handler_R( void )
 {
-    cpu_ctx.inst_state.fetched_data = GetRegister( cpu_ctx.inst_state.cur_inst->primary_reg );
+    machine_ctx->cpu.inst_state.fetched_data = GetRegister( machine_ctx->cpu.inst_state.cur_inst->primary_reg );
 }
 
 // Register to register addressing
 static void
 AM_Handler_R_R( void )
 {
-    cpu_ctx.inst_state.fetched_data = GetRegister( cpu_ctx.inst_state.cur_inst->secondary_reg );
+    machine_ctx->cpu.inst_state.fetched_data = GetRegister( machine_ctx->cpu.inst_state.cur_inst->secondary_reg );
 }
 
 // Register + 8-bit immediate
 static void
 AM_Handler_R_D8( void )
 {
-    cpu_ctx.inst_state.fetched_data = ReadBus( cpu_ctx.regs.pc );
+    machine_ctx->cpu.inst_state.fetched_data = FetchByte( machine_ctx->cpu.regs.pc );
     AddEmulatorCycles( 1 );
-    ++cpu_ctx.regs.pc;
+    ++machine_ctx->cpu.regs.pc;
 }
 
 // Register + 16-bit immediate
 static void
 AM_Handler_R_D16( void )
 {
-    cpu_ctx.inst_state.fetched_data  = FETCH_LO_HI( cpu_ctx.regs.pc );
-    cpu_ctx.regs.pc                 += 2;
+    machine_ctx->cpu.inst_state.fetched_data  = FETCH_LO_HI( machine_ctx->cpu.regs.pc );
+    machine_ctx->cpu.regs.pc                 += 2;
 }
 
 // 16-bit immediate address
 static void
 AM_Handler_D16( void )
 {
-    cpu_ctx.inst_state.fetched_data  = FETCH_LO_HI( cpu_ctx.regs.pc );
-    cpu_ctx.regs.pc                 += 2;
+    machine_ctx->cpu.inst_state.fetched_data  = FETCH_LO_HI( machine_ctx->cpu.regs.pc );
+    machine_ctx->cpu.regs.pc                 += 2;
 }
 
 // Memory address in register + register data
 static void
 AM_Handler_MR_R( void )
 {
-    cpu_ctx.inst_state.fetched_data = GetRegister( cpu_ctx.inst_state.cur_inst->secondary_reg );
-    cpu_ctx.inst_state.mem_dest     = GetRegister( cpu_ctx.inst_state.cur_inst->primary_reg );
-    cpu_ctx.inst_state.dest_is_mem  = true;
+    machine_ctx->cpu.inst_state.fetched_data = GetRegister( machine_ctx->cpu.inst_state.cur_inst->secondary_reg );
+    machine_ctx->cpu.inst_state.mem_dest     = GetRegister( machine_ctx->cpu.inst_state.cur_inst->primary_reg );
+    machine_ctx->cpu.inst_state.dest_is_mem  = true;
 
-    if( RT_C == cpu_ctx.inst_state.cur_inst->primary_reg )
+    if( RT_C == machine_ctx->cpu.inst_state.cur_inst->primary_reg )
         {
-            cpu_ctx.inst_state.mem_dest |= 0xFF00;
+            machine_ctx->cpu.inst_state.mem_dest |= 0xFF00;
         }
 }
 
@@ -144,14 +218,14 @@ AM_Handler_MR_R( void )
 static void
 AM_Handler_R_MR( void )
 {
-    u16 addr = GetRegister( cpu_ctx.inst_state.cur_inst->secondary_reg );
+    u16 addr = GetRegister( machine_ctx->cpu.inst_state.cur_inst->secondary_reg );
 
-    if( RT_C == cpu_ctx.inst_state.cur_inst->secondary_reg )
+    if( RT_C == machine_ctx->cpu.inst_state.cur_inst->secondary_reg )
         {
             addr |= 0xFF00;
         }
 
-    cpu_ctx.inst_state.fetched_data = ReadBus( addr );
+    machine_ctx->cpu.inst_state.fetched_data = ReadBus( addr );
     AddEmulatorCycles( 1 );
 }
 
@@ -159,7 +233,8 @@ AM_Handler_R_MR( void )
 static void
 AM_Handler_R_HLI( void )
 {
-    cpu_ctx.inst_state.fetched_data = ReadBus( GetRegister( cpu_ctx.inst_state.cur_inst->secondary_reg ) );
+    machine_ctx->cpu.inst_state.fetched_data
+        = ReadBus( GetRegister( machine_ctx->cpu.inst_state.cur_inst->secondary_reg ) );
     AddEmulatorCycles( 1 );
     SetRegister( RT_HL, GetRegister( RT_HL ) + 1 );
 }
@@ -168,7 +243,8 @@ AM_Handler_R_HLI( void )
 static void
 AM_Handler_R_HLD( void )
 {
-    cpu_ctx.inst_state.fetched_data = ReadBus( GetRegister( cpu_ctx.inst_state.cur_inst->secondary_reg ) );
+    machine_ctx->cpu.inst_state.fetched_data
+        = ReadBus( GetRegister( machine_ctx->cpu.inst_state.cur_inst->secondary_reg ) );
     AddEmulatorCycles( 1 );
     SetRegister( RT_HL, GetRegister( RT_HL ) - 1 );
 }
@@ -177,9 +253,9 @@ AM_Handler_R_HLD( void )
 static void
 AM_Handler_HLI_R( void )
 {
-    cpu_ctx.inst_state.fetched_data = GetRegister( cpu_ctx.inst_state.cur_inst->secondary_reg );
-    cpu_ctx.inst_state.mem_dest     = GetRegister( cpu_ctx.inst_state.cur_inst->primary_reg );
-    cpu_ctx.inst_state.dest_is_mem  = true;
+    machine_ctx->cpu.inst_state.fetched_data = GetRegister( machine_ctx->cpu.inst_state.cur_inst->secondary_reg );
+    machine_ctx->cpu.inst_state.mem_dest     = GetRegister( machine_ctx->cpu.inst_state.cur_inst->primary_reg );
+    machine_ctx->cpu.inst_state.dest_is_mem  = true;
     SetRegister( RT_HL, GetRegister( RT_HL ) + 1 );
 }
 
@@ -187,9 +263,9 @@ AM_Handler_HLI_R( void )
 static void
 AM_Handler_HLD_R( void )
 {
-    cpu_ctx.inst_state.fetched_data = GetRegister( cpu_ctx.inst_state.cur_inst->secondary_reg );
-    cpu_ctx.inst_state.mem_dest     = GetRegister( cpu_ctx.inst_state.cur_inst->primary_reg );
-    cpu_ctx.inst_state.dest_is_mem  = true;
+    machine_ctx->cpu.inst_state.fetched_data = GetRegister( machine_ctx->cpu.inst_state.cur_inst->secondary_reg );
+    machine_ctx->cpu.inst_state.mem_dest     = GetRegister( machine_ctx->cpu.inst_state.cur_inst->primary_reg );
+    machine_ctx->cpu.inst_state.dest_is_mem  = true;
     SetRegister( RT_HL, GetRegister( RT_HL ) - 1 );
 }
 
@@ -197,49 +273,49 @@ AM_Handler_HLD_R( void )
 static void
 AM_Handler_R_A8( void )
 {
-    cpu_ctx.inst_state.fetched_data = ReadBus( cpu_ctx.regs.pc );
+    machine_ctx->cpu.inst_state.fetched_data = FetchByte( machine_ctx->cpu.regs.pc );
     AddEmulatorCycles( 1 );
-    ++cpu_ctx.regs.pc;
+    ++machine_ctx->cpu.regs.pc;
 }
 
 // 8-bit address offset + register
 static void
 AM_Handler_A8_R( void )
 {
-    cpu_ctx.inst_state.mem_dest    = ReadBus( cpu_ctx.regs.pc ) | 0xFF00;
-    cpu_ctx.inst_state.dest_is_mem = true;
+    machine_ctx->cpu.inst_state.mem_dest    = FetchByte( machine_ctx->cpu.regs.pc ) | 0xFF00;
+    machine_ctx->cpu.inst_state.dest_is_mem = true;
     AddEmulatorCycles( 1 );
-    ++cpu_ctx.regs.pc;
+    ++machine_ctx->cpu.regs.pc;
 }
 
 // HL + SP + register
 static void
 AM_Handler_HL_SPR( void )
 {
-    cpu_ctx.inst_state.fetched_data = ReadBus( cpu_ctx.regs.pc );
+    machine_ctx->cpu.inst_state.fetched_data = FetchByte( machine_ctx->cpu.regs.pc );
     AddEmulatorCycles( 1 );
-    ++cpu_ctx.regs.pc;
+    ++machine_ctx->cpu.regs.pc;
 }
 
 static void
 AM_Handler_D8( void )
 {
     // 8-bit immediate data
-    cpu_ctx.inst_state.fetched_data = ReadBus( cpu_ctx.regs.pc );
+    machine_ctx->cpu.inst_state.fetched_data = FetchByte( machine_ctx->cpu.regs.pc );
     AddEmulatorCycles( 1 );
-    ++cpu_ctx.regs.pc;
+    ++machine_ctx->cpu.regs.pc;
 }
 
 // 16-bit address + register
 static void
 AM_Handler_A16_R( void )
 {
-    u16 addr                         = FETCH_LO_HI( cpu_ctx.regs.pc );
-    cpu_ctx.inst_state.mem_dest      = addr;
-    cpu_ctx.inst_state.dest_is_mem   = true;
+    u16 addr                                 = FETCH_LO_HI( machine_ctx->cpu.regs.pc );
+    machine_ctx->cpu.inst_state.mem_dest     = addr;
+    machine_ctx->cpu.inst_state.dest_is_mem  = true;
 
-    cpu_ctx.regs.pc                 += 2;
-    cpu_ctx.inst_state.fetched_data  = GetRegister( cpu_ctx.inst_state.cur_inst->secondary_reg );
+    machine_ctx->cpu.regs.pc                += 2;
+    machine_ctx->cpu.inst_state.fetched_data = GetRegister( machine_ctx->cpu.inst_state.cur_inst->secondary_reg );
 }
 
 // Same implementation as A16_R
@@ -253,20 +329,21 @@ AM_Handler_D16_R( void )
 static void
 AM_Handler_MR_D8( void )
 {
-    cpu_ctx.inst_state.fetched_data = ReadBus( cpu_ctx.regs.pc );
+    machine_ctx->cpu.inst_state.fetched_data = FetchByte( machine_ctx->cpu.regs.pc );
     AddEmulatorCycles( 1 );
-    ++cpu_ctx.regs.pc;
-    cpu_ctx.inst_state.mem_dest    = GetRegister( cpu_ctx.inst_state.cur_inst->primary_reg );
-    cpu_ctx.inst_state.dest_is_mem = true;
+    ++machine_ctx->cpu.regs.pc;
+    machine_ctx->cpu.inst_state.mem_dest    = GetRegister( machine_ctx->cpu.inst_state.cur_inst->primary_reg );
+    machine_ctx->cpu.inst_state.dest_is_mem = true;
 }
 
 // Memory address in register
 static void
 AM_Handler_MR( void )
 {
-    cpu_ctx.inst_state.mem_dest     = GetRegister( cpu_ctx.inst_state.cur_inst->primary_reg );
-    cpu_ctx.inst_state.dest_is_mem  = true;
-    cpu_ctx.inst_state.fetched_data = ReadBus( GetRegister( cpu_ctx.inst_state.cur_inst->primary_reg ) );
+    machine_ctx->cpu.inst_state.mem_dest     = GetRegister( machine_ctx->cpu.inst_state.cur_inst->primary_reg );
+    machine_ctx->cpu.inst_state.dest_is_mem  = true;
+    machine_ctx->cpu.inst_state.fetched_data
+        = ReadBus( GetRegister( machine_ctx->cpu.inst_state.cur_inst->primary_reg ) );
     AddEmulatorCycles( 1 );
 }
 
@@ -274,10 +351,10 @@ AM_Handler_MR( void )
 static void
 AM_Handler_R_A16( void )
 {
-    u16 addr                         = FETCH_LO_HI( cpu_ctx.regs.pc );
-    cpu_ctx.regs.pc                 += 2;
+    u16 addr                                 = FETCH_LO_HI( machine_ctx->cpu.regs.pc );
+    machine_ctx->cpu.regs.pc                += 2;
 
-    cpu_ctx.inst_state.fetched_data  = ReadBus( addr );
+    machine_ctx->cpu.inst_state.fetched_data = ReadBus( addr );
     AddEmulatorCycles( 1 );
 }
 
@@ -285,8 +362,8 @@ AM_Handler_R_A16( void )
 static void
 AM_Handler_UNKNOWN( void )
 {
-    LOG( LOG_FATAL, "Unknown Addressing Mode! %d (%02X)\n", cpu_ctx.inst_state.cur_inst->addr_mode,
-         cpu_ctx.inst_state.cur_opcode );
+    LOG( LOG_FATAL, "Unknown Addressing Mode! %d (%02X)\n", machine_ctx->cpu.inst_state.cur_inst->addr_mode,
+         machine_ctx->cpu.inst_state.cur_opcode );
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -311,8 +388,16 @@ static AddressModeHandler ADDRESS_MODE_HANDLERS[] = {
 void
 FetchInstruction( void )
 {
-    cpu_ctx.inst_state.cur_opcode = ReadBus( cpu_ctx.regs.pc++ );
-    cpu_ctx.inst_state.cur_inst   = GetInstructionByOpCode( cpu_ctx.inst_state.cur_opcode );
+    machine_ctx->cpu.inst_state.cur_opcode = FetchOpcode( machine_ctx->cpu.regs.pc++ );
+    machine_ctx->cpu.inst_state.cur_inst   = GetInstructionByOpCode( machine_ctx->cpu.inst_state.cur_opcode );
+}
+
+// Drop the cached fetch region (the bus mapping behind it changed)
+// NOTE: The region belongs to the machine, so a call from any thread reaches the one running it
+void
+InvalidateFetchRegion( void )
+{
+    machine_ctx->bus.fetch.size = 0;
 }
 
 // Retrieve the current instruction data
@@ -320,13 +405,13 @@ FetchInstruction( void )
 void
 FetchData( void )
 {
-    cpu_ctx.inst_state.mem_dest    = 0;
-    cpu_ctx.inst_state.dest_is_mem = false;
+    machine_ctx->cpu.inst_state.mem_dest    = 0;
+    machine_ctx->cpu.inst_state.dest_is_mem = false;
 
-    if( UNLIKELY( NULL == cpu_ctx.inst_state.cur_inst ) ) return;
+    if( UNLIKELY( NULL == machine_ctx->cpu.inst_state.cur_inst ) ) return;
 
     // Get addressing mode from current instruction
-    AddrMode mode = cpu_ctx.inst_state.cur_inst->addr_mode;
+    AddrMode mode = machine_ctx->cpu.inst_state.cur_inst->addr_mode;
 
     // Check if mode is valid
     if( UNLIKELY( false == INDEX_VALID( mode, ADDRESS_MODE_HANDLERS ) ) )
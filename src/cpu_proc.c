@@ -510,10 +510,10 @@ ProcINC( CPUContext * cpu_ctx )
             AddEmulatorCycles( 1 );
         }
 
-    // Handle memory addressing mode (INC [HL])
+    // Handle memory addressing mode (INC [HL]); the operand was read once by the addressing mode
     if( RT_HL == cpu_ctx->inst_state.cur_inst->primary_reg && AM_MR == cpu_ctx->inst_state.cur_inst->addr_mode )
         {
-            val = ReadBus( GetRegister( RT_HL ) ) + 1;
+            val = cpu_ctx->inst_state.fetched_data + 1;
             WriteBus( GetRegister( RT_HL ), LOW_BYTE( val ) );
         }
     else
@@ -30,6 +30,7 @@
  *************************************************************************/
 
 #include "camecore/camecore.h"
+#include "camecore/machine.h"
 #include "camecore/utils.h"
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -41,7 +42,7 @@
 //----------------------------------------------------------------------------------------------------------------------
 // Global Variables Definition
 //----------------------------------------------------------------------------------------------------------------------
-extern CPUContext cpu_ctx;
+extern THREAD_LOCAL Machine * machine_ctx; // CPU state lives in the machine arena
 
 //----------------------------------------------------------------------------------------------------------------------
 // Module Internal Functions Declarations
@@ -58,22 +59,22 @@ GetRegister( RegType rt )
 {
     switch( rt )
         {
-            case RT_A:  return cpu_ctx.regs.a;
-            case RT_F:  return cpu_ctx.regs.f;
-            case RT_B:  return cpu_ctx.regs.b;
-            case RT_C:  return cpu_ctx.regs.c;
-            case RT_D:  return cpu_ctx.regs.d;
-            case RT_E:  return cpu_ctx.regs.e;
-            case RT_H:  return cpu_ctx.regs.h;
-            case RT_L:  return cpu_ctx.regs.l;
+            case RT_A:  return machine_ctx->cpu.regs.a;
+            case RT_F:  return machine_ctx->cpu.regs.f;
+            case RT_B:  return machine_ctx->cpu.regs.b;
+            case RT_C:  return machine_ctx->cpu.regs.c;
+            case RT_D:  return machine_ctx->cpu.regs.d;
+            case RT_E:  return machine_ctx->cpu.regs.e;
+            case RT_H:  return machine_ctx->cpu.regs.h;
+            case RT_L:  return machine_ctx->cpu.regs.l;
 
-            case RT_AF: return REVERSE( PTR_TO_U16( cpu_ctx.regs.a ) );
-            case RT_BC: return REVERSE( PTR_TO_U16( cpu_ctx.regs.b ) );
-            case RT_DE: return REVERSE( PTR_TO_U16( cpu_ctx.regs.d ) );
-            case RT_HL: return REVERSE( PTR_TO_U16( cpu_ctx.regs.h ) );
+            case RT_AF: return REVERSE( PTR_TO_U16( machine_ctx->cpu.regs.a ) );
+            case RT_BC: return REVERSE( PTR_TO_U16( machine_ctx->cpu.regs.b ) );
+            case RT_DE: return REVERSE( PTR_TO_U16( machine_ctx->cpu.regs.d ) );
+            case RT_HL: return REVERSE( PTR_TO_U16( machine_ctx->cpu.regs.h ) );
 
-            case RT_PC: return cpu_ctx.regs.pc;
-            case RT_SP: return cpu_ctx.regs.sp;
+            case RT_PC: return machine_ctx->cpu.regs.pc;
+            case RT_SP: return machine_ctx->cpu.regs.sp;
 
             default:    return 0;
         }
@@ -84,22 +85,22 @@ SetRegister( RegType rt, u16 val )
 {
     switch( rt )
         {
-            case RT_A:    cpu_ctx.regs.a = LOW_BYTE( val ); break;
-            case RT_F:    cpu_ctx.regs.f = LOW_BYTE( val ); break;
-            case RT_B:    cpu_ctx.regs.b = LOW_BYTE( val ); break;
-            case RT_C:    cpu_ctx.regs.c = LOW_BYTE( val ); break;
-            case RT_D:    cpu_ctx.regs.d = LOW_BYTE( val ); break;
-            case RT_E:    cpu_ctx.regs.e = LOW_BYTE( val ); break;
-            case RT_H:    cpu_ctx.regs.h = LOW_BYTE( val ); break;
-            case RT_L:    cpu_ctx.regs.l = LOW_BYTE( val ); break;
+            case RT_A:    machine_ctx->cpu.regs.a = LOW_BYTE( val ); break;
+            case RT_F:    machine_ctx->cpu.regs.f = LOW_BYTE( val ); break;
+            case RT_B:    machine_ctx->cpu.regs.b = LOW_BYTE( val ); break;
+            case RT_C:    machine_ctx->cpu.regs.c = LOW_BYTE( val ); break;
+            case RT_D:    machine_ctx->cpu.regs.d = LOW_BYTE( val ); break;
+            case RT_E:    machine_ctx->cpu.regs.e = LOW_BYTE( val ); break;
+            case RT_H:    machine_ctx->cpu.regs.h = LOW_BYTE( val ); break;
+            case RT_L:    machine_ctx->cpu.regs.l = LOW_BYTE( val ); break;
 
-            case RT_AF:   PTR_TO_U16( cpu_ctx.regs.a ) = REVERSE( val ); break;
-            case RT_BC:   PTR_TO_U16( cpu_ctx.regs.b ) = REVERSE( val ); break;
-            case RT_DE:   PTR_TO_U16( cpu_ctx.regs.d ) = REVERSE( val ); break;
-            case RT_HL:   PTR_TO_U16( cpu_ctx.regs.h ) = REVERSE( val ); break;
+            case RT_AF:   PTR_TO_U16( machine_ctx->cpu.regs.a ) = REVERSE( val ); break;
+            case RT_BC:   PTR_TO_U16( machine_ctx->cpu.regs.b ) = REVERSE( val ); break;
+            case RT_DE:   PTR_TO_U16( machine_ctx->cpu.regs.d ) = REVERSE( val ); break;
+            case RT_HL:   PTR_TO_U16( machine_ctx->cpu.regs.h ) = REVERSE( val ); break;
 
-            case RT_PC:   cpu_ctx.regs.pc = val; break;
-            case RT_SP:   cpu_ctx.regs.sp = val; break;
+            case RT_PC:   machine_ctx->cpu.regs.pc = val; break;
+            case RT_SP:   machine_ctx->cpu.regs.sp = val; break;
 
             case RT_NONE: break;
         }
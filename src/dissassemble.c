@@ -65,6 +65,8 @@ char * GetInstructionName( InsType t );
 void   FormatInstructionBytes( CPUContext * cpu_ctx, char * bytes_str, size_t bytes_str_size );
 void   Disassemble( CPUContext * cpu_ctx, char * str, size_t str_size );
 
+extern u8 ReadBusFetch( u16 addr, bool opcode ); // Read the instruction stream (operands never trip watchpoints)
+
 //----------------------------------------------------------------------------------------------------------------------
 // Module Internal Functions Definitions
 //----------------------------------------------------------------------------------------------------------------------
@@ -83,8 +85,8 @@ void
 FormatInstructionBytes( CPUContext * cpu_ctx, char * bytes_str, size_t bytes_str_size )
 {
     char str[20];
-    u16  pc     = cpu_ctx->regs.pc;
     u8   size   = cpu_ctx->inst_state.cur_inst->size;
+    u16  pc     = cpu_ctx->regs.pc - size; // Called once the operands were fetched
     u8   opcode = cpu_ctx->inst_state.cur_opcode;
 
     if( size == 1 )
@@ -93,11 +95,12 @@ FormatInstructionBytes( CPUContext * cpu_ctx, char * bytes_str, size_t bytes_str
         }
     else if( size == 2 )
         {
-            snprintf( str, sizeof( str ), "%02X %02X", opcode, ReadBus( pc + 1 ) );
+            snprintf( str, sizeof( str ), "%02X %02X", opcode, ReadBusFetch( pc + 1, false ) );
         }
     else if( size == 3 )
         {
-            snprintf( str, sizeof( str ), "%02X %02X %02X", opcode, ReadBus( pc + 1 ), ReadBus( pc + 2 ) );
+            snprintf( str, sizeof( str ), "%02X %02X %02X", opcode, ReadBusFetch( pc + 1, false ),
+                      ReadBusFetch( pc + 2, false ) );
         }
     else
         {
@@ -165,8 +168,8 @@ Disassemble( CPUContext * cpu_ctx, char * str, size_t str_size )
                           RT_LOOKUP[inst->secondary_reg] );
                 break;
             case AM_A8_R:
-                snprintf( instruction, sizeof( instruction ), "%s $%02X,%s", inst_name, ReadBus( cpu_ctx->regs.pc - 1 ),
-                          RT_LOOKUP[inst->secondary_reg] );
+                snprintf( instruction, sizeof( instruction ), "%s $%02X,%s", inst_name,
+                          ReadBusFetch( cpu_ctx->regs.pc - 1, false ), RT_LOOKUP[inst->secondary_reg] );
                 break;
             case AM_HL_SPR:
                 snprintf( instruction, sizeof( instruction ), "%s (%s),SP+%d", inst_name, RT_LOOKUP[inst->primary_reg],
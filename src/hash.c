@@ -0,0 +1,324 @@
+/****************************** CameCore *********************************
+ *
+ * Module: Hashing
+ *
+ * Content hashing used to identify ROM images (shared image cache, save states).
+ *
+ * Key Features:
+ * - ComputeHash64: XXH64-compatible 64-bit hash, four independent lanes over 32-byte stripes
+ * - ComputeHash128: XXH3-style 128-bit hash over 64-byte stripes, returning the byte sum of the
+ *   same pass (ROM global checksum); SSE2 path with results identical to the portable one
+ * - Endian-independent unaligned loads (byte-assembled, folded into plain loads by the compiler)
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *      wrote the original software. If you use this software in a product, an acknowledgment
+ *      in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#include "camecore/camecore.h"
+#include "camecore/utils.h"
+
+#include <string.h>
+
+// HASH_PORTABLE builds the plain C path only (the tests compare it with the SSE2 one)
+#if !defined( HASH_PORTABLE ) \
+    && ( defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+#    include <emmintrin.h>
+#    define HASH_SSE2
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Defines and Macros
+//----------------------------------------------------------------------------------------------------------------------
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define PRIME32_1 0x9E3779B1U
+#define PRIME32_2 0x85EBCA77U
+#define PRIME32_3 0xC2B2AE3DU
+
+#define ROTL64( x, r ) ( ( ( x ) << ( r ) ) | ( ( x ) >> ( 64 - ( r ) ) ) )
+
+#define HASH_LANES             8                                         /**< 64-bit accumulators */
+#define HASH_STRIPE_LEN        64                                        /**< Bytes consumed per stripe */
+#define HASH_STRIPES_PER_BLOCK 16                                        /**< Stripes between scrambles */
+#define HASH_BLOCK_LEN         ( HASH_STRIPE_LEN * HASH_STRIPES_PER_BLOCK ) /**< 1 KiB */
+#define HASH_SCRAMBLE_KEY      16                                        /**< Secret words used to scramble */
+
+//----------------------------------------------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------------------------------------------
+// Keys for the 128-bit hash; stripe `s` of a block keys lane `i` with word `s + i`
+// NOTE: Changing any value changes every ROM identity (caches, save states)
+static const u64 HASH_SECRET[24] ALIGNED( 16 ) = {
+    0xD78B0D7493D8670AULL, 0x7EBE00A69C7A43D4ULL, 0x81FCBFDB2B9D47AEULL, 0x6B52BA0B6BA80B06ULL,
+    0x74790DD5C651503AULL, 0x39B1AC59D383E0E5ULL, 0x81A514C8A1B4E8AAULL, 0x7561A47FA3389ADEULL,
+    0x71232D643954BB27ULL, 0x432B2AFC19AC50CEULL, 0x2DB88DA7FFC2A9B8ULL, 0xA4C73BB132E84E10ULL,
+    0x967E2D200628300FULL, 0xFC231A9D761FBB11ULL, 0x1C11CFD18132B460ULL, 0xF42E96A06961AFACULL,
+    0xF9E89967C4716567ULL, 0xCB7E9932BC61BD70ULL, 0x3DC2D6BCFCE1D50AULL, 0xA50BF0A376DA4152ULL,
+    0x4433DD163CA6CF3FULL, 0xC063177F644FA8E9ULL, 0xC05EE4B85F370E15ULL, 0xB48415DC3FC85C84ULL,
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Declarations
+//----------------------------------------------------------------------------------------------------------------------
+u64     ComputeHash64( const void * data, size_t size, u64 seed );
+RomHash ComputeHash128( const void * data, size_t size, u64 * outByteSum );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+static INLINE u64
+Load64( const u8 * p )
+{
+    return (u64)p[0] | ( (u64)p[1] << 8 ) | ( (u64)p[2] << 16 ) | ( (u64)p[3] << 24 ) | ( (u64)p[4] << 32 )
+           | ( (u64)p[5] << 40 ) | ( (u64)p[6] << 48 ) | ( (u64)p[7] << 56 );
+}
+
+static INLINE u32
+Load32( const u8 * p )
+{
+    return (u32)p[0] | ( (u32)p[1] << 8 ) | ( (u32)p[2] << 16 ) | ( (u32)p[3] << 24 );
+}
+
+static INLINE u64
+HashRound( u64 acc, u64 input )
+{
+    acc += input * PRIME64_2;
+    acc  = ROTL64( acc, 31 );
+    return acc * PRIME64_1;
+}
+
+static INLINE u64
+HashMergeRound( u64 acc, u64 value )
+{
+    acc ^= HashRound( 0, value );
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+// 64x64 -> 128-bit multiply, folded to 64 bits
+static INLINE u64
+Mul128Fold64( u64 a, u64 b )
+{
+    const u64 loLo  = ( a & 0xFFFFFFFFULL ) * ( b & 0xFFFFFFFFULL );
+    const u64 hiLo  = ( a >> 32 ) * ( b & 0xFFFFFFFFULL );
+    const u64 loHi  = ( a & 0xFFFFFFFFULL ) * ( b >> 32 );
+    const u64 hiHi  = ( a >> 32 ) * ( b >> 32 );
+    const u64 cross = ( loLo >> 32 ) + ( hiLo & 0xFFFFFFFFULL ) + loHi;
+    const u64 upper = ( hiLo >> 32 ) + ( cross >> 32 ) + hiHi;
+    const u64 lower = ( cross << 32 ) | ( loLo & 0xFFFFFFFFULL );
+
+    return lower ^ upper;
+}
+
+static INLINE u64
+Avalanche( u64 h )
+{
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+// Fold `count` stripes into the accumulators, keyed from stripe index `first`, summing every byte
+// Per lane: acc[i] += data[i ^ 1] + lo32( data[i] ^ key ) * hi32( data[i] ^ key )
+static void
+AccumulateStripes( u64 * acc, const u8 * p, u32 first, u32 count, u64 * byteSum )
+{
+#if defined( HASH_SSE2 )
+    const __m128i zero = _mm_setzero_si128();
+    __m128i       sums = _mm_setzero_si128();
+    __m128i       a[HASH_LANES / 2];
+    u64           lanes[2];
+
+    for( int j = 0; j < HASH_LANES / 2; ++j ) a[j] = _mm_loadu_si128( (const __m128i *)( acc + 2 * j ) );
+
+    for( u32 s = first; s < first + count; ++s, p += HASH_STRIPE_LEN )
+        {
+            for( int j = 0; j < HASH_LANES / 2; ++j )
+                {
+                    const __m128i d   = _mm_loadu_si128( (const __m128i *)( p + 16 * j ) );
+                    const __m128i key = _mm_loadu_si128( (const __m128i *)( HASH_SECRET + s + 2 * j ) );
+                    const __m128i k   = _mm_xor_si128( d, key );
+                    const __m128i pr  = _mm_mul_epu32( k, _mm_shuffle_epi32( k, _MM_SHUFFLE( 0, 3, 0, 1 ) ) );
+
+                    const __m128i sw  = _mm_shuffle_epi32( d, _MM_SHUFFLE( 1, 0, 3, 2 ) ); // Swap 64-bit lanes
+
+                    a[j] = _mm_add_epi64( a[j], _mm_add_epi64( pr, sw ) );
+                    sums = _mm_add_epi64( sums, _mm_sad_epu8( d, zero ) ); // Global checksum, same pass
+                }
+        }
+
+    for( int j = 0; j < HASH_LANES / 2; ++j ) _mm_storeu_si128( (__m128i *)( acc + 2 * j ), a[j] );
+
+    _mm_storeu_si128( (__m128i *)lanes, sums );
+    *byteSum += lanes[0] + lanes[1];
+#else
+    for( u32 s = first; s < first + count; ++s, p += HASH_STRIPE_LEN )
+        {
+            for( int i = 0; i < HASH_LANES; ++i )
+                {
+                    const u64 d  = Load64( p + 8 * i );
+                    const u64 k  = d ^ HASH_SECRET[s + i];
+
+                    acc[i]      += Load64( p + 8 * ( i ^ 1 ) ) + ( k & 0xFFFFFFFFULL ) * ( k >> 32 );
+                }
+
+            for( int i = 0; i < HASH_STRIPE_LEN; ++i ) *byteSum += p[i];
+        }
+#endif
+}
+
+// Once per block: keep the accumulators from saturating into low-entropy states
+static void
+ScrambleAccumulators( u64 * acc )
+{
+    for( int i = 0; i < HASH_LANES; ++i )
+        {
+            u64 a   = acc[i];
+            a      ^= a >> 47;
+            a      ^= HASH_SECRET[HASH_SCRAMBLE_KEY + i];
+            acc[i]  = a * PRIME32_1;
+        }
+}
+
+static u64
+MergeAccumulators( const u64 * acc, const u64 * key, u64 start )
+{
+    u64 h = start;
+
+    for( int i = 0; i < HASH_LANES; i += 2 ) h += Mul128Fold64( acc[i] ^ key[i], acc[i + 1] ^ key[i + 1] );
+
+    return Avalanche( h );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+u64
+ComputeHash64( const void * data, size_t size, u64 seed )
+{
+    const u8 *       p   = (const u8 *)data;
+    const u8 * const end = p + size;
+    u64              h;
+
+    if( size >= 32 )
+        {
+            const u8 * const limit = end - 32;
+            u64              v1    = seed + PRIME64_1 + PRIME64_2;
+            u64              v2    = seed + PRIME64_2;
+            u64              v3    = seed;
+            u64              v4    = seed - PRIME64_1;
+
+            // Four independent lanes keep the multipliers busy
+            do
+                {
+                    v1  = HashRound( v1, Load64( p ) );
+                    v2  = HashRound( v2, Load64( p + 8 ) );
+                    v3  = HashRound( v3, Load64( p + 16 ) );
+                    v4  = HashRound( v4, Load64( p + 24 ) );
+                    p  += 32;
+                }
+            while( p <= limit );
+
+            h = ROTL64( v1, 1 ) + ROTL64( v2, 7 ) + ROTL64( v3, 12 ) + ROTL64( v4, 18 );
+            h = HashMergeRound( h, v1 );
+            h = HashMergeRound( h, v2 );
+            h = HashMergeRound( h, v3 );
+            h = HashMergeRound( h, v4 );
+        }
+    else
+        {
+            h = seed + PRIME64_5;
+        }
+
+    h += (u64)size;
+
+    // Tail
+    for( ; p + 8 <= end; p += 8 )
+        {
+            h ^= HashRound( 0, Load64( p ) );
+            h  = ROTL64( h, 27 ) * PRIME64_1 + PRIME64_4;
+        }
+
+    if( p + 4 <= end )
+        {
+            h ^= (u64)Load32( p ) * PRIME64_1;
+            h  = ROTL64( h, 23 ) * PRIME64_2 + PRIME64_3;
+            p += 4;
+        }
+
+    for( ; p < end; ++p )
+        {
+            h ^= (u64)( *p ) * PRIME64_5;
+            h  = ROTL64( h, 11 ) * PRIME64_1;
+        }
+
+    // Avalanche
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+// Hash `data` to 128 bits in one pass, also returning the sum of all its bytes (may be NULL)
+RomHash
+ComputeHash128( const void * data, size_t size, u64 * outByteSum )
+{
+    u64        acc[HASH_LANES] ALIGNED( 16 ) = { PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+                                                 PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1 };
+    const u8 * p                             = (const u8 *)data;
+    size_t     left                          = size;
+    u64        byteSum                       = 0;
+    u32        stripes;
+    RomHash    hash;
+
+    for( ; left >= HASH_BLOCK_LEN; p += HASH_BLOCK_LEN, left -= HASH_BLOCK_LEN )
+        {
+            AccumulateStripes( acc, p, 0, HASH_STRIPES_PER_BLOCK, &byteSum );
+            ScrambleAccumulators( acc );
+        }
+
+    // Last partial block, then the last partial stripe zero-padded (the length is mixed in below)
+    stripes = (u32)( left / HASH_STRIPE_LEN );
+    if( 0 != stripes ) AccumulateStripes( acc, p, 0, stripes, &byteSum );
+
+    p    += (size_t)stripes * HASH_STRIPE_LEN;
+    left -= (size_t)stripes * HASH_STRIPE_LEN;
+    if( 0 != left )
+        {
+            u8 last[HASH_STRIPE_LEN] = { 0 };
+            memcpy( last, p, left );
+            AccumulateStripes( acc, last, stripes, 1, &byteSum );
+        }
+
+    hash.lo = MergeAccumulators( acc, HASH_SECRET, (u64)size * PRIME64_1 );
+    hash.hi = MergeAccumulators( acc, HASH_SECRET + HASH_LANES, ~( (u64)size * PRIME64_2 ) );
+
+    if( NULL != outByteSum ) *outByteSum = byteSum;
+    return hash;
+}
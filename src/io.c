@@ -6,6 +6,9 @@
  *
  * Key Features:
  * - Memory-mapped IO address management
+ * - 128-entry register table: {read handler, write handler, read mask, write mask, backing byte}
+ * - Plain storage registers bypass the handlers (a table index and a mask)
+ * - Unreadable bits read back as 1, unwritable bits are preserved
  *
  * Hardware Registers map:
  * +-----------+------------------+-----------------------------------------------+----------------+-------+
@@ -97,6 +100,7 @@
  *************************************************************************/
 
 #include "camecore/camecore.h"
+#include "camecore/machine.h"
 #include "camecore/utils.h"
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -154,23 +158,7 @@
 #define WAVE_RAM_START 0xFF30 /**< Start of wave pattern RAM */
 #define WAVE_RAM_END   0xFF3F /**< End of wave pattern RAM */
 
-// LCD Display
-#define LCDC_ADDR      0xFF40 /**< LCD control */
-#define STAT_ADDR      0xFF41 /**< LCD status */
-#define SCY_ADDR       0xFF42 /**< Viewport Y position */
-#define SCX_ADDR       0xFF43 /**< Viewport X position */
-#define LY_ADDR        0xFF44 /**< LCD Y coordinate */
-#define LYC_ADDR       0xFF45 /**< LY compare */
-#define DMA_ADDR       0xFF46 /**< OAM DMA source address & start */
-
-// Palettes (DMG only)
-#define BGP_ADDR       0xFF47 /**< BG palette data */
-#define OBP0_ADDR      0xFF48 /**< OBJ palette 0 data */
-#define OBP1_ADDR      0xFF49 /**< OBJ palette 1 data */
-
-// Window Position
-#define WY_ADDR        0xFF4A /**< Window Y position */
-#define WX_ADDR        0xFF4B /**< Window X position plus 7 */
+// LCD Display, palettes and window (LCDC_ADDR to WX_ADDR): shared with the PPU, see machine.h
 
 // CGB Mode Only
 #define KEY1_ADDR      0xFF4D /**< Prepare speed switch */
@@ -198,40 +186,249 @@
 #define PCM12_ADDR     0xFF76 /**< Audio digital outputs 1 & 2 */
 #define PCM34_ADDR     0xFF77 /**< Audio digital outputs 3 & 4 */
 
+// Register table
+#define IO_INDEX( addr ) ( ( addr ) & ( IO_SIZE - 1 ) ) /**< Table slot of an IO address */
+#define IS_CGB_ONLY( i ) ( IO_INDEX( VBK_ADDR ) == ( i ) || IO_INDEX( SVBK_ADDR ) == ( i ) ) /**< Unmapped on DMG */
+
+// Register table entry shorthands: read/write handlers, read mask, write mask, value after boot
+#define IO_RW( value )                                 { NULL, NULL, 0xFF, 0xFF, value }
+#define IO_MASKED( rmask, wmask, value )               { NULL, NULL, rmask, wmask, value }
+#define IO_HANDLED( read, write, rmask, wmask, value ) { read, write, rmask, wmask, value }
+
 //----------------------------------------------------------------------------------------------------------------------
-// Global Variables Definition
+// Module Internal Functions Declarations
 //----------------------------------------------------------------------------------------------------------------------
-// ...
+extern u8   GetIFRegister( void );
+extern void SetIFRegister( u8 v );
+extern void SetWRAMBank( u8 bank );
+extern void SetVRAMBank( u8 bank );
+extern void SwitchLCD( bool on );
+extern void CompareLY( void );
+
+void InitIO( void );
+
+static u8   ReadJoypad( u16 addr );
+static void WriteDIV( u16 addr, u8 value );
+static u8   ReadIF( u16 addr );
+static void WriteIF( u16 addr, u8 value );
+static void WriteLCDC( u16 addr, u8 value );
+static void WriteLYC( u16 addr, u8 value );
+static void WriteVBK( u16 addr, u8 value );
+static void WriteSVBK( u16 addr, u8 value );
+static u8   ReadUnmapped( u16 addr );
+static void WriteUnmapped( u16 addr, u8 value );
 
 //----------------------------------------------------------------------------------------------------------------------
-// Module Internal Functions Declarations
+// Global Variables Definition
 //----------------------------------------------------------------------------------------------------------------------
-// ...
+extern THREAD_LOCAL Machine * machine_ctx; // Live registers are in the machine arena
+
+// Register layout and DMG post-boot state; entries left out are unmapped
+// NOTE: CGB-only registers (IS_CGB_ONLY) stay unmapped (read as 0xFF) unless the cartridge runs in CGB mode
+static const IORegister IO_REGISTERS[IO_SIZE] = {
+    // Joypad & Serial
+    [IO_INDEX( JOYPAD_ADDR )] = IO_HANDLED( ReadJoypad, NULL, 0x3F, 0x30, 0x00 ),
+    [IO_INDEX( SB_ADDR )]     = IO_RW( 0x00 ),
+    [IO_INDEX( SC_ADDR )]     = IO_MASKED( 0x81, 0x81, 0x00 ),
+
+    // Timer
+    [IO_INDEX( DIV_ADDR )]    = IO_HANDLED( NULL, WriteDIV, 0xFF, 0x00, 0xAB ),
+    [IO_INDEX( TIMA_ADDR )]   = IO_RW( 0x00 ),
+    [IO_INDEX( TMA_ADDR )]    = IO_RW( 0x00 ),
+    [IO_INDEX( TAC_ADDR )]    = IO_MASKED( 0x07, 0x07, 0x00 ),
+
+    // Interrupts (backed by the CPU interrupt state)
+    [IO_INDEX( IF_ADDR )]     = IO_HANDLED( ReadIF, WriteIF, 0x1F, 0x1F, 0x00 ),
+
+    // Sound
+    [IO_INDEX( NR10_ADDR )]   = IO_MASKED( 0x7F, 0x7F, 0x00 ),
+    [IO_INDEX( NR11_ADDR )]   = IO_MASKED( 0xC0, 0xFF, 0x80 ),
+    [IO_INDEX( NR12_ADDR )]   = IO_RW( 0xF3 ),
+    [IO_INDEX( NR13_ADDR )]   = IO_MASKED( 0x00, 0xFF, 0xFF ),
+    [IO_INDEX( NR14_ADDR )]   = IO_MASKED( 0x40, 0xC7, 0x00 ),
+    [IO_INDEX( NR21_ADDR )]   = IO_MASKED( 0xC0, 0xFF, 0x00 ),
+    [IO_INDEX( NR22_ADDR )]   = IO_RW( 0x00 ),
+    [IO_INDEX( NR23_ADDR )]   = IO_MASKED( 0x00, 0xFF, 0xFF ),
+    [IO_INDEX( NR24_ADDR )]   = IO_MASKED( 0x40, 0xC7, 0x00 ),
+    [IO_INDEX( NR30_ADDR )]   = IO_MASKED( 0x80, 0x80, 0x00 ),
+    [IO_INDEX( NR31_ADDR )]   = IO_MASKED( 0x00, 0xFF, 0xFF ),
+    [IO_INDEX( NR32_ADDR )]   = IO_MASKED( 0x60, 0x60, 0x00 ),
+    [IO_INDEX( NR33_ADDR )]   = IO_MASKED( 0x00, 0xFF, 0xFF ),
+    [IO_INDEX( NR34_ADDR )]   = IO_MASKED( 0x40, 0xC7, 0x00 ),
+    [IO_INDEX( NR41_ADDR )]   = IO_MASKED( 0x00, 0x3F, 0xFF ),
+    [IO_INDEX( NR42_ADDR )]   = IO_RW( 0x00 ),
+    [IO_INDEX( NR43_ADDR )]   = IO_RW( 0x00 ),
+    [IO_INDEX( NR44_ADDR )]   = IO_MASKED( 0x40, 0xC0, 0x00 ),
+    [IO_INDEX( NR50_ADDR )]   = IO_RW( 0x77 ),
+    [IO_INDEX( NR51_ADDR )]   = IO_RW( 0xF3 ),
+    [IO_INDEX( NR52_ADDR )]   = IO_MASKED( 0x8F, 0x80, 0x81 ),
+
+    // Wave pattern RAM
+    [IO_INDEX( WAVE_RAM_START + 0x0 )] = IO_RW( 0x00 ), [IO_INDEX( WAVE_RAM_START + 0x1 )] = IO_RW( 0x00 ),
+    [IO_INDEX( WAVE_RAM_START + 0x2 )] = IO_RW( 0x00 ), [IO_INDEX( WAVE_RAM_START + 0x3 )] = IO_RW( 0x00 ),
+    [IO_INDEX( WAVE_RAM_START + 0x4 )] = IO_RW( 0x00 ), [IO_INDEX( WAVE_RAM_START + 0x5 )] = IO_RW( 0x00 ),
+    [IO_INDEX( WAVE_RAM_START + 0x6 )] = IO_RW( 0x00 ), [IO_INDEX( WAVE_RAM_START + 0x7 )] = IO_RW( 0x00 ),
+    [IO_INDEX( WAVE_RAM_START + 0x8 )] = IO_RW( 0x00 ), [IO_INDEX( WAVE_RAM_START + 0x9 )] = IO_RW( 0x00 ),
+    [IO_INDEX( WAVE_RAM_START + 0xA )] = IO_RW( 0x00 ), [IO_INDEX( WAVE_RAM_START + 0xB )] = IO_RW( 0x00 ),
+    [IO_INDEX( WAVE_RAM_START + 0xC )] = IO_RW( 0x00 ), [IO_INDEX( WAVE_RAM_START + 0xD )] = IO_RW( 0x00 ),
+    [IO_INDEX( WAVE_RAM_START + 0xE )] = IO_RW( 0x00 ), [IO_INDEX( WAVE_RAM_START + 0xF )] = IO_RW( 0x00 ),
+
+    // LCD
+    [IO_INDEX( LCDC_ADDR )]   = IO_HANDLED( NULL, WriteLCDC, 0xFF, 0xFF, 0x91 ),
+    [IO_INDEX( STAT_ADDR )]   = IO_MASKED( 0x7F, 0x78, 0x05 ),
+    [IO_INDEX( SCY_ADDR )]    = IO_RW( 0x00 ),
+    [IO_INDEX( SCX_ADDR )]    = IO_RW( 0x00 ),
+    [IO_INDEX( LY_ADDR )]     = IO_MASKED( 0xFF, 0x00, 0x00 ),
+    [IO_INDEX( LYC_ADDR )]    = IO_HANDLED( NULL, WriteLYC, 0xFF, 0xFF, 0x00 ),
+    [IO_INDEX( DMA_ADDR )]    = IO_RW( 0xFF ),
+    [IO_INDEX( BGP_ADDR )]    = IO_RW( 0xFC ),
+    [IO_INDEX( OBP0_ADDR )]   = IO_RW( 0xFF ),
+    [IO_INDEX( OBP1_ADDR )]   = IO_RW( 0xFF ),
+    [IO_INDEX( WY_ADDR )]     = IO_RW( 0x00 ),
+    [IO_INDEX( WX_ADDR )]     = IO_RW( 0x00 ),
+
+    // CGB memory banking
+    [IO_INDEX( VBK_ADDR )]    = IO_HANDLED( NULL, WriteVBK, 0x01, 0x01, 0x00 ),
+    [IO_INDEX( SVBK_ADDR )]   = IO_HANDLED( NULL, WriteSVBK, 0x07, 0x07, 0x00 ),
+};
 
 //----------------------------------------------------------------------------------------------------------------------
 // Module Internal Functions Definitions
 //----------------------------------------------------------------------------------------------------------------------
-// ...
+// Joypad: no button pressed, so the selected input lines all read high
+static u8
+ReadJoypad( u16 addr )
+{
+    // TODO: Implement gamepad state reading
+    return (u8)( 0xC0 | ( machine_ctx->io.regs[IO_INDEX( addr )].value & 0x30 ) | 0x0F );
+}
+
+// Any write to DIV resets it
+static void
+WriteDIV( u16 addr, u8 value )
+{
+    UNUSED( value );
+    machine_ctx->io.regs[IO_INDEX( addr )].value = 0;
+}
+
+// Interrupt flag lives in the CPU interrupt state
+static u8
+ReadIF( u16 addr )
+{
+    UNUSED( addr );
+    return (u8)( 0xE0 | GetIFRegister() );
+}
+
+static void
+WriteIF( u16 addr, u8 value )
+{
+    UNUSED( addr );
+    SetIFRegister( value & 0x1F );
+}
+
+// LCD control: turning the LCD on or off restarts or stops the PPU
+static void
+WriteLCDC( u16 addr, u8 value )
+{
+    const u8 previous                            = machine_ctx->io.regs[IO_INDEX( addr )].value;
+
+    machine_ctx->io.regs[IO_INDEX( addr )].value = value;
+    if( BIT_CHECK( previous ^ value, 7 ) ) SwitchLCD( BIT_CHECK( value, 7 ) );
+}
+
+// LY compare: the coincidence flag follows at once
+static void
+WriteLYC( u16 addr, u8 value )
+{
+    machine_ctx->io.regs[IO_INDEX( addr )].value = value;
+    CompareLY();
+}
+
+// VRAM bank select: repoints 8000-9FFF
+static void
+WriteVBK( u16 addr, u8 value )
+{
+    machine_ctx->io.regs[IO_INDEX( addr )].value = value & 0x01;
+    SetVRAMBank( value );
+}
+
+// WRAM bank select: repoints D000-DFFF; reads back as written even though 0 selects bank 1
+static void
+WriteSVBK( u16 addr, u8 value )
+{
+    machine_ctx->io.regs[IO_INDEX( addr )].value = value & 0x07;
+    SetWRAMBank( value );
+}
+
+// Addresses without a register
+static u8
+ReadUnmapped( u16 addr )
+{
+    UNUSED( addr );
+    LOG_LIMITED( LOG_ERROR, addr, "UNSUPPORTED IO READ %04X", addr );
+    return 0xFF;
+}
+
+static void
+WriteUnmapped( u16 addr, u8 value )
+{
+    UNUSED( addr );
+    UNUSED( value );
+    LOG_LIMITED( LOG_ERROR, addr, "UNSUPPORTED IO WRITE %04X -> %04X", addr, value );
+}
 
 //----------------------------------------------------------------------------------------------------------------------
 // Module Functions Definitions
 //----------------------------------------------------------------------------------------------------------------------
+// Reset every register to its post-boot state
+void
+InitIO( void )
+{
+    const bool         cgb  = IsCartridgeCGB();
+    IORegister * const regs = machine_ctx->io.regs;
+
+    for( int i = 0; i < IO_SIZE; ++i )
+        {
+            const IORegister * reg = &IO_REGISTERS[i];
+
+            regs[i]                = *reg;
+
+            // Entries left out of the layout table are unmapped, as are CGB registers on DMG
+            if( ( NULL == reg->read && NULL == reg->write && 0 == reg->read_mask && 0 == reg->write_mask )
+                || ( !cgb && IS_CGB_ONLY( i ) ) )
+                {
+                    regs[i].read  = ReadUnmapped;
+                    regs[i].write = WriteUnmapped;
+                }
+        }
+
+    SetIFRegister( 0x01 );
+}
+
 // Read from specified IO address
 u8
 ReadIO( u16 addr )
 {
-    if( JOYPAD_ADDR == addr )
-        {
-            // TODO: Implement gamepad state reading
-        }
+    const IORegister * reg = &machine_ctx->io.regs[IO_INDEX( addr )];
+
+    // Plain storage: no handler call
+    if( LIKELY( NULL == reg->read ) ) return (u8)( reg->value | ~reg->read_mask );
 
-    LOG( LOG_ERROR, "UNSUPPORTED IO READ %04X", addr );
-    return 0;
+    return reg->read( addr );
 }
 
-// Write to specified IO address, logs unsupported attempts
+// Write to specified IO address
 void
 WriteIO( u16 addr, u8 value )
 {
-    LOG( LOG_ERROR, "UNSUPPORTED IO WRITE %04X -> %04X", addr, value );
+    IORegister * reg = &machine_ctx->io.regs[IO_INDEX( addr )];
+
+    // Plain storage: only the writable bits change
+    if( LIKELY( NULL == reg->write ) )
+        {
+            reg->value = (u8)( ( reg->value & ~reg->write_mask ) | ( value & reg->write_mask ) );
+            return;
+        }
+
+    reg->write( addr, value );
 }
@@ -0,0 +1,605 @@
+/****************************** CameCore *********************************
+ *
+ * Module: ROM Library
+ *
+ * Builds and serves a persistent index of the cartridges found in a directory tree,
+ * without loading any ROM: only the 0100-014F header block of each file is read.
+ *
+ * Key Features:
+ * - ScanRomLibrary: Walks a directory tree and refreshes the on-disk index
+ * - Records are reused while the file mtime/size are unchanged (a stat, no read)
+ * - New or changed files are probed with a single pread() of the header, in parallel
+ * - Files whose header cannot be read are left out of the index and probed again by the next scan
+ * - LoadRomLibrary: Maps the index file as-is (fixed-size records + string table)
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *      wrote the original software. If you use this software in a product, an acknowledgment
+ *      in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#if !defined( _WIN32 ) && !defined( _WIN64 )
+#    define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "camecore/camecore.h"
+#include "camecore/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined( _WIN32 ) && !defined( _WIN64 )
+#    include <dirent.h>
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#    define LIBRARY_SCAN_SUPPORTED
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Defines and Macros
+//----------------------------------------------------------------------------------------------------------------------
+#define LIBRARY_MAGIC         0x42494C43U /**< "CLIB" */
+#define LIBRARY_VERSION       1           /**< Bump whenever RomLibraryEntry changes */
+#define LIBRARY_MAX_THREADS   32          /**< Upper bound for header probing workers */
+#define LIBRARY_FILES_PER_JOB 64          /**< Minimum pending files per extra worker */
+#define LIBRARY_PATH_LENGTH   4096        /**< Longest path handled while walking */
+
+#define LIB_HEADER_OFFSET     0x0100 /**< Header block start in the ROM */
+#define LIB_HEADER_SIZE       0x0050 /**< Header block length (0100-014F) */
+#define LIB_TITLE             0x34   /**< Offsets below are relative to the header block */
+#define LIB_TITLE_LENGTH      15
+#define LIB_CGB_FLAG          0x43
+#define LIB_SGB_FLAG          0x46
+#define LIB_TYPE              0x47
+#define LIB_ROM_SIZE          0x48
+#define LIB_RAM_SIZE          0x49
+#define LIB_CHECKSUM_END      0x4C
+#define LIB_CHECKSUM          0x4D
+#define LIB_GLOBAL_CHECKSUM   0x4E
+
+STATIC_ASSERT( 64 == sizeof( RomLibraryEntry ), "RomLibraryEntry must stay 64 bytes" );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+// Index file layout: header, `count` records, then `strings_size` bytes of paths
+typedef struct RomLibraryHeader
+{
+    u32 magic;
+    u32 version;
+    u32 count;
+    u32 strings_size;
+} RomLibraryHeader;
+
+struct RomLibrary
+{
+    u8 *                     data;   /**< Whole index file */
+    size_t                   size;   /**< Index file size */
+    bool                     mapped; /**< `data` is a file mapping rather than a heap copy */
+    const RomLibraryHeader * header;
+    const RomLibraryEntry *  entries;
+    const char *             strings;
+};
+
+// Index under construction
+typedef struct LibraryBuilder
+{
+    RomLibraryEntry * entries;
+    u32               count;
+    u32               capacity;
+    char *            strings;
+    u32               strings_size;
+    u32               strings_capacity;
+    u32 *             pending; /**< Entries that need their header probed */
+    u32               pending_count;
+    u32               pending_capacity;
+    unsigned int      next_pending; /**< Work counter shared by the probing workers */
+} LibraryBuilder;
+
+// Previous index, looked up by path to reuse unchanged records
+typedef struct LibraryLookup
+{
+    const RomLibrary * library;
+    u32 *              slots; /**< Open addressing: entry index + 1, 0 when empty */
+    u32                mask;
+} LibraryLookup;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Declarations
+//----------------------------------------------------------------------------------------------------------------------
+extern u64 ComputeHash64( const void * data, size_t size, u64 seed );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#if defined( LIBRARY_SCAN_SUPPORTED )
+// Match Game Boy ROM extensions (.gb, .gbc, .sgb), case-insensitively
+static bool
+IsRomFileName( const char * name )
+{
+    static const char * EXTENSIONS[] = { ".gb", ".gbc", ".sgb" };
+    const char *        dot          = strrchr( name, '.' );
+
+    if( NULL == dot ) return false;
+
+    for( int i = 0; i < ARRAY_LEN( EXTENSIONS ); ++i )
+        {
+            const char * ext = EXTENSIONS[i];
+            const char * c   = dot;
+
+            while( *c && *ext && ( ( *c | 0x20 ) == *ext || *c == *ext ) )
+                {
+                    ++c;
+                    ++ext;
+                }
+            if( '\0' == *c && '\0' == *ext ) return true;
+        }
+
+    return false;
+}
+
+// Ensure room for `needed` items; returns the (possibly moved) buffer, or NULL leaving `data` untouched
+static void *
+GrowBuffer( void * data, u32 * capacity, u32 needed, size_t itemSize )
+{
+    u32    newCapacity = ( 0 != *capacity ) ? *capacity : 64;
+    void * grown;
+
+    if( needed <= *capacity && NULL != data ) return data;
+    while( newCapacity < needed ) newCapacity *= 2;
+
+    grown = realloc( data, (size_t)newCapacity * itemSize );
+    if( NULL != grown ) *capacity = newCapacity;
+
+    return grown;
+}
+
+static u32
+LookupPrevious( const LibraryLookup * lookup, const char * path )
+{
+    u32 slot;
+
+    if( NULL == lookup->slots ) return 0;
+
+    slot = (u32)ComputeHash64( path, strlen( path ), 0 ) & lookup->mask;
+    while( 0 != lookup->slots[slot] )
+        {
+            const RomLibraryEntry * entry = &lookup->library->entries[lookup->slots[slot] - 1];
+            if( 0 == strcmp( GetRomLibraryPath( lookup->library, entry ), path ) ) return lookup->slots[slot];
+            slot = ( slot + 1 ) & lookup->mask;
+        }
+
+    return 0;
+}
+
+static void
+BuildLookup( LibraryLookup * lookup, const RomLibrary * library )
+{
+    const u32 count = GetRomLibraryCount( library );
+    u32       size  = 16;
+
+    memset( lookup, 0, sizeof( *lookup ) );
+    if( 0 == count ) return;
+
+    while( size < count * 2 ) size <<= 1;
+
+    lookup->slots = (u32 *)calloc( size, sizeof( u32 ) );
+    if( NULL == lookup->slots ) return;
+
+    lookup->library = library;
+    lookup->mask    = size - 1;
+
+    for( u32 i = 0; i < count; ++i )
+        {
+            const char * path = GetRomLibraryPath( library, &library->entries[i] );
+            u32          slot = (u32)ComputeHash64( path, strlen( path ), 0 ) & lookup->mask;
+
+            while( 0 != lookup->slots[slot] ) slot = ( slot + 1 ) & lookup->mask;
+            lookup->slots[slot] = i + 1;
+        }
+}
+
+// Add one file: reuse the previous record when mtime/size match, otherwise queue a header probe
+static bool
+AddLibraryFile( LibraryBuilder * builder, const LibraryLookup * lookup, const char * path, const struct stat * st )
+{
+    const u32         length = (u32)strlen( path ) + 1;
+    const u64         mtime  = (u64)st->st_mtim.tv_sec * 1000000000ULL + (u64)st->st_mtim.tv_nsec;
+    const u32         prev   = LookupPrevious( lookup, path );
+    RomLibraryEntry * entries;
+    RomLibraryEntry * entry;
+    char *            strings;
+
+    entries = GrowBuffer( builder->entries, &builder->capacity, builder->count + 1, sizeof( RomLibraryEntry ) );
+    if( NULL == entries ) return false;
+    builder->entries = entries;
+
+    strings = GrowBuffer( builder->strings, &builder->strings_capacity, builder->strings_size + length, 1 );
+    if( NULL == strings ) return false;
+    builder->strings = strings;
+
+    entry            = &builder->entries[builder->count];
+
+    if( 0 != prev && lookup->library->entries[prev - 1].mtime_ns == mtime
+        && lookup->library->entries[prev - 1].file_size == (u64)st->st_size )
+        {
+            *entry = lookup->library->entries[prev - 1];
+        }
+    else
+        {
+            u32 * pending = GrowBuffer( builder->pending, &builder->pending_capacity, builder->pending_count + 1,
+                                        sizeof( u32 ) );
+            if( NULL == pending ) return false;
+            builder->pending = pending;
+
+            memset( entry, 0, sizeof( *entry ) );
+            entry->mtime_ns                            = mtime;
+            entry->file_size                           = (u64)st->st_size;
+            builder->pending[builder->pending_count++] = builder->count;
+        }
+
+    entry->path_offset = builder->strings_size;
+    memcpy( builder->strings + builder->strings_size, path, length );
+    builder->strings_size += length;
+    ++builder->count;
+
+    return true;
+}
+
+// Walk `directory` depth-first without recursion, adding every ROM file
+static bool
+WalkLibraryDirectory( LibraryBuilder * builder, const LibraryLookup * lookup, const char * directory )
+{
+    char ** stack    = NULL;
+    u32     depth    = 0;
+    u32     capacity = 0;
+    bool    result   = true;
+
+    stack = GrowBuffer( NULL, &capacity, 1, sizeof( char * ) );
+    if( NULL == stack ) return false;
+    stack[depth++] = strdup( directory );
+
+    while( depth > 0 )
+        {
+            char *          current = stack[--depth];
+            DIR *           dir     = ( NULL != current ) ? opendir( current ) : NULL;
+            struct dirent * item;
+
+            if( NULL == dir )
+                {
+                    if( NULL != current ) LOG( LOG_WARNING, "LIBRARY: [%s] Failed to open directory", current );
+                    free( current );
+                    continue;
+                }
+
+            while( result && NULL != ( item = readdir( dir ) ) )
+                {
+                    char        path[LIBRARY_PATH_LENGTH];
+                    struct stat st;
+
+                    if( '.' == item->d_name[0] ) continue; // ".", ".." and hidden entries
+
+                    if( (int)sizeof( path ) <= snprintf( path, sizeof( path ), "%s/%s", current, item->d_name ) )
+                        continue;
+
+                    // Do not follow symlinked directories (loops); symlinked files are fine
+                    if( 0 != lstat( path, &st ) ) continue;
+                    if( S_ISLNK( st.st_mode ) && 0 != stat( path, &st ) ) continue;
+
+                    if( S_ISDIR( st.st_mode ) )
+                        {
+                            char ** grown = GrowBuffer( stack, &capacity, depth + 1, sizeof( char * ) );
+                            if( NULL == grown )
+                                {
+                                    result = false;
+                                    break;
+                                }
+                            stack          = grown;
+                            stack[depth++] = strdup( path );
+                        }
+                    else if( S_ISREG( st.st_mode ) && IsRomFileName( item->d_name )
+                             && st.st_size >= LIB_HEADER_OFFSET + LIB_HEADER_SIZE )
+                        {
+                            result = AddLibraryFile( builder, lookup, path, &st );
+                        }
+                }
+
+            closedir( dir );
+            free( current );
+        }
+
+    while( depth > 0 ) free( stack[--depth] );
+    free( stack );
+    return result;
+}
+
+// Decode a header block into a record
+static void
+DecodeLibraryHeader( RomLibraryEntry * entry, const u8 * header )
+{
+    u8 checksum = 0;
+
+    for( int i = LIB_TITLE; i <= LIB_CHECKSUM_END; ++i ) checksum = (u8)( checksum - header[i] - 1 );
+
+    for( int i = 0; i < LIB_TITLE_LENGTH && '\0' != header[LIB_TITLE + i]; ++i )
+        {
+            entry->title[i] = (char)header[LIB_TITLE + i];
+        }
+
+    entry->type            = header[LIB_TYPE];
+    entry->rom_size        = header[LIB_ROM_SIZE];
+    entry->ram_size        = header[LIB_RAM_SIZE];
+    entry->cgb_flag        = header[LIB_CGB_FLAG];
+    entry->sgb_flag        = header[LIB_SGB_FLAG];
+    entry->header_checksum = header[LIB_CHECKSUM];
+    entry->header_valid    = ( checksum == header[LIB_CHECKSUM] );
+    entry->global_checksum = MAKE_WORD( header[LIB_GLOBAL_CHECKSUM], header[LIB_GLOBAL_CHECKSUM + 1] );
+    entry->header_hash     = ComputeHash64( header, LIB_HEADER_SIZE, entry->file_size );
+}
+
+// Worker: probe pending headers until the shared counter runs out
+static THREAD_RETURN
+ProbeLibraryHeaders( THREAD_PARAM param )
+{
+    LibraryBuilder * builder = (LibraryBuilder *)param;
+    unsigned int     next;
+
+    while( ( next = ATOMIC_INC( &builder->next_pending ) - 1 ) < builder->pending_count )
+        {
+            RomLibraryEntry * entry = &builder->entries[builder->pending[next]];
+            u8                header[LIB_HEADER_SIZE];
+            const int         fd    = open( builder->strings + entry->path_offset, O_RDONLY );
+
+            // Unreadable files are dropped (file_size 0) and probed again by the next scan
+            if( fd < 0 )
+                {
+                    entry->file_size = 0;
+                    continue;
+                }
+            if( LIB_HEADER_SIZE == pread( fd, header, LIB_HEADER_SIZE, LIB_HEADER_OFFSET ) )
+                DecodeLibraryHeader( entry, header );
+            else
+                entry->file_size = 0;
+            close( fd );
+        }
+
+    return 0;
+}
+
+// Remove the records whose probe failed, along with their paths
+// NOTE: Paths are appended in record order, so both arrays compact in place
+static void
+DropFailedEntries( LibraryBuilder * builder )
+{
+    u32 count       = 0;
+    u32 stringsSize = 0;
+
+    for( u32 i = 0; i < builder->count; ++i )
+        {
+            RomLibraryEntry * entry  = &builder->entries[i];
+            const char *      path   = builder->strings + entry->path_offset;
+            const u32         length = (u32)strlen( path ) + 1;
+
+            if( 0 == entry->file_size ) continue;
+
+            entry->path_offset = stringsSize;
+            memmove( builder->strings + stringsSize, path, length );
+            stringsSize += length;
+
+            builder->entries[count++] = *entry;
+        }
+
+    if( count != builder->count ) LOG( LOG_WARNING, "LIBRARY: %u ROMs could not be read", builder->count - count );
+
+    builder->count        = count;
+    builder->strings_size = stringsSize;
+}
+
+static void
+ProbePendingHeaders( LibraryBuilder * builder )
+{
+    THREAD_HANDLE threads[LIBRARY_MAX_THREADS];
+    long          cores   = sysconf( _SC_NPROCESSORS_ONLN );
+    u32           workers = builder->pending_count / LIBRARY_FILES_PER_JOB + 1;
+    u32           started = 0;
+
+    if( 0 == builder->pending_count ) return;
+
+    if( cores < 1 ) cores = 1;
+    if( workers > (u32)cores ) workers = (u32)cores;
+    if( workers > LIBRARY_MAX_THREADS ) workers = LIBRARY_MAX_THREADS;
+
+    // The calling thread is one of the workers
+    for( u32 i = 1; i < workers; ++i )
+        {
+            if( 0 == THREAD_CREATE( threads[started], ProbeLibraryHeaders, builder ) ) ++started;
+        }
+
+    ProbeLibraryHeaders( builder );
+
+    for( u32 i = 0; i < started; ++i ) THREAD_JOIN( threads[i] );
+}
+
+// Write the index next to its destination, then rename it over (readers never see a torn file)
+static bool
+WriteLibraryIndex( const LibraryBuilder * builder, const char * indexPath )
+{
+    const size_t     entriesSize = (size_t)builder->count * sizeof( RomLibraryEntry );
+    const size_t     size        = sizeof( RomLibraryHeader ) + entriesSize + builder->strings_size;
+    RomLibraryHeader header      = { LIBRARY_MAGIC, LIBRARY_VERSION, builder->count, builder->strings_size };
+    char             tempPath[LIBRARY_PATH_LENGTH];
+    u8 *             data;
+    bool             result;
+
+    if( (int)sizeof( tempPath ) <= snprintf( tempPath, sizeof( tempPath ), "%s.tmp", indexPath ) ) return false;
+
+    data = (u8 *)malloc( size );
+    if( NULL == data ) return false;
+
+    memcpy( data, &header, sizeof( header ) );
+    if( 0 != entriesSize ) memcpy( data + sizeof( header ), builder->entries, entriesSize );
+    if( 0 != builder->strings_size )
+        memcpy( data + sizeof( header ) + entriesSize, builder->strings, builder->strings_size );
+
+    result = SaveFileData( tempPath, data, size ) && 0 == rename( tempPath, indexPath );
+    free( data );
+
+    return result;
+}
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Scan `directory` recursively and refresh the index at `indexPath`
+// NOTE: Unchanged files (same mtime and size) cost a stat; only new or modified ones are read
+bool
+ScanRomLibrary( const char * directory, const char * indexPath )
+{
+#if defined( LIBRARY_SCAN_SUPPORTED )
+    LibraryBuilder builder  = { 0 };
+    LibraryLookup  lookup   = { 0 };
+    RomLibrary *   previous = NULL;
+    bool           result;
+
+    if( !IS_STR_VALID( directory ) || !IS_STR_VALID( indexPath ) )
+        {
+            LOG( LOG_ERROR, "LIBRARY: Invalid scan arguments" );
+            return false;
+        }
+
+    // Silently start from scratch when there is no usable index yet
+    {
+        FILE * const file = fopen( indexPath, "rb" );
+        if( NULL != file )
+            {
+                fclose( file );
+                previous = LoadRomLibrary( indexPath );
+            }
+    }
+    BuildLookup( &lookup, previous );
+
+    result = WalkLibraryDirectory( &builder, &lookup, directory );
+    if( result )
+        {
+            ProbePendingHeaders( &builder );
+            DropFailedEntries( &builder );
+            result = WriteLibraryIndex( &builder, indexPath );
+        }
+
+    LOG( LOG_INFO, "LIBRARY: [%s] %u ROMs indexed (%u probed)", directory, builder.count, builder.pending_count );
+
+    free( lookup.slots );
+    UnloadRomLibrary( previous );
+    free( builder.entries );
+    free( builder.strings );
+    free( builder.pending );
+
+    return result;
+#else
+    UNUSED( directory );
+    UNUSED( indexPath );
+    LOG( LOG_WARNING, "LIBRARY: Directory scanning is not supported on this platform" );
+    return false;
+#endif
+}
+
+// Check the header and bounds of a loaded index, resolving its sections
+static bool
+ResolveRomLibrary( RomLibrary * library )
+{
+    size_t entriesSize;
+
+    if( NULL == library->data || library->size < sizeof( RomLibraryHeader ) ) return false;
+
+    library->header = (const RomLibraryHeader *)library->data;
+    if( LIBRARY_MAGIC != library->header->magic || LIBRARY_VERSION != library->header->version ) return false;
+
+    entriesSize = (size_t)library->header->count * sizeof( RomLibraryEntry );
+    if( library->size != sizeof( RomLibraryHeader ) + entriesSize + library->header->strings_size ) return false;
+
+    library->entries = (const RomLibraryEntry *)( library->data + sizeof( RomLibraryHeader ) );
+    library->strings = (const char *)( library->data + sizeof( RomLibraryHeader ) + entriesSize );
+
+    // Paths must stay inside the string table
+    if( 0 != library->header->strings_size && '\0' != library->strings[library->header->strings_size - 1] )
+        return false;
+
+    for( u32 i = 0; i < library->header->count; ++i )
+        {
+            if( library->entries[i].path_offset >= library->header->strings_size ) return false;
+        }
+
+    return true;
+}
+
+// Load an index built by ScanRomLibrary (mapped read-only when possible)
+RomLibrary *
+LoadRomLibrary( const char * indexPath )
+{
+    RomLibrary * library = (RomLibrary *)calloc( 1, sizeof( RomLibrary ) );
+
+    if( NULL == library ) return NULL;
+
+    library->data   = MapFileData( indexPath, &library->size );
+    library->mapped = ( NULL != library->data );
+    if( !library->mapped ) library->data = LoadFileData( indexPath, &library->size );
+
+    if( !ResolveRomLibrary( library ) )
+        {
+            LOG( LOG_WARNING, "LIBRARY: [%s] Invalid or outdated index", indexPath );
+            UnloadRomLibrary( library );
+            return NULL;
+        }
+
+    return library;
+}
+
+void
+UnloadRomLibrary( RomLibrary * library )
+{
+    if( NULL == library ) return;
+
+    if( library->mapped )
+        UnmapFileData( library->data, library->size );
+    else
+        free( library->data );
+
+    free( library );
+}
+
+u32
+GetRomLibraryCount( const RomLibrary * library )
+{
+    return ( NULL != library && NULL != library->header ) ? library->header->count : 0;
+}
+
+const RomLibraryEntry *
+GetRomLibraryEntry( const RomLibrary * library, u32 index )
+{
+    return ( index < GetRomLibraryCount( library ) ) ? &library->entries[index] : NULL;
+}
+
+const char *
+GetRomLibraryPath( const RomLibrary * library, const RomLibraryEntry * entry )
+{
+    return ( NULL != library && NULL != entry ) ? library->strings + entry->path_offset : NULL;
+}
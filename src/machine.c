@@ -0,0 +1,417 @@
+/****************************** CameCore *********************************
+ *
+ * Module: Machine
+ *
+ * Allocation and copying of the `Machine` arena that holds all emulated state.
+ *
+ * Key Features:
+ * - InitMachine: Allocates the arena on first use (zeroed, page aligned)
+ * - Huge pages where available (Linux transparent huge pages), fewer TLB misses on RAM accesses
+ * - CopyMachine: One memcpy plus a rebase of the page table pointers that point into the arena
+ * - ForkInstance: Copy-on-write clone; parent and child share every page until one of them writes it
+ * - ResetMachineRange: Puts fresh zero pages back under a range a file was mapped onto
+ * - Thread-local current machine, so several instances can run side by side on different threads
+ *
+ * Forking (Linux) moves the parent's contents into an in-memory image file once, then maps both parent and
+ * child privately over it. Later forks of an unchanged parent only map the image again; pages the parent
+ * wrote in the meantime (found through /proc/self/pagemap) are the only ones copied.
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *      wrote the original software. If you use this software in a product, an acknowledgment
+ *      in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#if !defined( _WIN32 ) && !defined( _WIN64 )
+#    define _DEFAULT_SOURCE // MAP_ANONYMOUS, madvise()
+#    define _GNU_SOURCE     // memfd_create()
+#endif
+
+#include "camecore/camecore.h"
+#include "camecore/machine.h"
+#include "camecore/utils.h"
+
+#include <string.h>
+
+#if !defined( _WIN32 ) && !defined( _WIN64 )
+#    include <sys/mman.h>
+#    if !defined( MAP_ANONYMOUS ) && defined( MAP_ANON )
+#        define MAP_ANONYMOUS MAP_ANON
+#    endif
+#    define MACHINE_MMAP_SUPPORTED
+#    if defined( __linux__ ) && defined( MFD_CLOEXEC )
+#        include <fcntl.h>
+#        define MACHINE_COW_SUPPORTED
+#    endif
+#else
+#    include <windows.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Defines and Macros
+//----------------------------------------------------------------------------------------------------------------------
+#define HUGE_PAGE_SIZE 0x200000 /**< Transparent huge page size (x86-64/ARM64 with 4 KiB base pages) */
+
+// Size reserved for one arena: whole huge pages, so the arena can be backed by them
+#define MACHINE_ARENA_SIZE ( ( sizeof( Machine ) + HUGE_PAGE_SIZE - 1 ) & ~(size_t)( HUGE_PAGE_SIZE - 1 ) )
+
+// Part of the arena shared copy-on-write between forks
+#define MACHINE_IMAGE_SIZE  ( ( sizeof( Machine ) + MACHINE_PAGE_SIZE - 1 ) & ~(size_t)( MACHINE_PAGE_SIZE - 1 ) )
+#define MACHINE_IMAGE_PAGES ( MACHINE_IMAGE_SIZE / MACHINE_PAGE_SIZE )
+
+// Bookkeeping lives in the last page of the reservation, outside the shared image
+#define MACHINE_BACKING_OFFSET ( MACHINE_ARENA_SIZE - MACHINE_PAGE_SIZE )
+
+// /proc/self/pagemap entry bits
+#define BIT64( n )      ( (u64)1 << ( n ) )
+#define PAGEMAP_PRESENT BIT64( 63 ) /**< Page is in memory */
+#define PAGEMAP_SWAPPED BIT64( 62 ) /**< Page is in swap (only private pages are swapped) */
+#define PAGEMAP_FILE    BIT64( 61 ) /**< Page still belongs to the mapped file (not copied on write) */
+
+STATIC_ASSERT( MACHINE_IMAGE_SIZE <= MACHINE_BACKING_OFFSET, "Machine arena has no room for its backing page" );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+// Where the pages of an arena come from; one per arena, never shared or copied
+typedef struct MachineBacking
+{
+    bool   has_image;   // Clean pages are mapped privately from `image`
+    int    image;       // Image file descriptor, owned by this arena
+    u8 *   pinned;      // Range mapped from a file of its own (battery RAM); never read from the image
+    size_t pinned_size;
+} MachineBacking;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------------------------------------------
+THREAD_LOCAL Machine * machine_ctx = NULL; // Arena of the machine run by this thread
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Declarations
+//----------------------------------------------------------------------------------------------------------------------
+bool      InitMachine( void );
+Machine * CreateMachine( void );
+void      DestroyMachine( Machine * machine );
+void      CopyMachine( Machine * dst, const Machine * src );
+void      ResetMachineRange( u8 * data, size_t size );
+void      PinMachineRange( u8 * data, size_t size );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Shift every page table pointer that points into `src` so that it points into `dst`; drop the fetch window
+static void
+RebasePageTable( BusContext * bus, const Machine * src, const Machine * dst )
+{
+    const u8 * const begin = (const u8 *)src;
+    const u8 * const end   = begin + sizeof( Machine );
+    u8 ** const      maps[] = { bus->read_map, bus->write_map, bus->read_direct, bus->write_direct };
+
+    for( int m = 0; m < ARRAY_LEN( maps ); ++m )
+        {
+            for( u32 page = 0; page < BUS_PAGE_COUNT; ++page )
+                {
+                    const u8 * const ptr = maps[m][page];
+
+                    if( ptr >= begin && ptr < end ) maps[m][page] = (u8 *)dst + ( ptr - begin );
+                }
+        }
+
+    bus->fetch.size = 0; // Refilled from the rebased maps on the next fetch
+}
+
+static INLINE MachineBacking *
+GetBacking( const Machine * machine )
+{
+    return (MachineBacking *)( (u8 *)machine + MACHINE_BACKING_OFFSET );
+}
+
+#if defined( MACHINE_COW_SUPPORTED )
+// Map part of an image file privately: reads see the file, the first write to a page copies it
+static bool
+MapImage( u8 * address, size_t size, int image, size_t offset )
+{
+    if( 0 == size ) return true;
+
+    return MAP_FAILED
+           != mmap( address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, image, (off_t)offset );
+}
+
+// Move the arena's contents into an image file and map the arena over it (the pinned range stays as is)
+// NOTE: Contents are unchanged, but the machine must not run meanwhile
+static bool
+SealMachine( Machine * machine )
+{
+    MachineBacking * const backing = GetBacking( machine );
+    u8 * const             base    = (u8 *)machine;
+    const int              image   = memfd_create( "camecore-machine", MFD_CLOEXEC );
+    size_t                 pinBegin;
+    size_t                 pinEnd;
+    size_t                 written = 0;
+
+    if( image < 0 ) return false;
+
+    while( written < MACHINE_IMAGE_SIZE )
+        {
+            const ssize_t n = write( image, base + written, MACHINE_IMAGE_SIZE - written );
+            if( n <= 0 )
+                {
+                    close( image );
+                    return false;
+                }
+            written += (size_t)n;
+        }
+
+    pinBegin = ( NULL != backing->pinned ) ? (size_t)( backing->pinned - base ) : MACHINE_IMAGE_SIZE;
+    pinEnd   = ( NULL != backing->pinned ) ? pinBegin + backing->pinned_size : MACHINE_IMAGE_SIZE;
+    if( pinEnd > MACHINE_IMAGE_SIZE ) pinEnd = MACHINE_IMAGE_SIZE;
+
+    if( !MapImage( base, pinBegin, image, 0 )
+        || !MapImage( base + pinEnd, MACHINE_IMAGE_SIZE - pinEnd, image, pinEnd ) )
+        {
+            // The pages mapped so far hold the same bytes; only the sharing is lost
+            LOG( LOG_WARNING, "MACHINE: Failed to map the arena over its image" );
+            close( image );
+            return false;
+        }
+
+    backing->image     = image;
+    backing->has_image = true;
+    return true;
+}
+
+// Flag the pages of a sealed arena that no longer come from its image (written since, or pinned)
+// NOTE: Without pagemap access every page is reported, which degrades forking to a full copy
+static void
+GetPrivatePages( const Machine * machine, bool * pages )
+{
+    const MachineBacking * const backing = GetBacking( machine );
+    u64                          entries[MACHINE_IMAGE_PAGES];
+    const size_t                 size   = sizeof( entries );
+    const off_t                  first  = (off_t)( (uintptr_t)machine / MACHINE_PAGE_SIZE ) * (off_t)sizeof( u64 );
+    const int                    fd     = ( MACHINE_PAGE_SIZE == sysconf( _SC_PAGESIZE ) )
+                                              ? open( "/proc/self/pagemap", O_RDONLY | O_CLOEXEC )
+                                              : -1;
+    const bool                   loaded = fd >= 0 && (ssize_t)size == pread( fd, entries, size, first );
+
+    if( fd >= 0 ) close( fd );
+
+    for( size_t i = 0; i < MACHINE_IMAGE_PAGES; ++i )
+        {
+            const u8 * const page = (const u8 *)machine + i * MACHINE_PAGE_SIZE;
+
+            pages[i] = !loaded || ( entries[i] & PAGEMAP_SWAPPED )
+                    || ( ( entries[i] & PAGEMAP_PRESENT ) && !( entries[i] & PAGEMAP_FILE ) )
+                    || ( page >= backing->pinned && page < backing->pinned + backing->pinned_size );
+        }
+}
+
+// Share the parent's image with a fresh arena, then copy the pages the parent changed since it was sealed
+static bool
+ForkPages( Machine * child, Machine * parent )
+{
+    const MachineBacking * const from = GetBacking( parent );
+    MachineBacking * const       to   = GetBacking( child );
+    bool                         pages[MACHINE_IMAGE_PAGES];
+    int                          image;
+
+    if( !from->has_image && !SealMachine( parent ) ) return false;
+
+    // Map before touching the child: a first write to the still whole anonymous arena would fault in a huge page
+    image = dup( from->image );
+    if( image < 0 ) return false;
+    if( !MapImage( (u8 *)child, MACHINE_IMAGE_SIZE, image, 0 ) )
+        {
+            close( image );
+            return false;
+        }
+    to->image     = image;
+    to->has_image = true;
+
+    GetPrivatePages( parent, pages );
+    for( size_t i = 0; i < MACHINE_IMAGE_PAGES; ++i )
+        {
+            const size_t offset = i * MACHINE_PAGE_SIZE;
+
+            if( pages[i] ) memcpy( (u8 *)child + offset, (const u8 *)parent + offset, MACHINE_PAGE_SIZE );
+        }
+
+    return true;
+}
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Allocate the running machine's arena unless it already exists
+bool
+InitMachine( void )
+{
+    if( NULL == machine_ctx ) machine_ctx = CreateMachine();
+
+    return NULL != machine_ctx;
+}
+
+// Allocate a zeroed arena, on huge pages where the platform offers them
+Machine *
+CreateMachine( void )
+{
+    void * arena;
+
+#if defined( MACHINE_MMAP_SUPPORTED )
+    u8 *   raw;
+    size_t head;
+
+    // Over-allocate by one huge page and trim, so the arena starts on a huge page boundary
+    raw = (u8 *)mmap( NULL, MACHINE_ARENA_SIZE + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1, 0 );
+    if( MAP_FAILED == (void *)raw )
+        {
+            LOG( LOG_ERROR, "MACHINE: Failed to allocate %zu bytes", (size_t)MACHINE_ARENA_SIZE );
+            return NULL;
+        }
+
+    head = ( HUGE_PAGE_SIZE - ( (size_t)raw & ( HUGE_PAGE_SIZE - 1 ) ) ) & ( HUGE_PAGE_SIZE - 1 );
+    if( 0 != head ) munmap( raw, head );
+    munmap( raw + head + MACHINE_ARENA_SIZE, HUGE_PAGE_SIZE - head );
+    arena = raw + head;
+
+#    if defined( MADV_HUGEPAGE )
+    madvise( arena, MACHINE_ARENA_SIZE, MADV_HUGEPAGE ); // Advisory: a refusal only costs TLB misses
+#    endif
+#else
+    arena = VirtualAlloc( NULL, MACHINE_ARENA_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE );
+    if( NULL == arena )
+        {
+            LOG( LOG_ERROR, "MACHINE: Failed to allocate %zu bytes", (size_t)MACHINE_ARENA_SIZE );
+            return NULL;
+        }
+#endif
+
+    LOG( LOG_DEBUG, "MACHINE: Arena of %zu bytes at %p", sizeof( Machine ), arena );
+    return (Machine *)arena;
+}
+
+// Release an arena returned by CreateMachine()
+void
+DestroyMachine( Machine * machine )
+{
+    if( NULL == machine ) return;
+
+#if defined( MACHINE_MMAP_SUPPORTED )
+    if( GetBacking( machine )->has_image ) close( GetBacking( machine )->image );
+    munmap( machine, MACHINE_ARENA_SIZE );
+#else
+    VirtualFree( machine, 0, MEM_RELEASE );
+#endif
+}
+
+// Copy the complete machine state; the copy runs independently of `src`
+// NOTE: A copy onto the same arena (restore) needs no rebase and is a plain memcpy
+void
+CopyMachine( Machine * dst, const Machine * src )
+{
+    if( dst == src ) return;
+
+    memcpy( dst, src, sizeof( Machine ) );
+    RebasePageTable( &dst->bus, src, dst );
+}
+
+// Replace a page-aligned range of the arena (a file mapping) with zeroed anonymous memory
+void
+ResetMachineRange( u8 * data, size_t size )
+{
+    MachineBacking * const backing = GetBacking( machine_ctx );
+
+    if( data == backing->pinned ) backing->pinned = NULL;
+
+#if defined( MACHINE_MMAP_SUPPORTED )
+    if( MAP_FAILED == mmap( data, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0 ) )
+        {
+            LOG( LOG_ERROR, "MACHINE: Failed to reset %zu bytes at %p", size, (void *)data );
+        }
+#else
+    memset( data, 0, size );
+#endif
+}
+
+// Record that a page-aligned range of this thread's arena was mapped from a file of its own
+void
+PinMachineRange( u8 * data, size_t size )
+{
+    MachineBacking * const backing = GetBacking( machine_ctx );
+
+    backing->pinned      = data;
+    backing->pinned_size = size;
+}
+
+// Clone a machine: the child shares every page with `src` until either one writes it
+// NOTE: `src` (NULL: the calling thread's machine) must not be running while it is forked
+Machine *
+ForkInstance( const Machine * src )
+{
+    Machine * child;
+
+    if( NULL == src ) src = machine_ctx;
+    if( NULL == src ) return NULL;
+
+    child = CreateMachine();
+    if( NULL == child ) return NULL;
+
+#if defined( MACHINE_COW_SUPPORTED )
+    // Sealing remaps `src` in place without changing a byte of it
+    if( ForkPages( child, (Machine *)src ) )
+        {
+            RebasePageTable( &child->bus, src, child );
+            return child;
+        }
+#endif
+
+    CopyMachine( child, src );
+    return child;
+}
+
+// Release an instance returned by ForkInstance()
+void
+DestroyInstance( Machine * instance )
+{
+    if( instance == machine_ctx ) SetCurrentInstance( NULL );
+
+    DestroyMachine( instance );
+}
+
+// Get the machine the calling thread runs
+Machine *
+GetCurrentInstance( void )
+{
+    return machine_ctx;
+}
+
+// Make the calling thread run `instance`; returns the machine it ran before
+Machine *
+SetCurrentInstance( Machine * instance )
+{
+    Machine * const previous = machine_ctx;
+
+    machine_ctx = instance;
+
+    return previous;
+}
@@ -0,0 +1,484 @@
+/****************************** CameCore *********************************
+ *
+ * Module: PPU
+ *
+ * Scanline picture processing unit: steps the LCD through its modes on cycle deadlines and
+ * draws each line into a 160x144 frame buffer of DMG shades.
+ *
+ * Key Features:
+ * - Modes, LY, the LYC coincidence flag, VBlank and STAT interrupts advanced once per mode change
+ * - Decoded-tile cache: the 384 tiles pre-expanded from 2bpp into one color index per pixel
+ * - VRAM writes mark the tiles they touch; a dirty tile is decoded again the next time it is drawn
+ * - Background, window and objects are drawn with row copies and palette lookups
+ * - Triple-buffered frames: the completed one is swapped in at VBlank, so the reader never sees one being drawn
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *      wrote the original software. If you use this software in a product, an acknowledgment
+ *      in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#include "camecore/camecore.h"
+#include "camecore/machine.h"
+#include "camecore/utils.h"
+
+#include <string.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Defines and Macros
+//----------------------------------------------------------------------------------------------------------------------
+#define LCD_REG( addr ) ( machine_ctx->io.regs[( addr ) - IO_START].value ) /**< Backing byte of an LCD register */
+
+// LCDC bits
+#define LCDC_BG_ON      0 /**< Background and window shown (DMG) */
+#define LCDC_OBJ_ON     1 /**< Objects shown */
+#define LCDC_OBJ_TALL   2 /**< 8x16 objects */
+#define LCDC_BG_MAP     3 /**< Background tile map at 9C00 */
+#define LCDC_TILE_DATA  4 /**< Background and window tiles indexed unsigned from 8000 */
+#define LCDC_WIN_ON     5 /**< Window shown */
+#define LCDC_WIN_MAP    6 /**< Window tile map at 9C00 */
+#define LCDC_LCD_ON     7 /**< LCD and PPU enabled */
+
+// STAT bits
+#define STAT_MODE_MASK  0x03 /**< Current mode */
+#define STAT_LYC_EQUAL  2    /**< LY == LYC */
+#define STAT_INT_HBLANK 3    /**< Interrupt on mode 0 */
+#define STAT_INT_VBLANK 4    /**< Interrupt on mode 1 */
+#define STAT_INT_OAM    5    /**< Interrupt on mode 2 */
+#define STAT_INT_LYC    6    /**< Interrupt on LY == LYC */
+
+// IF bits
+#define IF_VBLANK       0
+#define IF_STAT         1
+
+// Object attributes
+#define OBJ_PALETTE     4 /**< OBP1 instead of OBP0 */
+#define OBJ_FLIP_X      5
+#define OBJ_FLIP_Y      6
+#define OBJ_BEHIND_BG   7 /**< Drawn behind background colors 1-3 */
+
+#define OBJ_COUNT       40 /**< Objects in OAM */
+#define OBJ_PER_LINE    10 /**< Objects a line can show */
+
+// Timing, in dots (T-cycles)
+#define DOTS_OAM_SCAN   80
+#define DOTS_TRANSFER   172
+#define DOTS_HBLANK     204
+#define DOTS_LINE       456
+#define LINES_PER_FRAME 154
+
+// Tile maps, as offsets into VRAM
+#define MAP_LOW         ( VRAM_BG_MAP1_START - VRAM_START )
+#define MAP_HIGH        ( VRAM_BG_MAP2_START - VRAM_START )
+#define MAP_WIDTH       32 /**< Tiles per map row */
+
+#define LINE_TILES      ( SCREEN_WIDTH / TILE_SIZE + 1 ) /**< Tiles covering a line at any fine scroll */
+
+// PPUState.latest
+#define FRAME_INDEX_MASK 0x03  /**< Frame buffer index */
+#define FRAME_FRESH      0x100 /**< Not taken by GetFrameBuffer() yet */
+
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+typedef enum
+{
+    MODE_HBLANK = 0,
+    MODE_VBLANK,
+    MODE_OAM_SCAN,
+    MODE_TRANSFER,
+} PPUMode;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------------------------------------------
+extern THREAD_LOCAL Machine * machine_ctx; // PPU state, tile cache and frames live in the machine arena
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Declarations
+//----------------------------------------------------------------------------------------------------------------------
+extern u8   GetIFRegister( void );
+extern void SetIFRegister( u8 v );
+extern void MarkBusRangeDirty( u16 start, u32 size );
+
+void InitPPU( void );
+void UpdatePPU( void );
+void SwitchLCD( bool on );
+void CompareLY( void );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+static INLINE void
+RequestInterrupt( u8 bit )
+{
+    SetIFRegister( (u8)( GetIFRegister() | BIT( bit ) ) );
+}
+
+// Expand a tile from 2bpp planes into one color index per pixel
+static void
+DecodeTile( u32 index )
+{
+    const u8 * const data = machine_ctx->ram.vram[0] + index * TILE_BYTES;
+    u8( *const pixels )[TILE_SIZE] = machine_ctx->video.tiles[index];
+
+    for( u32 row = 0; row < TILE_SIZE; ++row )
+        {
+            const u8 lo = data[row * 2];
+            const u8 hi = data[row * 2 + 1];
+
+            for( u32 x = 0; x < TILE_SIZE; ++x )
+                {
+                    const u32 shift = TILE_SIZE - 1 - x;
+
+                    pixels[row][x]  = (u8)( ( ( ( hi >> shift ) & 1 ) << 1 ) | ( ( lo >> shift ) & 1 ) );
+                }
+        }
+
+    BIT_CLEAR( machine_ctx->ppu.tile_dirty[index >> 3], index & 7 );
+}
+
+// Decoded pixels of a tile, row after row
+static INLINE const u8 *
+GetTile( u32 index )
+{
+    if( UNLIKELY( BIT_CHECK( machine_ctx->ppu.tile_dirty[index >> 3], index & 7 ) ) ) DecodeTile( index );
+
+    return machine_ctx->video.tiles[index][0];
+}
+
+// Tile of a map entry: unsigned from 8000, or signed around 9000
+static INLINE u32
+GetMapTile( u8 id, u8 lcdc )
+{
+    return ( BIT_CHECK( lcdc, LCDC_TILE_DATA ) || id >= 128 ) ? id : id + 256U;
+}
+
+// Shade of each color index under a DMG palette register
+static INLINE void
+GetShades( u8 palette, u8 * shades )
+{
+    for( u32 i = 0; i < 4; ++i ) shades[i] = ( palette >> ( i * 2 ) ) & 0x03;
+}
+
+// Copy the `LINE_TILES` tiles of a map row into `row`, starting at map column `column`
+static void
+CopyMapRow( u8 * row, const u8 * map, u32 column, u32 tileRow, u8 lcdc )
+{
+    for( u32 t = 0; t < LINE_TILES; ++t )
+        {
+            const u8 * const tile = GetTile( GetMapTile( map[( column + t ) & ( MAP_WIDTH - 1 )], lcdc ) );
+
+            memcpy( row + t * TILE_SIZE, tile + tileRow * TILE_SIZE, TILE_SIZE );
+        }
+}
+
+static void
+RenderBackground( u8 * color, u8 ly, u8 lcdc )
+{
+    const u8         y   = (u8)( LCD_REG( SCY_ADDR ) + ly );
+    const u8         scx = LCD_REG( SCX_ADDR );
+    const u8 * const map = machine_ctx->ram.vram[0] + ( BIT_CHECK( lcdc, LCDC_BG_MAP ) ? MAP_HIGH : MAP_LOW );
+    u8               row[LINE_TILES * TILE_SIZE];
+
+    CopyMapRow( row, map + ( y / TILE_SIZE ) * MAP_WIDTH, scx / TILE_SIZE, y % TILE_SIZE, lcdc );
+    memcpy( color, row + scx % TILE_SIZE, SCREEN_WIDTH );
+}
+
+// Draw the window over the background from WX - 7 on; it has a line counter of its own
+static void
+RenderWindow( u8 * color, u8 lcdc )
+{
+    PPUState * const ppu   = &machine_ctx->ppu;
+    const int        wx    = LCD_REG( WX_ADDR ) - 7;
+    const u32        start = ( wx < 0 ) ? 0 : (u32)wx;
+    const u8 * const map   = machine_ctx->ram.vram[0] + ( BIT_CHECK( lcdc, LCDC_WIN_MAP ) ? MAP_HIGH : MAP_LOW );
+    u8               row[LINE_TILES * TILE_SIZE];
+
+    CopyMapRow( row, map + ( ppu->window_line / TILE_SIZE ) * MAP_WIDTH, 0, ppu->window_line % TILE_SIZE, lcdc );
+    memcpy( color + start, row + ( (int)start - wx ), SCREEN_WIDTH - start );
+
+    ++ppu->window_line;
+}
+
+// Draw the first ten objects on the line; the one with the lowest X (then OAM index) owns each pixel
+static void
+RenderObjects( u8 * line, const u8 * color, u8 ly, u8 lcdc )
+{
+    const u8 * const oam    = machine_ctx->ram.oam;
+    const int        height = BIT_CHECK( lcdc, LCDC_OBJ_TALL ) ? 2 * TILE_SIZE : TILE_SIZE;
+    u8               objects[OBJ_PER_LINE];
+    u32              count = 0;
+    bool             owned[SCREEN_WIDTH];
+    u8               shades[2][4];
+
+    // OAM scan, kept sorted by X; equal X keeps OAM order
+    for( u32 i = 0; i < OBJ_COUNT && count < OBJ_PER_LINE; ++i )
+        {
+            const int row = ly + 16 - oam[i * 4];
+            u32       n;
+
+            if( row < 0 || row >= height ) continue;
+
+            for( n = count++; n > 0 && oam[objects[n - 1] * 4 + 1] > oam[i * 4 + 1]; --n ) objects[n] = objects[n - 1];
+            objects[n] = (u8)i;
+        }
+
+    if( 0 == count ) return;
+
+    GetShades( LCD_REG( OBP0_ADDR ), shades[0] );
+    GetShades( LCD_REG( OBP1_ADDR ), shades[1] );
+    memset( owned, 0, sizeof( owned ) );
+
+    for( u32 n = 0; n < count; ++n )
+        {
+            const u8 * const obj   = &oam[objects[n] * 4];
+            const u8         attr  = obj[3];
+            const u8 * const shade = shades[BIT_CHECK( attr, OBJ_PALETTE ) ? 1 : 0];
+            int              row   = ly + 16 - obj[0];
+            u32              tile  = ( 2 * TILE_SIZE == height ) ? ( obj[2] & 0xFEU ) : obj[2];
+            const u8 *       pixels;
+
+            if( BIT_CHECK( attr, OBJ_FLIP_Y ) ) row = height - 1 - row;
+            tile   += (u32)row / TILE_SIZE;
+            pixels  = GetTile( tile ) + ( row % TILE_SIZE ) * TILE_SIZE;
+
+            for( int i = 0; i < TILE_SIZE; ++i )
+                {
+                    const int x = obj[1] - 8 + i;
+                    u8        index;
+
+                    if( x < 0 || x >= SCREEN_WIDTH || owned[x] ) continue;
+
+                    index = pixels[BIT_CHECK( attr, OBJ_FLIP_X ) ? TILE_SIZE - 1 - i : i];
+                    if( 0 == index ) continue;
+
+                    owned[x] = true;
+                    if( BIT_CHECK( attr, OBJ_BEHIND_BG ) && 0 != color[x] ) continue;
+
+                    line[x] = shade[index];
+                }
+        }
+}
+
+// Draw line `ly` into the frame being built
+static void
+RenderLine( u8 ly )
+{
+    const u8   lcdc = LCD_REG( LCDC_ADDR );
+    u8 * const line = machine_ctx->video.frames[machine_ctx->ppu.back][ly];
+    u8         color[SCREEN_WIDTH]; // Background color indices, for object priority
+    u8         shades[4];
+
+    if( BIT_CHECK( lcdc, LCDC_BG_ON ) )
+        {
+            RenderBackground( color, ly, lcdc );
+
+            if( BIT_CHECK( lcdc, LCDC_WIN_ON ) && ly >= LCD_REG( WY_ADDR ) && LCD_REG( WX_ADDR ) < SCREEN_WIDTH + 7 )
+                {
+                    RenderWindow( color, lcdc );
+                }
+
+            GetShades( LCD_REG( BGP_ADDR ), shades );
+            for( u32 x = 0; x < SCREEN_WIDTH; ++x ) line[x] = shades[color[x]];
+        }
+    else
+        {
+            // Blank line: lightest shade whatever BGP holds; objects still see color 0 behind them
+            memset( color, 0, sizeof( color ) );
+            memset( line, 0, SCREEN_WIDTH );
+        }
+
+    if( BIT_CHECK( lcdc, LCDC_OBJ_ON ) ) RenderObjects( line, color, ly, lcdc );
+}
+
+// Make the frame being built the latest one, and keep drawing into the buffer it replaces
+static void
+PublishFrame( void )
+{
+    PPUState * const ppu = &machine_ctx->ppu;
+
+    ppu->back = (u8)( ATOMIC_XCHG32( &ppu->latest, ppu->back | FRAME_FRESH ) & FRAME_INDEX_MASK );
+}
+
+static void
+SetMode( PPUMode mode )
+{
+    static const u8 STAT_SOURCES[] = { STAT_INT_HBLANK, STAT_INT_VBLANK, STAT_INT_OAM, 0 };
+    const u8        stat           = (u8)( ( LCD_REG( STAT_ADDR ) & ~STAT_MODE_MASK ) | mode );
+
+    LCD_REG( STAT_ADDR ) = stat;
+    MarkBusRangeDirty( STAT_ADDR, 1 );
+    if( MODE_TRANSFER != mode && BIT_CHECK( stat, STAT_SOURCES[mode] ) ) RequestInterrupt( IF_STAT );
+}
+
+static void
+SetLY( u8 ly )
+{
+    LCD_REG( LY_ADDR ) = ly;
+    CompareLY();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Start the PPU from the LCD registers; every tile is decoded again on first use
+// NOTE: Depends only on the registers and the cycle counter, so it also brings a reset machine back in step
+void
+InitPPU( void )
+{
+    PPUState * const ppu = &machine_ctx->ppu;
+
+    // New arena: deal the frame buffers out (a reset keeps the reader's one)
+    if( ppu->back == ( ATOMIC_LOAD( &ppu->latest ) & FRAME_INDEX_MASK ) )
+        {
+            ppu->back   = 0;
+            ppu->front  = 1;
+            ppu->latest = 2;
+        }
+
+    memset( ppu->tile_dirty, 0xFF, sizeof( ppu->tile_dirty ) );
+    SwitchLCD( BIT_CHECK( LCD_REG( LCDC_ADDR ), LCDC_LCD_ON ) );
+}
+
+// Advance through the mode changes due by now
+// NOTE: Called by the emulation once the cycle counter reaches `ppu.deadline`
+void
+UpdatePPU( void )
+{
+    PPUState * const ppu = &machine_ctx->ppu;
+
+    // A resync (deadline set to now, see the state loader) can land while the LCD is off
+    if( UNLIKELY( !BIT_CHECK( LCD_REG( LCDC_ADDR ), LCDC_LCD_ON ) ) )
+        {
+            ppu->deadline = UINT64_MAX;
+            return;
+        }
+
+    while( machine_ctx->ticks >= ppu->deadline )
+        {
+            const u8 ly = LCD_REG( LY_ADDR );
+
+            switch( (PPUMode)( LCD_REG( STAT_ADDR ) & STAT_MODE_MASK ) )
+                {
+                    case MODE_OAM_SCAN:
+                        SetMode( MODE_TRANSFER );
+                        ppu->deadline += DOTS_TRANSFER;
+                        break;
+
+                    // The whole line is drawn when its transfer ends
+                    case MODE_TRANSFER:
+                        RenderLine( ly );
+                        SetMode( MODE_HBLANK );
+                        ppu->deadline += DOTS_HBLANK;
+                        break;
+
+                    case MODE_HBLANK:
+                        SetLY( (u8)( ly + 1 ) );
+                        if( SCREEN_HEIGHT == ly + 1 )
+                            {
+                                SetMode( MODE_VBLANK );
+                                RequestInterrupt( IF_VBLANK );
+                                PublishFrame();
+                                ppu->deadline += DOTS_LINE;
+                            }
+                        else
+                            {
+                                SetMode( MODE_OAM_SCAN );
+                                ppu->deadline += DOTS_OAM_SCAN;
+                            }
+                        break;
+
+                    case MODE_VBLANK:
+                        if( LINES_PER_FRAME - 1 == ly )
+                            {
+                                ppu->window_line = 0;
+                                SetLY( 0 );
+                                SetMode( MODE_OAM_SCAN );
+                                ppu->deadline += DOTS_OAM_SCAN;
+                            }
+                        else
+                            {
+                                SetLY( (u8)( ly + 1 ) );
+                                ppu->deadline += DOTS_LINE;
+                            }
+                        break;
+                }
+        }
+}
+
+// LCDC bit 7 changed: restart the frame at line 0, or stop the PPU and show a blank screen
+void
+SwitchLCD( bool on )
+{
+    PPUState * const ppu = &machine_ctx->ppu;
+
+    ppu->window_line     = 0;
+    SetLY( 0 );
+
+    if( on )
+        {
+            SetMode( MODE_OAM_SCAN );
+            ppu->deadline = machine_ctx->ticks + DOTS_OAM_SCAN;
+            return;
+        }
+
+    LCD_REG( STAT_ADDR ) &= (u8)~STAT_MODE_MASK;
+    ppu->deadline         = UINT64_MAX;
+
+    memset( machine_ctx->video.frames[ppu->back], 0, sizeof( machine_ctx->video.frames[0] ) );
+    PublishFrame();
+}
+
+// Update the coincidence flag, raising the STAT interrupt when LY starts matching LYC
+void
+CompareLY( void )
+{
+    const u8   stat  = LCD_REG( STAT_ADDR );
+    const bool equal = ( LCD_REG( LY_ADDR ) == LCD_REG( LYC_ADDR ) );
+
+    if( equal && !BIT_CHECK( stat, STAT_LYC_EQUAL ) && BIT_CHECK( stat, STAT_INT_LYC ) ) RequestInterrupt( IF_STAT );
+    BIT_ASSIGN( LCD_REG( STAT_ADDR ), STAT_LYC_EQUAL, equal );
+    MarkBusRangeDirty( STAT_ADDR, 1 ); // LY and STAT share the I/O page
+}
+
+// Last completed frame of this thread's machine; it stays untouched until the next call
+// NOTE: Safe to call from another thread than the emulation's, but from a single one
+const u8 *
+GetFrameBuffer( void )
+{
+    PPUState * ppu;
+
+    if( NULL == machine_ctx ) return NULL;
+
+    ppu = &machine_ctx->ppu;
+    if( ATOMIC_LOAD( &ppu->latest ) & FRAME_FRESH )
+        {
+            ppu->front = (u8)( ATOMIC_XCHG32( &ppu->latest, ppu->front ) & FRAME_INDEX_MASK );
+        }
+
+    return machine_ctx->video.frames[ppu->front][0];
+}
+
+bool
+IsFrameReady( void )
+{
+    return NULL != machine_ctx && 0 != ( ATOMIC_LOAD( &machine_ctx->ppu.latest ) & FRAME_FRESH );
+}
@@ -2,11 +2,15 @@
  *
  * Module: RAM
  *
- * Handles the Work RAM (WRAM) and High RAM (HRAM) operations including
- * read/write operations with address validation and memory management.
+ * Handles the Work RAM (WRAM), Video RAM (VRAM) and High RAM (HRAM) operations
+ * including read/write operations with address validation and memory management.
  *
  * Key Features:
- * - WRAM and HRAM memory management
+ * - WRAM, VRAM, OAM and HRAM memory management
+ * - Direct bus page mapping for WRAM, VRAM and OAM
+ * - Echo RAM aliased onto the WRAM pages it mirrors
+ * - CGB banking: 8 WRAM and 2 VRAM banks in one block; SVBK/VBK writes repoint the bus pages
+ *   of D000-DFFF (and its echo) or 8000-9FFF at the selected bank, nothing is copied
  * - Address translation and bounds checking
  * - Read/Write operations with error logging
  *
@@ -34,31 +38,33 @@
  *************************************************************************/
 
 #include "camecore/camecore.h"
+#include "camecore/machine.h"
 #include "camecore/utils.h"
 
-//----------------------------------------------------------------------------------------------------------------------
-// Module Defines and Macros
-//----------------------------------------------------------------------------------------------------------------------
-// ...
+#include <string.h>
 
 //----------------------------------------------------------------------------------------------------------------------
-// Structs Definition
+// Module Defines and Macros
 //----------------------------------------------------------------------------------------------------------------------
-typedef struct RAMContext
-{
-    u8 wram[WRAM_SIZE];
-    u8 hram[HRAM_SIZE];
-} RAMContext;
+#define UNUSABLE_VALUE   0x00  /**< Value read back from 0xFEA0-0xFEFF (DMG, OAM not blocked) */
+#define ECHO_MIRROR_BASE ( ECHO_START - WRAM_START ) /**< Distance between Echo RAM and the WRAM it mirrors */
+#define ECHO_BANKN_START ( WRAM_BANKN_START + ECHO_MIRROR_BASE ) /**< Echo of the switchable WRAM bank */
+#define ECHO_BANKN_SIZE  ( ECHO_END - ECHO_BANKN_START + 1 )     /**< F000-FDFF */
 
 //----------------------------------------------------------------------------------------------------------------------
 // Global Variables Definition
 //----------------------------------------------------------------------------------------------------------------------
-static RAMContext ram_ctx = { 0 };
+extern THREAD_LOCAL Machine * machine_ctx; // RAM lives in the machine arena
 
 //----------------------------------------------------------------------------------------------------------------------
 // Module Internal Functions Declarations
 //----------------------------------------------------------------------------------------------------------------------
-// ...
+extern bool InitMachine( void );
+extern void MapBusPages( u16 start, u32 size, u8 * readBase, u8 * writeBase );
+
+void InitRAM( void );
+void SetWRAMBank( u8 bank );
+void SetVRAMBank( u8 bank );
 
 //----------------------------------------------------------------------------------------------------------------------
 // Module Internal Functions Definitions
@@ -68,6 +74,53 @@ static RAMContext ram_ctx = { 0 };
 //----------------------------------------------------------------------------------------------------------------------
 // Module Functions Definitions
 //----------------------------------------------------------------------------------------------------------------------
+// Clear the RAM contents and expose WRAM, Echo RAM, VRAM and OAM as direct bus pages (VRAM and OAM: reads only)
+void
+InitRAM( void )
+{
+    if( !InitMachine() ) LOG( LOG_FATAL, "Failed to allocate the machine state" );
+
+    RAMContext * const ram = &machine_ctx->ram;
+
+    memset( ram, 0, sizeof( *ram ) );
+    memset( ram->oam + OAM_SIZE, UNUSABLE_VALUE, OAM_PAGE_SIZE - OAM_SIZE );
+
+    MapBusPages( WRAM_START, WRAM_BANK_SIZE, ram->wram[0], ram->wram[0] );
+    MapBusPages( ECHO_START, WRAM_BANK_SIZE, ram->wram[0], ram->wram[0] );
+    SetWRAMBank( 1 );
+    SetVRAMBank( 0 );
+
+    // Writes must not reach the unusable tail, so only reads are direct
+    MapBusPages( OAM_START, OAM_PAGE_SIZE, ram->oam, NULL );
+}
+
+// Select the WRAM bank seen at D000-DFFF and its echo (SVBK; 0 selects bank 1)
+void
+SetWRAMBank( u8 bank )
+{
+    RAMContext * const ram = &machine_ctx->ram;
+    u8 *               base;
+
+    bank           &= WRAM_BANKS - 1;
+    ram->wram_bank  = ( 0 != bank ) ? bank : 1;
+    base            = ram->wram[ram->wram_bank];
+
+    MapBusPages( WRAM_BANKN_START, WRAM_BANK_SIZE, base, base );
+    MapBusPages( ECHO_BANKN_START, ECHO_BANKN_SIZE, base, base );
+}
+
+// Select the VRAM bank seen at 8000-9FFF (VBK)
+// NOTE: Writes go through WriteVRAM(), which marks the tiles they touch for the PPU tile cache
+void
+SetVRAMBank( u8 bank )
+{
+    RAMContext * const ram = &machine_ctx->ram;
+
+    ram->vram_bank         = bank & ( VRAM_BANKS - 1 );
+
+    MapBusPages( VRAM_START, VRAM_SIZE, ram->vram[ram->vram_bank], NULL );
+}
+
 // Perform read operation to the Work RAM
 u8
 ReadWRAM( u16 addr )
@@ -75,15 +128,80 @@ ReadWRAM( u16 addr )
     addr -= WRAM_START;
     ASSERT( WRAM_SIZE > addr, "INVALID WRAM ADDRESS %08X", addr + WRAM_START );
 
-    return ram_ctx.wram[addr];
+    if( addr < WRAM_BANK_SIZE ) return machine_ctx->ram.wram[0][addr];
+    return machine_ctx->ram.wram[machine_ctx->ram.wram_bank][addr - WRAM_BANK_SIZE];
 }
 
 // Perform write operation to the Work RAM
 void
 WriteWRAM( u16 addr, u8 value )
 {
-    addr               -= WRAM_START;
-    ram_ctx.wram[addr]  = value;
+    addr -= WRAM_START;
+
+    if( addr < WRAM_BANK_SIZE )
+        machine_ctx->ram.wram[0][addr] = value;
+    else
+        machine_ctx->ram.wram[machine_ctx->ram.wram_bank][addr - WRAM_BANK_SIZE] = value;
+}
+
+// Perform read operation to the Video RAM
+u8
+ReadVRAM( u16 addr )
+{
+    addr -= VRAM_START;
+    ASSERT( VRAM_SIZE > addr, "INVALID VRAM ADDRESS %08X", addr + VRAM_START );
+
+    return machine_ctx->ram.vram[machine_ctx->ram.vram_bank][addr];
+}
+
+// Perform write operation to the Video RAM
+void
+WriteVRAM( u16 addr, u8 value )
+{
+    addr                                                     -= VRAM_START;
+    machine_ctx->ram.vram[machine_ctx->ram.vram_bank][addr]  = value;
+
+    // Tile data of bank 0: the decoded copy is stale
+    if( addr < TILE_COUNT * TILE_BYTES && 0 == machine_ctx->ram.vram_bank )
+        {
+            const u32 tile = addr / TILE_BYTES;
+
+            BIT_SET( machine_ctx->ppu.tile_dirty[tile >> 3], tile & 7 );
+        }
+}
+
+// Perform read operation to the Echo RAM (mirror of 0xC000-0xDDFF)
+u8
+ReadEcho( u16 addr )
+{
+    return ReadWRAM( addr - ECHO_MIRROR_BASE );
+}
+
+// Perform write operation to the Echo RAM (mirror of 0xC000-0xDDFF)
+void
+WriteEcho( u16 addr, u8 value )
+{
+    WriteWRAM( addr - ECHO_MIRROR_BASE, value );
+}
+
+// Perform read operation to the Object Attribute Memory and the unusable range after it
+u8
+ReadOAM( u16 addr )
+{
+    addr -= OAM_START;
+    ASSERT( OAM_PAGE_SIZE > addr, "INVALID OAM ADDRESS %08X", addr + OAM_START );
+
+    return machine_ctx->ram.oam[addr];
+}
+
+// Perform write operation to the Object Attribute Memory (unusable range is ignored)
+void
+WriteOAM( u16 addr, u8 value )
+{
+    addr -= OAM_START;
+    if( UNLIKELY( OAM_SIZE <= addr ) ) return;
+
+    machine_ctx->ram.oam[addr] = value;
 }
 
 // Perform read operation to the High RAM
@@ -93,13 +211,13 @@ ReadHRAM( u16 addr )
     addr -= HRAM_START;
     ASSERT( HRAM_SIZE > addr, "INVALID HRAM ADDRESS %08X", addr + WRAM_START );
 
-    return ram_ctx.hram[addr];
+    return machine_ctx->ram.hram[addr];
 }
 
 // Perform write operation to the High RAM
 void
 WriteHRAM( u16 addr, u8 value )
 {
-    addr               -= HRAM_START;
-    ram_ctx.hram[addr]  = value;
+    addr                        -= HRAM_START;
+    machine_ctx->ram.hram[addr]  = value;
 }
@@ -0,0 +1,571 @@
+/****************************** CameCore *********************************
+ *
+ * Module: Rewind
+ *
+ * Keeps a history of save states in a fixed-size ring so the emulation can be stepped
+ * back in time.
+ *
+ * Key Features:
+ * - A snapshot is taken every N frames; the emulation thread only pays for the state copy
+ * - A helper thread XORs each snapshot against the previous one and run-length encodes
+ *   the (mostly zero) difference, 64 bits at a time
+ * - Deltas run backwards from the newest full snapshot, so the oldest entry can always be
+ *   dropped when the ring is full
+ * - RewindEmulator: Served by the emulation thread when it is running, directly otherwise
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *      wrote the original software. If you use this software in a product, an acknowledgment
+ *      in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#include "camecore/camecore.h"
+#include "camecore/machine.h"
+#include "camecore/utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Defines and Macros
+//----------------------------------------------------------------------------------------------------------------------
+#define REWIND_ENTRY_OVERHEAD ( 2 * sizeof( u32 ) ) /**< Size stored before and after each delta */
+#define REWIND_POLL_MS        1                     /**< Requester wake-up granularity */
+
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+typedef struct RewindContext
+{
+    bool enabled;
+    u32  interval;     // Frames between snapshots
+    u64  next_capture; // Tick of the next snapshot
+
+    // Ring of compressed deltas: [u32 size][u64 ticks][delta][u32 size], oldest at `start`, newest ending at `end`
+    // NOTE: When the ring has wrapped (`end` <= `start`), the data before the wrap ends at `wrap`
+    u8 *   ring;
+    size_t capacity;
+    size_t start;
+    size_t end;
+    size_t wrap;
+    u32    count;
+
+    // Snapshots
+    size_t state_size;
+    u8 *   head;          // Newest snapshot; each delta turns it into the one before
+    u64    head_ticks;    // Tick `head` was taken at
+    bool   has_head;
+    u8 *   staging;       // Snapshot handed from the emulation thread to the compressor
+    u64    staging_ticks;
+    u8 *   scratch;       // Compressor output: tick of the older snapshot, then the delta
+    bool   pending;       // `staging` holds a snapshot that was not compressed yet
+
+    // Threads
+    THREAD_HANDLE compressor;
+    bool          running;
+    MUTEX_HANDLE  lock;    // Ring and `head` (compressor against rewinds)
+    MUTEX_HANDLE  wait;    // Guards sleeping on `wake`
+    COND_HANDLE   wake;    // A snapshot was handed over or taken in, or the compressor must stop
+    u32           request; // Frames asked by RewindEmulator(), served by the emulation thread
+    u32           result;  // Frames actually rewound for the last request
+} RewindContext;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------------------------------------------
+static RewindContext rewind_ctx = { 0 };
+
+extern THREAD_LOCAL Machine * machine_ctx;
+extern u64                    service_deadline; // Tick of the next snapshot, or 0 to have a request served
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Declarations
+//----------------------------------------------------------------------------------------------------------------------
+extern bool IsMachineOnOtherThread( void );
+
+void UpdateRewind( void );
+void RestartRewind( void );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+static size_t
+PutVarint( u8 * out, size_t value )
+{
+    size_t n = 0;
+
+    while( value >= 0x80 )
+        {
+            out[n++]   = (u8)( value | 0x80 );
+            value    >>= 7;
+        }
+    out[n++] = (u8)value;
+    return n;
+}
+
+static size_t
+GetVarint( const u8 * in, size_t * value )
+{
+    size_t n     = 0;
+    u32    shift = 0;
+
+    *value = 0;
+    do
+        {
+            *value |= (size_t)( in[n] & 0x7F ) << shift;
+            shift  += 7;
+        }
+    while( in[n++] & 0x80 );
+    return n;
+}
+
+// Encode `cur` XOR `prev` as (unchanged words, changed words, changed words XOR'd) runs
+// NOTE: Save states are a multiple of 8 bytes; `out` must hold 2 * size + 16 bytes
+static size_t
+EncodeDelta( const u8 * cur, const u8 * prev, size_t size, u8 * out )
+{
+    const u64 * const a     = (const u64 *)cur;
+    const u64 * const b     = (const u64 *)prev;
+    const size_t      words = size / sizeof( u64 );
+    size_t            n     = 0;
+    size_t            i     = 0;
+
+    while( i < words )
+        {
+            size_t same = i;
+            size_t diff;
+
+            while( same < words && a[same] == b[same] ) ++same;
+            if( same == words ) break; // Trailing unchanged words are implied
+
+            diff = same;
+            while( diff < words && a[diff] != b[diff] ) ++diff;
+
+            n += PutVarint( out + n, same - i );
+            n += PutVarint( out + n, diff - same );
+            for( size_t w = same; w < diff; ++w, n += sizeof( u64 ) )
+                {
+                    const u64 x = a[w] ^ b[w];
+                    memcpy( out + n, &x, sizeof( u64 ) );
+                }
+
+            i = diff;
+        }
+
+    return n;
+}
+
+// XOR an encoded delta back into `state`
+static void
+ApplyDelta( u8 * state, const u8 * delta, size_t size )
+{
+    u64 * const words = (u64 *)state;
+    size_t      n     = 0;
+    size_t      i     = 0;
+
+    while( n < size )
+        {
+            size_t same;
+            size_t diff;
+
+            n += GetVarint( delta + n, &same );
+            n += GetVarint( delta + n, &diff );
+
+            for( i += same; diff > 0; --diff, ++i, n += sizeof( u64 ) )
+                {
+                    u64 x;
+                    memcpy( &x, delta + n, sizeof( u64 ) );
+                    words[i] ^= x;
+                }
+        }
+}
+
+static void
+ClearRing( void )
+{
+    rewind_ctx.start = rewind_ctx.end = rewind_ctx.wrap = 0;
+    rewind_ctx.count = 0;
+}
+
+static u32
+GetEntrySize( size_t offset )
+{
+    u32 size;
+    memcpy( &size, rewind_ctx.ring + offset, sizeof( u32 ) );
+    return size;
+}
+
+// Append a delta, dropping the oldest ones until it fits
+static void
+PushEntry( const u8 * delta, u32 size )
+{
+    const size_t total = size + REWIND_ENTRY_OVERHEAD;
+
+    // Never fits: the older deltas no longer chain onto the new head, so history restarts from it
+    if( total > rewind_ctx.capacity )
+        {
+            ClearRing();
+            return;
+        }
+
+    for( ;; )
+        {
+            if( 0 == rewind_ctx.count ) ClearRing();
+
+            if( rewind_ctx.end >= rewind_ctx.start && 0 == rewind_ctx.wrap )
+                {
+                    if( rewind_ctx.end + total <= rewind_ctx.capacity ) break;
+
+                    // Wrap around; the entries at the front are the oldest
+                    rewind_ctx.wrap = rewind_ctx.end;
+                    rewind_ctx.end  = 0;
+                }
+
+            if( rewind_ctx.end + total <= rewind_ctx.start ) break;
+
+            // Drop the oldest entry
+            rewind_ctx.start += GetEntrySize( rewind_ctx.start ) + REWIND_ENTRY_OVERHEAD;
+            --rewind_ctx.count;
+            if( rewind_ctx.start == rewind_ctx.wrap )
+                {
+                    rewind_ctx.start = 0;
+                    rewind_ctx.wrap  = 0;
+                }
+        }
+
+    memcpy( rewind_ctx.ring + rewind_ctx.end, &size, sizeof( u32 ) );
+    memcpy( rewind_ctx.ring + rewind_ctx.end + sizeof( u32 ), delta, size );
+    memcpy( rewind_ctx.ring + rewind_ctx.end + sizeof( u32 ) + size, &size, sizeof( u32 ) );
+    rewind_ctx.end += total;
+    ++rewind_ctx.count;
+}
+
+// Remove the newest delta and return it (valid until the next push)
+static const u8 *
+PopEntry( u32 * outSize )
+{
+    const u8 * entry;
+    u32        size;
+
+    if( 0 == rewind_ctx.count ) return NULL;
+
+    memcpy( &size, rewind_ctx.ring + rewind_ctx.end - sizeof( u32 ), sizeof( u32 ) );
+    rewind_ctx.end -= size + REWIND_ENTRY_OVERHEAD;
+    --rewind_ctx.count;
+    entry = rewind_ctx.ring + rewind_ctx.end + sizeof( u32 );
+
+    // Back at the front of a wrapped ring: the newest entry is the last one before the wrap
+    if( 0 == rewind_ctx.end && 0 != rewind_ctx.wrap && 0 != rewind_ctx.count )
+        {
+            rewind_ctx.end  = rewind_ctx.wrap;
+            rewind_ctx.wrap = 0;
+        }
+
+    *outSize = size;
+    return entry;
+}
+
+// Wake whichever side waits on `wake`: the compressor for a new snapshot, or the machine's thread for it to be taken in
+// NOTE: Only one of them can be waiting, as `pending` tells them apart
+static void
+WakeRewindThread( void )
+{
+    MUTEX_LOCK( rewind_ctx.wait );
+    COND_SIGNAL( rewind_ctx.wake );
+    MUTEX_UNLOCK( rewind_ctx.wait );
+}
+
+// Compress handed-over snapshots into the ring, off the emulation thread
+static THREAD_RETURN
+RunCompressor( THREAD_PARAM param )
+{
+    UNUSED( param );
+
+    for( ;; )
+        {
+            // Sleep until CaptureSnapshot() hands a snapshot over or DisableRewind() stops us
+            MUTEX_LOCK( rewind_ctx.wait );
+            while( ATOMIC_LOAD( &rewind_ctx.running ) && !ATOMIC_LOAD( &rewind_ctx.pending ) )
+                {
+                    COND_WAIT( rewind_ctx.wake, rewind_ctx.wait );
+                }
+            MUTEX_UNLOCK( rewind_ctx.wait );
+
+            if( !ATOMIC_LOAD( &rewind_ctx.running ) ) break;
+
+            MUTEX_LOCK( rewind_ctx.lock );
+            {
+                u8 * const previous = rewind_ctx.head;
+
+                if( rewind_ctx.has_head )
+                    {
+                        // Delta from the new snapshot back to the previous one
+                        const size_t size = EncodeDelta( rewind_ctx.staging, previous, rewind_ctx.state_size,
+                                                         rewind_ctx.scratch + sizeof( u64 ) );
+
+                        memcpy( rewind_ctx.scratch, &rewind_ctx.head_ticks, sizeof( u64 ) );
+                        PushEntry( rewind_ctx.scratch, (u32)( sizeof( u64 ) + size ) );
+                    }
+
+                rewind_ctx.head       = rewind_ctx.staging;
+                rewind_ctx.head_ticks = rewind_ctx.staging_ticks;
+                rewind_ctx.staging    = previous;
+                rewind_ctx.has_head   = true;
+            }
+            MUTEX_UNLOCK( rewind_ctx.lock );
+
+            ATOMIC_STORE( &rewind_ctx.pending, false );
+            WakeRewindThread();
+        }
+
+    return 0;
+}
+
+// Wait until the compressor took the last snapshot in
+static void
+WaitCompressor( void )
+{
+    MUTEX_LOCK( rewind_ctx.wait );
+    while( ATOMIC_LOAD( &rewind_ctx.pending ) ) COND_WAIT( rewind_ctx.wake, rewind_ctx.wait );
+    MUTEX_UNLOCK( rewind_ctx.wait );
+}
+
+// (Re)allocate the snapshot buffers for the current state size, dropping the history
+static bool
+ResizeSnapshots( size_t stateSize )
+{
+    MUTEX_LOCK( rewind_ctx.lock );
+
+    free( rewind_ctx.head );
+    free( rewind_ctx.staging );
+    free( rewind_ctx.scratch );
+    rewind_ctx.head       = (u8 *)malloc( stateSize );
+    rewind_ctx.staging    = (u8 *)malloc( stateSize );
+    rewind_ctx.scratch    = (u8 *)malloc( sizeof( u64 ) + 2 * stateSize + 16 );
+    rewind_ctx.state_size = stateSize;
+    rewind_ctx.has_head   = false;
+    ClearRing();
+
+    if( NULL == rewind_ctx.head || NULL == rewind_ctx.staging || NULL == rewind_ctx.scratch )
+        {
+            free( rewind_ctx.head );
+            free( rewind_ctx.staging );
+            free( rewind_ctx.scratch );
+            rewind_ctx.head = rewind_ctx.staging = rewind_ctx.scratch = NULL;
+            rewind_ctx.state_size                                      = 0;
+        }
+
+    MUTEX_UNLOCK( rewind_ctx.lock );
+    return 0 != rewind_ctx.state_size;
+}
+
+// Hand a snapshot of the machine to the compressor (skipped while it is still busy)
+static void
+CaptureSnapshot( void )
+{
+    const size_t size = GetStateSize();
+
+    if( ATOMIC_LOAD( &rewind_ctx.pending ) ) return;
+    if( size != rewind_ctx.state_size && !ResizeSnapshots( size ) ) return;
+
+    if( 0 != SaveStateToMemory( rewind_ctx.staging, size ) )
+        {
+            rewind_ctx.staging_ticks = machine_ctx->ticks;
+            ATOMIC_STORE( &rewind_ctx.pending, true );
+            WakeRewindThread();
+        }
+}
+
+// Step back by at least `frames` frames, or as far as the history goes
+static u32
+ApplyRewind( u32 frames )
+{
+    const u64 ticks  = machine_ctx->ticks;
+    const u64 span   = (u64)frames * FRAME_TICKS;
+    const u64 target = ( ticks > span ) ? ticks - span : 0;
+    bool      loaded;
+
+    WaitCompressor();
+
+    MUTEX_LOCK( rewind_ctx.lock );
+    if( !rewind_ctx.has_head )
+        {
+            MUTEX_UNLOCK( rewind_ctx.lock );
+            return 0;
+        }
+
+    // Walk back from the newest snapshot until one is old enough (or the history runs out)
+    while( rewind_ctx.head_ticks > target )
+        {
+            u32              size;
+            const u8 * const entry = PopEntry( &size );
+
+            if( NULL == entry ) break;
+            memcpy( &rewind_ctx.head_ticks, entry, sizeof( u64 ) );
+            ApplyDelta( rewind_ctx.head, entry + sizeof( u64 ), size - sizeof( u64 ) );
+        }
+
+    loaded = LoadStateFromMemory( rewind_ctx.head, rewind_ctx.state_size );
+    MUTEX_UNLOCK( rewind_ctx.lock );
+
+    if( !loaded ) return 0;
+
+    rewind_ctx.next_capture = machine_ctx->ticks + (u64)rewind_ctx.interval * FRAME_TICKS;
+    return ( ticks > machine_ctx->ticks ) ? (u32)( ( ticks - machine_ctx->ticks ) / FRAME_TICKS ) : 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Called by the emulation thread once `service_deadline` is reached: serve requests, take snapshots
+void
+UpdateRewind( void )
+{
+    const u32 request = ATOMIC_LOAD( &rewind_ctx.request );
+
+    if( 0 != request )
+        {
+            rewind_ctx.result = ( rewind_ctx.enabled ) ? ApplyRewind( request ) : 0;
+            ATOMIC_STORE( &rewind_ctx.request, 0 );
+        }
+
+    if( !rewind_ctx.enabled || NULL == machine_ctx )
+        {
+            ATOMIC_STORE( &service_deadline, UINT64_MAX );
+            return;
+        }
+
+    if( machine_ctx->ticks >= rewind_ctx.next_capture )
+        {
+            CaptureSnapshot();
+            rewind_ctx.next_capture = machine_ctx->ticks + (u64)rewind_ctx.interval * FRAME_TICKS;
+        }
+
+    ATOMIC_STORE( &service_deadline, rewind_ctx.next_capture );
+}
+
+// Drop the history after the machine jumped back to power on; recording restarts on the next check
+// NOTE: Called by the thread running the machine
+void
+RestartRewind( void )
+{
+    if( !rewind_ctx.enabled ) return;
+
+    WaitCompressor();
+    MUTEX_LOCK( rewind_ctx.lock );
+    rewind_ctx.has_head = false;
+    ClearRing();
+    MUTEX_UNLOCK( rewind_ctx.lock );
+
+    rewind_ctx.next_capture = 0;
+    ATOMIC_STORE( &service_deadline, 0 );
+}
+
+// Start recording a snapshot every `interval` frames into a ring of `bufferSize` bytes
+bool
+EnableRewind( u32 interval, size_t bufferSize )
+{
+    DisableRewind();
+
+    if( 0 == interval || 0 == bufferSize ) return false;
+
+    rewind_ctx.ring = (u8 *)malloc( bufferSize );
+    if( NULL == rewind_ctx.ring )
+        {
+            LOG( LOG_ERROR, "REWIND: Failed to allocate %zu bytes", bufferSize );
+            return false;
+        }
+
+    rewind_ctx.capacity     = bufferSize;
+    rewind_ctx.interval     = interval;
+    rewind_ctx.next_capture = 0;
+    ClearRing();
+    MUTEX_INIT( rewind_ctx.lock );
+    MUTEX_INIT( rewind_ctx.wait );
+    COND_INIT( rewind_ctx.wake );
+
+    ATOMIC_STORE( &rewind_ctx.running, true );
+    if( 0 != THREAD_CREATE( rewind_ctx.compressor, RunCompressor, NULL ) )
+        {
+            LOG( LOG_ERROR, "REWIND: Failed to start the compressor" );
+            ATOMIC_STORE( &rewind_ctx.running, false );
+            COND_DESTROY( rewind_ctx.wake );
+            MUTEX_DESTROY( rewind_ctx.wait );
+            MUTEX_DESTROY( rewind_ctx.lock );
+            free( rewind_ctx.ring );
+            rewind_ctx.ring = NULL;
+            return false;
+        }
+
+    rewind_ctx.enabled = true;
+    ATOMIC_STORE( &service_deadline, 0 ); // First snapshot on the next check
+
+    LOG( LOG_INFO, "REWIND: Snapshot every %u frames, %zu KB of history", interval, bufferSize >> 10 );
+    return true;
+}
+
+// Stop recording and free the history
+// NOTE: Call while the emulation thread is stopped or paused
+void
+DisableRewind( void )
+{
+    if( !rewind_ctx.enabled ) return;
+
+    rewind_ctx.enabled = false;
+    ATOMIC_STORE( &service_deadline, UINT64_MAX );
+
+    ATOMIC_STORE( &rewind_ctx.running, false );
+    WakeRewindThread();
+    THREAD_JOIN( rewind_ctx.compressor );
+    COND_DESTROY( rewind_ctx.wake );
+    MUTEX_DESTROY( rewind_ctx.wait );
+    MUTEX_DESTROY( rewind_ctx.lock );
+
+    free( rewind_ctx.ring );
+    free( rewind_ctx.head );
+    free( rewind_ctx.staging );
+    free( rewind_ctx.scratch );
+    memset( &rewind_ctx, 0, sizeof( rewind_ctx ) );
+}
+
+// Step the emulation back by at least `frames` frames; returns the frames actually rewound
+u32
+RewindEmulator( u32 frames )
+{
+    if( !rewind_ctx.enabled || 0 == frames || NULL == machine_ctx ) return 0;
+
+    // Without an emulation thread running it elsewhere (or on that thread itself), the caller owns the machine
+    if( !IsMachineOnOtherThread() ) return ApplyRewind( frames );
+
+    // Otherwise the emulation thread restores the state between two instructions
+    ATOMIC_STORE( &rewind_ctx.request, frames );
+    ATOMIC_STORE( &service_deadline, 0 );
+    while( 0 != ATOMIC_LOAD( &rewind_ctx.request ) )
+        {
+            if( !IsMachineOnOtherThread() )
+                {
+                    ATOMIC_STORE( &rewind_ctx.request, 0 );
+                    return ApplyRewind( frames );
+                }
+            THREAD_SLEEP( REWIND_POLL_MS );
+        }
+
+    return rewind_ctx.result;
+}
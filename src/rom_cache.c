@@ -0,0 +1,280 @@
+/****************************** CameCore *********************************
+ *
+ * Module: ROM Image Cache
+ *
+ * Process-wide registry of loaded ROM images, keyed by 128-bit content hash, so that every
+ * instance running the same game reads from one shared, read-only copy.
+ *
+ * Key Features:
+ * - AcquireRomImage: Loads (maps) a file and returns the shared image for its content
+ * - Reopening an unchanged file (same device, inode, size and mtime) skips the load and hash entirely
+ * - ReleaseRomImage: Drops a reference; the image is evicted with the last one
+ * - Reference counted entries, lookup by content hash and size
+ * - Thread-safe: loads from concurrent sessions serialize on a spinlock
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *      wrote the original software. If you use this software in a product, an acknowledgment
+ *      in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#if !defined( _WIN32 ) && !defined( _WIN64 )
+#    define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "camecore/camecore.h"
+#include "camecore/utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined( _WIN32 ) && !defined( _WIN64 )
+#    include <sys/stat.h>
+#    define ROM_FILE_IDENTITY_SUPPORTED
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+// File an image was loaded from; all zero when unknown (never matches)
+typedef struct RomFileIdentity
+{
+    u64 device;
+    u64 inode;
+    u64 size;
+    u64 mtime_ns;
+} RomFileIdentity;
+
+// One shared ROM image
+typedef struct RomImage
+{
+    struct RomImage * next;
+    RomFileIdentity   file;     /**< File the image was loaded from */
+    RomHash           hash;     /**< Content hash (ComputeHash128) */
+    u64               byte_sum; /**< Byte sum returned with the hash */
+    size_t            size;     /**< Image size in bytes */
+    u8 *              data;     /**< Read-only image data */
+    u32               refcount; /**< Live references handed out by AcquireRomImage */
+    bool              mapped;   /**< `data` is a file mapping rather than a heap copy */
+} RomImage;
+
+typedef struct RomCacheContext
+{
+    RomImage * images; /**< Registered images */
+    long       lock;   /**< Guards `images` and every refcount */
+} RomCacheContext;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------------------------------------------
+static RomCacheContext rom_cache_ctx = { 0 };
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Declarations
+//----------------------------------------------------------------------------------------------------------------------
+extern RomHash ComputeHash128( const void * data, size_t size, u64 * outByteSum );
+
+u8 * AcquireRomImage( const char * filename, size_t * outSize, RomHash * outHash, u64 * outByteSum );
+void ReleaseRomImage( const u8 * data );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Identify `filename` by a stat, without reading it; false when the platform or the file offers no identity
+static bool
+GetRomFileIdentity( const char * filename, RomFileIdentity * identity )
+{
+    memset( identity, 0, sizeof( *identity ) );
+
+#if defined( ROM_FILE_IDENTITY_SUPPORTED )
+    struct stat st;
+
+    if( 0 != stat( filename, &st ) || !S_ISREG( st.st_mode ) ) return false;
+
+    identity->device   = (u64)st.st_dev;
+    identity->inode    = (u64)st.st_ino;
+    identity->size     = (u64)st.st_size;
+    identity->mtime_ns = (u64)st.st_mtim.tv_sec * 1000000000ULL + (u64)st.st_mtim.tv_nsec;
+    return true;
+#else
+    UNUSED( filename );
+    return false;
+#endif
+}
+
+// Take a reference to a registered image (lock held); returns the new reference count
+static u32
+ShareRomImage( RomImage * image, size_t * outSize, RomHash * outHash, u64 * outByteSum )
+{
+    *outSize    = image->size;
+    *outHash    = image->hash;
+    *outByteSum = image->byte_sum;
+    return ++image->refcount;
+}
+
+static void
+FreeRomData( u8 * data, size_t size, bool mapped )
+{
+    if( mapped )
+        UnmapFileData( data, size );
+    else
+        free( data );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Load `filename` and return the shared image holding the same bytes (NULL on failure)
+// NOTE: The returned memory is read-only and must be released with ReleaseRomImage()
+// NOTE: `outHash` and `outByteSum` receive the content identity and byte sum of the single load-time pass
+u8 *
+AcquireRomImage( const char * filename, size_t * outSize, RomHash * outHash, u64 * outByteSum )
+{
+    RomImage *      image;
+    RomFileIdentity file;
+    size_t          size;
+    u8 *            data;
+    bool            mapped = true;
+    RomHash         hash;
+    u64             byteSum;
+    u32             refs;
+
+    *outSize = 0;
+
+    // Same file as a registered image, unchanged since: share it without reading a byte
+    if( GetRomFileIdentity( filename, &file ) )
+        {
+            SPIN_LOCK( rom_cache_ctx.lock );
+
+            for( image = rom_cache_ctx.images; NULL != image; image = image->next )
+                {
+                    if( 0 == memcmp( &image->file, &file, sizeof( file ) ) ) break;
+                }
+
+            if( NULL != image )
+                {
+                    refs = ShareRomImage( image, outSize, outHash, outByteSum );
+                    data = image->data;
+                    SPIN_UNLOCK( rom_cache_ctx.lock );
+
+                    LOG( LOG_INFO, "ROMCACHE: [%s] Sharing cached image %016llX%016llX (%u refs, file unchanged)",
+                         filename, (unsigned long long)outHash->hi, (unsigned long long)outHash->lo, refs );
+                    UNUSED( refs ); // Only logged
+                    return data;
+                }
+
+            SPIN_UNLOCK( rom_cache_ctx.lock );
+        }
+
+    // Bring the file in: the hash below reads every byte of it, mapped or not
+    data = MapFileData( filename, &size );
+    if( NULL == data )
+        {
+            mapped = false;
+            data   = LoadFileData( filename, &size );
+        }
+    if( NULL == data || 0 == size ) return NULL;
+
+    hash = ComputeHash128( data, size, &byteSum );
+
+    SPIN_LOCK( rom_cache_ctx.lock );
+
+    for( image = rom_cache_ctx.images; NULL != image; image = image->next )
+        {
+            if( image->hash.lo == hash.lo && image->hash.hi == hash.hi && image->size == size ) break;
+        }
+
+    if( NULL != image )
+        {
+            // Already registered: share it and drop the fresh copy
+            u8 * const shared = image->data;
+
+            refs = ShareRomImage( image, outSize, outHash, outByteSum );
+            SPIN_UNLOCK( rom_cache_ctx.lock );
+
+            FreeRomData( data, size, mapped );
+            LOG( LOG_INFO, "ROMCACHE: [%s] Sharing cached image %016llX%016llX (%u refs)", filename,
+                 (unsigned long long)hash.hi, (unsigned long long)hash.lo, refs );
+            UNUSED( refs ); // Only logged
+            return shared;
+        }
+
+    image = (RomImage *)calloc( 1, sizeof( RomImage ) );
+    if( NULL == image )
+        {
+            SPIN_UNLOCK( rom_cache_ctx.lock );
+            FreeRomData( data, size, mapped );
+            return NULL;
+        }
+
+    image->file          = file;
+    image->hash          = hash;
+    image->byte_sum      = byteSum;
+    image->size          = size;
+    image->data          = data;
+    image->refcount      = 1;
+    image->mapped        = mapped;
+    image->next          = rom_cache_ctx.images;
+    rom_cache_ctx.images = image;
+
+    SPIN_UNLOCK( rom_cache_ctx.lock );
+
+    *outSize    = size;
+    *outHash    = hash;
+    *outByteSum = byteSum;
+    return data;
+}
+
+// Drop one reference to the image owning `data`, evicting it with the last one
+void
+ReleaseRomImage( const u8 * data )
+{
+    RomImage ** link;
+    RomImage *  image = NULL;
+
+    if( NULL == data ) return;
+
+    SPIN_LOCK( rom_cache_ctx.lock );
+
+    for( link = &rom_cache_ctx.images; NULL != *link; link = &( *link )->next )
+        {
+            if( ( *link )->data == data )
+                {
+                    image = *link;
+                    if( 0 == --image->refcount )
+                        {
+                            *link = image->next; // Unlink now, free outside the lock
+                        }
+                    else
+                        {
+                            image = NULL;
+                        }
+                    break;
+                }
+        }
+
+    SPIN_UNLOCK( rom_cache_ctx.lock );
+
+    if( NULL != image )
+        {
+            FreeRomData( image->data, image->size, image->mapped );
+            free( image );
+        }
+}
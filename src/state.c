@@ -0,0 +1,622 @@
+/****************************** CameCore *********************************
+ *
+ * Module: State
+ *
+ * Serializes the running machine into a compact binary save state and restores it.
+ *
+ * Key Features:
+ * - Versioned header tagged with the ROM content hash (states only load on the same ROM)
+ * - Chunked payload (tag + size), 8-byte aligned; unknown chunks are skipped on load
+ * - Chunks: CPU, cycle counter, WRAM, VRAM, OAM, HRAM, I/O, PPU timing, MBC, clock, cartridge RAM
+ * - Only the banks the machine can use are written (DMG: 2 WRAM banks, 1 VRAM bank)
+ * - Loads are validated completely before anything is applied
+ * - State files are compressed with the built-in codec; raw states still load
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *      wrote the original software. If you use this software in a product, an acknowledgment
+ *      in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#include "camecore/camecore.h"
+#include "camecore/machine.h"
+#include "camecore/utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Defines and Macros
+//----------------------------------------------------------------------------------------------------------------------
+#define STATE_MAGIC   0x54534343U /**< "CCST" */
+#define STATE_VERSION 1           /**< Bump whenever a chunk layout changes */
+#define STATE_ALIGN   8           /**< Chunk payloads are padded to this many bytes */
+
+#define STATE_TAG( a, b, c, d ) ( (u32)( a ) | ( (u32)( b ) << 8 ) | ( (u32)( c ) << 16 ) | ( (u32)( d ) << 24 ) )
+#define STATE_PADDED( size )    ( ( (size) + STATE_ALIGN - 1 ) & ~(size_t)( STATE_ALIGN - 1 ) )
+
+// Chunk tags
+#define TAG_CPU  STATE_TAG( 'C', 'P', 'U', ' ' )
+#define TAG_TIME STATE_TAG( 'T', 'I', 'M', 'E' )
+#define TAG_WRAM STATE_TAG( 'W', 'R', 'A', 'M' )
+#define TAG_VRAM STATE_TAG( 'V', 'R', 'A', 'M' )
+#define TAG_OAM  STATE_TAG( 'O', 'A', 'M', ' ' )
+#define TAG_HRAM STATE_TAG( 'H', 'R', 'A', 'M' )
+#define TAG_IO   STATE_TAG( 'I', 'O', ' ', ' ' )
+#define TAG_PPU  STATE_TAG( 'P', 'P', 'U', ' ' )
+#define TAG_MBC  STATE_TAG( 'M', 'B', 'C', ' ' )
+#define TAG_RTC  STATE_TAG( 'R', 'T', 'C', ' ' )
+#define TAG_SRAM STATE_TAG( 'S', 'R', 'A', 'M' )
+
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+// File layout: header, then `chunk_count` chunks (StateChunk + padded payload)
+// NOTE: Fields are stored in host byte order, like the ROM library index
+typedef struct StateHeader
+{
+    u32     magic;
+    u16     version;
+    u16     chunk_count;
+    u32     size; /**< Whole state, header included */
+    u32     reserved;
+    RomHash hash; /**< ROM the state was taken on */
+} StateHeader;
+
+typedef struct StateChunk
+{
+    u32 tag;
+    u32 size; /**< Payload bytes, padding excluded */
+} StateChunk;
+
+typedef struct StateCPU
+{
+    u8  a, f, b, c, d, e, h, l;
+    u16 pc;
+    u16 sp;
+    u8  ime;
+    u8  ime_scheduled;
+    u8  ie_reg;
+    u8  if_reg;
+    u8  halted;
+    u8  stop;
+    u8  reserved[2];
+} StateCPU;
+
+// Prefix of the WRAM and VRAM chunks, followed by `count` banks
+typedef struct StateBanks
+{
+    u8 bank;  /**< Selected bank */
+    u8 count; /**< Banks stored */
+    u8 reserved[6];
+} StateBanks;
+
+typedef struct StatePPU
+{
+    u64 deadline; /**< Absolute tick, like the cycle counter */
+    u8  window_line;
+    u8  reserved[7];
+} StatePPU;
+
+typedef struct StateMBC
+{
+    u16 rom_bank;
+    u8  bank_hi;
+    u8  mode;
+    u8  ram_enabled;
+    u8  type; /**< Checked against the loaded cartridge */
+    u8  reserved[2];
+} StateMBC;
+
+typedef struct StateClock
+{
+    u64 seconds;
+    i64 base;
+    u8  halted;
+    u8  carry;
+    u8  latch;
+    u8  latched[RTC_REG_COUNT];
+} StateClock;
+
+STATIC_ASSERT( 32 == sizeof( StateHeader ), "StateHeader layout changed" );
+STATIC_ASSERT( 20 == sizeof( StateCPU ), "StateCPU layout changed" );
+STATIC_ASSERT( 8 == sizeof( StateBanks ), "StateBanks layout changed" );
+STATIC_ASSERT( 16 == sizeof( StatePPU ), "StatePPU layout changed" );
+STATIC_ASSERT( 8 == sizeof( StateMBC ), "StateMBC layout changed" );
+STATIC_ASSERT( 24 == sizeof( StateClock ), "StateClock layout changed" );
+
+// Cursor over the state being written
+typedef struct StateWriter
+{
+    u8 *   data;
+    size_t size;
+    u16    chunks;
+} StateWriter;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------------------------------------------
+extern THREAD_LOCAL Machine * machine_ctx; // State is read from and written to the machine arena
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Declarations
+//----------------------------------------------------------------------------------------------------------------------
+extern size_t GetCartridgeRAMSize( void );
+extern void   RestoreCartridgeBanks( void );
+extern void   SetWRAMBank( u8 bank );
+extern void   SetVRAMBank( u8 bank );
+extern void   MarkAllBusPagesDirty( void );
+
+bool LoadStateKeepingSave( const u8 * data, size_t size );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Number of WRAM and VRAM banks the current cartridge can select
+static INLINE u8
+GetWRAMBankCount( void )
+{
+    return IsCartridgeCGB() ? WRAM_BANKS : 2;
+}
+
+static INLINE u8
+GetVRAMBankCount( void )
+{
+    return IsCartridgeCGB() ? VRAM_BANKS : 1;
+}
+
+// Open a chunk and return its payload, zeroing the padding after it
+static u8 *
+BeginChunk( StateWriter * writer, u32 tag, size_t size )
+{
+    StateChunk * const chunk   = (StateChunk *)( writer->data + writer->size );
+    u8 * const         payload = (u8 *)( chunk + 1 );
+
+    chunk->tag  = tag;
+    chunk->size = (u32)size;
+    memset( payload + size, 0, STATE_PADDED( size ) - size );
+
+    writer->size += sizeof( StateChunk ) + STATE_PADDED( size );
+    ++writer->chunks;
+    return payload;
+}
+
+static void
+WriteBankChunk( StateWriter * writer, u32 tag, u8 bank, u8 count, const u8 * banks, size_t bankSize )
+{
+    u8 * const         payload = BeginChunk( writer, tag, sizeof( StateBanks ) + count * bankSize );
+    StateBanks * const header  = (StateBanks *)payload;
+
+    memset( header, 0, sizeof( *header ) );
+    header->bank  = bank;
+    header->count = count;
+    memcpy( payload + sizeof( StateBanks ), banks, count * bankSize );
+}
+
+// Check a WRAM/VRAM chunk against the banks this machine has
+static bool
+IsBankChunkValid( const u8 * payload, u32 size, u8 maxCount, size_t bankSize )
+{
+    const StateBanks * const header = (const StateBanks *)payload;
+
+    return size >= sizeof( StateBanks ) && header->count <= maxCount
+           && size == sizeof( StateBanks ) + header->count * bankSize;
+}
+
+// Copy stored banks back and clear the ones the state does not carry
+static void
+ReadBankChunk( const u8 * payload, u8 * banks, u8 maxCount, size_t bankSize )
+{
+    const StateBanks * const header = (const StateBanks *)payload;
+
+    memcpy( banks, payload + sizeof( StateBanks ), header->count * bankSize );
+    memset( banks + header->count * bankSize, 0, ( maxCount - header->count ) * bankSize );
+}
+
+// Check one chunk before anything is applied; unknown tags are accepted and later skipped
+static bool
+IsChunkValid( u32 tag, const u8 * payload, u32 size )
+{
+    switch( tag )
+        {
+            case TAG_CPU: return sizeof( StateCPU ) == size;
+            case TAG_TIME: return sizeof( u64 ) == size;
+            case TAG_WRAM: return IsBankChunkValid( payload, size, WRAM_BANKS, WRAM_BANK_SIZE );
+            case TAG_VRAM: return IsBankChunkValid( payload, size, VRAM_BANKS, VRAM_SIZE );
+            case TAG_OAM: return OAM_SIZE == size;
+            case TAG_HRAM: return HRAM_SIZE == size;
+            case TAG_IO: return IO_SIZE == size;
+            case TAG_PPU: return sizeof( StatePPU ) == size;
+            case TAG_MBC:
+                return sizeof( StateMBC ) == size
+                       && machine_ctx->cart.mbc.type == (MBCType)( (const StateMBC *)payload )->type;
+            case TAG_RTC: return sizeof( StateClock ) == size && machine_ctx->cart.rtc.present;
+            case TAG_SRAM: return GetCartridgeRAMSize() == size;
+            default: return true;
+        }
+}
+
+// Apply one validated chunk to the machine
+static void
+ApplyChunk( u32 tag, const u8 * payload )
+{
+    Machine * const m = machine_ctx;
+
+    switch( tag )
+        {
+            case TAG_CPU:
+                {
+                    const StateCPU * const cpu = (const StateCPU *)payload;
+
+                    m->cpu.regs.a                       = cpu->a;
+                    m->cpu.regs.f                       = cpu->f;
+                    m->cpu.regs.b                       = cpu->b;
+                    m->cpu.regs.c                       = cpu->c;
+                    m->cpu.regs.d                       = cpu->d;
+                    m->cpu.regs.e                       = cpu->e;
+                    m->cpu.regs.h                       = cpu->h;
+                    m->cpu.regs.l                       = cpu->l;
+                    m->cpu.regs.pc                      = cpu->pc;
+                    m->cpu.regs.sp                      = cpu->sp;
+                    m->cpu.interupt_state.ime           = ( 0 != cpu->ime );
+                    m->cpu.interupt_state.ime_scheduled = ( 0 != cpu->ime_scheduled );
+                    m->cpu.interupt_state.ie_reg        = cpu->ie_reg;
+                    m->cpu.interupt_state.if_reg        = cpu->if_reg;
+                    m->cpu.status.halted                = ( 0 != cpu->halted );
+                    m->cpu.status.stop                  = ( 0 != cpu->stop );
+                    break;
+                }
+
+            // The PPU chunk follows; states without one make the PPU resync on its next check
+            case TAG_TIME:
+                memcpy( &m->ticks, payload, sizeof( m->ticks ) );
+                m->ppu.deadline = m->ticks;
+                break;
+
+            case TAG_WRAM:
+                ReadBankChunk( payload, m->ram.wram[0], WRAM_BANKS, WRAM_BANK_SIZE );
+                SetWRAMBank( ( (const StateBanks *)payload )->bank );
+                break;
+
+            case TAG_VRAM:
+                ReadBankChunk( payload, m->ram.vram[0], VRAM_BANKS, VRAM_SIZE );
+                SetVRAMBank( ( (const StateBanks *)payload )->bank );
+                memset( m->ppu.tile_dirty, 0xFF, sizeof( m->ppu.tile_dirty ) ); // Tile cache is not saved
+                break;
+
+            case TAG_OAM: memcpy( m->ram.oam, payload, OAM_SIZE ); break;
+            case TAG_HRAM: memcpy( m->ram.hram, payload, HRAM_SIZE ); break;
+
+            // Raw register bytes: restoring must not replay write side effects
+            case TAG_IO:
+                for( u32 i = 0; i < IO_SIZE; ++i ) m->io.regs[i].value = payload[i];
+                break;
+
+            case TAG_PPU:
+                {
+                    const StatePPU * const ppu = (const StatePPU *)payload;
+
+                    m->ppu.deadline            = ppu->deadline;
+                    m->ppu.window_line         = ppu->window_line;
+                    break;
+                }
+
+            case TAG_MBC:
+                {
+                    const StateMBC * const mbc = (const StateMBC *)payload;
+
+                    m->cart.mbc.rom_bank    = mbc->rom_bank;
+                    m->cart.mbc.bank_hi     = mbc->bank_hi;
+                    m->cart.mbc.mode        = mbc->mode;
+                    m->cart.mbc.ram_enabled = ( 0 != mbc->ram_enabled );
+                    break;
+                }
+
+            case TAG_RTC:
+                {
+                    const StateClock * const rtc = (const StateClock *)payload;
+
+                    m->cart.rtc.seconds = rtc->seconds;
+                    m->cart.rtc.base    = rtc->base;
+                    m->cart.rtc.halted  = ( 0 != rtc->halted );
+                    m->cart.rtc.carry   = ( 0 != rtc->carry );
+                    m->cart.rtc.latch   = rtc->latch;
+                    memcpy( m->cart.rtc.latched, rtc->latched, RTC_REG_COUNT );
+                    break;
+                }
+
+            case TAG_SRAM: memcpy( m->cart_ram, payload, GetCartridgeRAMSize() ); break;
+
+            default: break;
+        }
+}
+
+// Walk the chunks of a state, validating them (`apply` false) or applying them (`apply` true)
+// NOTE: `keepSave` leaves the battery RAM and the clock out: they belong to the player's save, not the checkpoint
+static bool
+ProcessChunks( const u8 * data, size_t size, bool apply, bool keepSave )
+{
+    const StateHeader * const header = (const StateHeader *)data;
+    size_t                    offset = sizeof( StateHeader );
+
+    for( u16 i = 0; i < header->chunk_count; ++i )
+        {
+            const StateChunk * chunk;
+
+            if( size - offset < sizeof( StateChunk ) ) return false;
+            chunk = (const StateChunk *)( data + offset );
+            if( size - offset - sizeof( StateChunk ) < STATE_PADDED( chunk->size ) ) return false;
+
+            if( apply )
+                {
+                    const bool saved = ( TAG_SRAM == chunk->tag || TAG_RTC == chunk->tag );
+
+                    if( !keepSave || !saved ) ApplyChunk( chunk->tag, (const u8 *)( chunk + 1 ) );
+                }
+            else if( !IsChunkValid( chunk->tag, (const u8 *)( chunk + 1 ), chunk->size ) )
+                {
+                    LOG( LOG_WARNING, "STATE: Chunk %.4s does not match this machine", (const char *)&chunk->tag );
+                    return false;
+                }
+
+            offset += sizeof( StateChunk ) + STATE_PADDED( chunk->size );
+        }
+
+    return true;
+}
+
+// Check a raw state against the machine, then apply it
+static bool
+RestoreState( const u8 * data, size_t size, bool keepSave )
+{
+    const StateHeader * const header = (const StateHeader *)data;
+    const RomHash             hash   = GetCartridgeHash();
+
+    if( NULL == machine_ctx || NULL == data || size < sizeof( StateHeader ) ) return false;
+
+    if( STATE_MAGIC != header->magic || header->size > size || header->size < sizeof( StateHeader ) )
+        {
+            LOG( LOG_WARNING, "STATE: Not a save state" );
+            return false;
+        }
+    if( STATE_VERSION != header->version )
+        {
+            LOG( LOG_WARNING, "STATE: Unsupported version %u (expected %u)", header->version, STATE_VERSION );
+            return false;
+        }
+    if( hash.lo != header->hash.lo || hash.hi != header->hash.hi )
+        {
+            LOG( LOG_WARNING, "STATE: Taken on another ROM" );
+            return false;
+        }
+
+    if( !ProcessChunks( data, header->size, false, false ) )
+        {
+            LOG( LOG_WARNING, "STATE: Corrupted or incompatible state" );
+            return false;
+        }
+
+    ProcessChunks( data, header->size, true, keepSave );
+    RestoreCartridgeBanks();
+    MarkAllBusPagesDirty();
+
+    return true;
+}
+
+// Restore a state held in a file image, either compressed or raw
+static bool
+LoadStateFile( const u8 * data, size_t size )
+{
+    const size_t rawSize = GetDecompressedSize( data, size );
+    u8 *         raw;
+    bool         loaded;
+
+    if( 0 == rawSize ) return LoadStateFromMemory( data, size );
+
+    raw = (u8 *)malloc( rawSize );
+    if( NULL == raw ) return false;
+
+    loaded = ( rawSize == DecompressData( data, size, raw, rawSize, 1 ) ) && LoadStateFromMemory( raw, rawSize );
+
+    free( raw );
+    return loaded;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Get the number of bytes a save state of the running machine takes
+size_t
+GetStateSize( void )
+{
+    size_t size = sizeof( StateHeader );
+
+    size += sizeof( StateChunk ) + STATE_PADDED( sizeof( StateCPU ) );
+    size += sizeof( StateChunk ) + STATE_PADDED( sizeof( u64 ) );
+    size += sizeof( StateChunk ) + sizeof( StateBanks ) + GetWRAMBankCount() * (size_t)WRAM_BANK_SIZE;
+    size += sizeof( StateChunk ) + sizeof( StateBanks ) + GetVRAMBankCount() * (size_t)VRAM_SIZE;
+    size += sizeof( StateChunk ) + STATE_PADDED( OAM_SIZE );
+    size += sizeof( StateChunk ) + STATE_PADDED( HRAM_SIZE );
+    size += sizeof( StateChunk ) + STATE_PADDED( IO_SIZE );
+    size += sizeof( StateChunk ) + STATE_PADDED( sizeof( StatePPU ) );
+    size += sizeof( StateChunk ) + STATE_PADDED( sizeof( StateMBC ) );
+    if( NULL != machine_ctx && machine_ctx->cart.rtc.present )
+        {
+            size += sizeof( StateChunk ) + STATE_PADDED( sizeof( StateClock ) );
+        }
+    if( 0 != GetCartridgeRAMSize() ) size += sizeof( StateChunk ) + STATE_PADDED( GetCartridgeRAMSize() );
+
+    return size;
+}
+
+// Write a save state into `buffer` (8-byte aligned); returns the bytes written, 0 when `capacity` is too small
+// NOTE: Call while the emulation is paused or from the emulation thread
+size_t
+SaveStateToMemory( u8 * buffer, size_t capacity )
+{
+    const Machine * const m      = machine_ctx;
+    StateWriter           writer = { buffer, sizeof( StateHeader ), 0 };
+    StateHeader * const   header = (StateHeader *)buffer;
+    u8 *                  payload;
+
+    if( NULL == m || NULL == buffer || capacity < GetStateSize() ) return 0;
+
+    // CPU
+    {
+        StateCPU * const cpu = (StateCPU *)BeginChunk( &writer, TAG_CPU, sizeof( StateCPU ) );
+
+        cpu->a             = m->cpu.regs.a;
+        cpu->f             = m->cpu.regs.f;
+        cpu->b             = m->cpu.regs.b;
+        cpu->c             = m->cpu.regs.c;
+        cpu->d             = m->cpu.regs.d;
+        cpu->e             = m->cpu.regs.e;
+        cpu->h             = m->cpu.regs.h;
+        cpu->l             = m->cpu.regs.l;
+        cpu->pc            = m->cpu.regs.pc;
+        cpu->sp            = m->cpu.regs.sp;
+        cpu->ime           = m->cpu.interupt_state.ime;
+        cpu->ime_scheduled = m->cpu.interupt_state.ime_scheduled;
+        cpu->ie_reg        = m->cpu.interupt_state.ie_reg;
+        cpu->if_reg        = m->cpu.interupt_state.if_reg;
+        cpu->halted        = m->cpu.status.halted;
+        cpu->stop          = m->cpu.status.stop;
+        cpu->reserved[0]   = 0;
+        cpu->reserved[1]   = 0;
+    }
+
+    // Cycle counter; the PPU deadline is saved with the registers
+    payload = BeginChunk( &writer, TAG_TIME, sizeof( u64 ) );
+    memcpy( payload, &m->ticks, sizeof( u64 ) );
+
+    // Memory
+    WriteBankChunk( &writer, TAG_WRAM, m->ram.wram_bank, GetWRAMBankCount(), m->ram.wram[0], WRAM_BANK_SIZE );
+    WriteBankChunk( &writer, TAG_VRAM, m->ram.vram_bank, GetVRAMBankCount(), m->ram.vram[0], VRAM_SIZE );
+    memcpy( BeginChunk( &writer, TAG_OAM, OAM_SIZE ), m->ram.oam, OAM_SIZE );
+    memcpy( BeginChunk( &writer, TAG_HRAM, HRAM_SIZE ), m->ram.hram, HRAM_SIZE );
+
+    // Registers
+    payload = BeginChunk( &writer, TAG_IO, IO_SIZE );
+    for( u32 i = 0; i < IO_SIZE; ++i ) payload[i] = m->io.regs[i].value;
+
+    {
+        StatePPU * const ppu = (StatePPU *)BeginChunk( &writer, TAG_PPU, sizeof( StatePPU ) );
+
+        memset( ppu, 0, sizeof( *ppu ) );
+        ppu->deadline    = m->ppu.deadline;
+        ppu->window_line = m->ppu.window_line;
+    }
+
+    {
+        StateMBC * const mbc = (StateMBC *)BeginChunk( &writer, TAG_MBC, sizeof( StateMBC ) );
+
+        memset( mbc, 0, sizeof( *mbc ) );
+        mbc->rom_bank    = m->cart.mbc.rom_bank;
+        mbc->bank_hi     = m->cart.mbc.bank_hi;
+        mbc->mode        = m->cart.mbc.mode;
+        mbc->ram_enabled = m->cart.mbc.ram_enabled;
+        mbc->type        = (u8)m->cart.mbc.type;
+    }
+
+    if( m->cart.rtc.present )
+        {
+            StateClock * const rtc = (StateClock *)BeginChunk( &writer, TAG_RTC, sizeof( StateClock ) );
+
+            rtc->seconds = m->cart.rtc.seconds;
+            rtc->base    = m->cart.rtc.base;
+            rtc->halted  = m->cart.rtc.halted;
+            rtc->carry   = m->cart.rtc.carry;
+            rtc->latch   = m->cart.rtc.latch;
+            memcpy( rtc->latched, m->cart.rtc.latched, RTC_REG_COUNT );
+        }
+
+    // Cartridge RAM
+    if( 0 != GetCartridgeRAMSize() )
+        {
+            memcpy( BeginChunk( &writer, TAG_SRAM, GetCartridgeRAMSize() ), m->cart_ram, GetCartridgeRAMSize() );
+        }
+
+    header->magic       = STATE_MAGIC;
+    header->version     = STATE_VERSION;
+    header->chunk_count = writer.chunks;
+    header->size        = (u32)writer.size;
+    header->reserved    = 0;
+    header->hash        = GetCartridgeHash();
+
+    return writer.size;
+}
+
+// Restore a save state taken on the same ROM; the machine is left untouched when it is rejected
+// NOTE: Call while the emulation is paused or from the emulation thread
+bool
+LoadStateFromMemory( const u8 * data, size_t size )
+{
+    return RestoreState( data, size, false );
+}
+
+// Restore a save state but keep the cartridge's battery RAM and clock (warm starts)
+bool
+LoadStateKeepingSave( const u8 * data, size_t size )
+{
+    return RestoreState( data, size, true );
+}
+
+// Write a save state file, compressed with the built-in codec
+bool
+SaveState( const char * filename )
+{
+    const size_t capacity = GetStateSize();
+    const size_t bound    = GetCompressBound( capacity );
+    u8 * const   buffer   = (u8 *)malloc( capacity + bound );
+    size_t       size;
+    bool         saved;
+
+    if( NULL == buffer ) return false;
+
+    size  = SaveStateToMemory( buffer, capacity );
+    size  = ( 0 != size ) ? CompressData( buffer, size, buffer + capacity, bound, 1 ) : 0;
+    saved = ( 0 != size ) && SaveFileData( filename, buffer + capacity, size );
+
+    free( buffer );
+    return saved;
+}
+
+// Restore a save state file, mapped rather than read where the platform allows it
+bool
+LoadState( const char * filename )
+{
+    size_t size;
+    bool   loaded;
+    u8 *   data = MapFileData( filename, &size );
+
+    if( NULL != data )
+        {
+            loaded = LoadStateFile( data, size );
+            UnmapFileData( data, size );
+            return loaded;
+        }
+
+    data = LoadFileData( filename, &size );
+    if( NULL == data ) return false;
+
+    loaded = LoadStateFile( data, size );
+    free( data );
+    return loaded;
+}
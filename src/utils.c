@@ -8,7 +8,13 @@
  * Key Features:
  * - SetLogLevel: Configures the minimum log level for message display.
  * - TraceLog: Logs messages based on the specified log level.
+ * - SetTraceLogAsync: Hands formatted records to a background writer through a lock-free MPSC ring of
+ *   preallocated slots, so the emulation thread never allocates nor blocks on terminal I/O (POSIX only).
+ * - FlushTraceLog: Waits for queued records to reach stderr (also done before aborting on LOG_FATAL).
  * - LoadFileData: Loads a binary file into memory, returning the data and its size.
+ * - MapFileData: Maps a file read-only (copy-on-write private mapping), paged in on demand (POSIX only).
+ * - MapFileShared / SyncMappedFile: Writable shared file mapping, flushed back with msync (POSIX only).
+ * - SleepMilliseconds: Portable millisecond sleep backing THREAD_SLEEP.
  * - SaveFileData: Saves binary data to a specified file.
  *
  *                               LICENSE
@@ -34,6 +40,10 @@
  *
  *************************************************************************/
 
+#if !defined( _WIN32 ) && !defined( _WIN64 )
+#    define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "camecore/utils.h"
 #include "camecore/camecore.h"
 
@@ -42,6 +52,17 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined( _WIN32 ) && !defined( _WIN64 )
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <sys/uio.h>
+#    include <time.h>
+#    define PLATFORM_POSIX
+#    define TRACELOG_ASYNC_SUPPORTED
+#endif
+
 //----------------------------------------------------------------------------------------------------------------------
 // Defines
 //----------------------------------------------------------------------------------------------------------------------
@@ -53,6 +74,46 @@
 #    endif
 #endif
 
+#ifndef MAX_TRACELOG_MSG_LENGTH
+#    define MAX_TRACELOG_MSG_LENGTH 512
+#endif
+
+#define TRACELOG_BATCH_SIZE       64   /**< Records gathered into a single writev() call */
+#define TRACELOG_RING_SIZE        256  /**< Records the writer may lag behind (power of two) */
+#define TRACELOG_POLL_MS          1    /**< FlushTraceLog() wake-up granularity */
+#define TRACELOG_FLUSH_TIMEOUT_MS 1000 /**< Upper bound for FlushTraceLog() to wait on the writer */
+
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+#if defined( TRACELOG_ASYNC_SUPPORTED )
+// Ring slot holding a formatted log line
+typedef struct LogRecord
+{
+    unsigned int sequence;                      /**< Ticket + 1 once written, ticket + ring size once consumed */
+    unsigned int length;                        /**< Bytes in text, newline included */
+    char         text[MAX_TRACELOG_MSG_LENGTH]; /**< "[LEVEL] message\n", not NUL terminated */
+} LogRecord;
+
+// Bounded MPSC ring (Vyukov): producers take tickets, consumers drain in ticket order under `drain`
+// NOTE: Positions and slots are never reset, so records that race a shutdown are kept for the next drain
+typedef struct LogQueue
+{
+    LogRecord       ring[TRACELOG_RING_SIZE];
+    unsigned int    claimed; /**< Tickets handed to producers */
+    unsigned int    read;    /**< Next ticket to consume (under `drain`) */
+    unsigned int    written; /**< Records handed to writev() so far */
+    bool            ready;   /**< Slot sequences initialized */
+    bool            enabled; /**< Producers route through the ring */
+    bool            running; /**< Writer keeps waiting for records */
+    bool            idle;    /**< Writer is (about to be) asleep on `wake` */
+    pthread_mutex_t drain;   /**< Single consumer at a time: writer, or a thread draining on its own */
+    pthread_mutex_t lock;    /**< Guards the writer's sleep */
+    pthread_cond_t  wake;
+    THREAD_HANDLE   writer;
+} LogQueue;
+#endif
+
 //----------------------------------------------------------------------------------------------------------------------
 // Variables Definition
 //----------------------------------------------------------------------------------------------------------------------
@@ -61,6 +122,206 @@ static int logLevel = LOG_INFO;
 // Callbacks
 static TraceLogCallback traceLog = NULL;
 
+#if defined( TRACELOG_ASYNC_SUPPORTED )
+static LogQueue logQueue = { .drain = PTHREAD_MUTEX_INITIALIZER,
+                             .lock  = PTHREAD_MUTEX_INITIALIZER,
+                             .wake  = PTHREAD_COND_INITIALIZER };
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definition: Logging
+//----------------------------------------------------------------------------------------------------------------------
+static const char *
+GetLogLevelString( i32 logType )
+{
+    switch( logType )
+        {
+            case LOG_TRACE:   return "TRACE";
+            case LOG_DEBUG:   return "DEBUG";
+            case LOG_INFO:    return "INFO";
+            case LOG_WARNING: return "WARNING";
+            case LOG_ERROR:   return "ERROR";
+            case LOG_FATAL:   return "FATAL";
+            default:          return "UNKNOWN";
+        }
+}
+
+#if defined( TRACELOG_ASYNC_SUPPORTED )
+// Check whether the next record to consume has been written
+// NOTE: Call with `drain` held
+static bool
+IsLogRecordReady( void )
+{
+    const unsigned int read = logQueue.read;
+
+    return read + 1 == ATOMIC_LOAD( &logQueue.ring[read & ( TRACELOG_RING_SIZE - 1 )].sequence );
+}
+
+static bool
+HasLogRecords( void )
+{
+    bool ready;
+
+    pthread_mutex_lock( &logQueue.drain );
+    ready = IsLogRecordReady();
+    pthread_mutex_unlock( &logQueue.drain );
+
+    return ready;
+}
+
+// Write all vectors, resuming after short writes
+static void
+WriteLogBatch( struct iovec * iov, int count )
+{
+    while( count > 0 )
+        {
+            ssize_t written = writev( STDERR_FILENO, iov, count );
+            if( written < 0 )
+                {
+                    if( EINTR == errno ) continue;
+                    return; // stderr is gone; drop the batch
+                }
+
+            while( count > 0 && (size_t)written >= iov->iov_len )
+                {
+                    written -= (ssize_t)iov->iov_len;
+                    ++iov;
+                    --count;
+                }
+
+            if( count > 0 )
+                {
+                    iov->iov_base  = (char *)iov->iov_base + written;
+                    iov->iov_len  -= (size_t)written;
+                }
+        }
+}
+
+// Write the records queued right now, up to a batch; returns the number of records written
+static int
+DrainLogQueue( void )
+{
+    struct iovec iov[TRACELOG_BATCH_SIZE];
+    unsigned int first;
+    int          count = 0;
+
+    pthread_mutex_lock( &logQueue.drain );
+
+    first = logQueue.read;
+    while( count < TRACELOG_BATCH_SIZE && IsLogRecordReady() )
+        {
+            LogRecord * const record = &logQueue.ring[logQueue.read++ & ( TRACELOG_RING_SIZE - 1 )];
+
+            iov[count].iov_base = record->text;
+            iov[count].iov_len  = record->length;
+            ++count;
+        }
+
+    if( count > 0 )
+        {
+            WriteLogBatch( iov, count );
+
+            // Hand the slots back to the producers of the next lap
+            for( int i = 0; i < count; ++i )
+                {
+                    const unsigned int ticket = first + (unsigned int)i;
+
+                    ATOMIC_STORE( &logQueue.ring[ticket & ( TRACELOG_RING_SIZE - 1 )].sequence,
+                                  ticket + TRACELOG_RING_SIZE );
+                }
+            ATOMIC_ADD( &logQueue.written, (unsigned int)count );
+        }
+
+    pthread_mutex_unlock( &logQueue.drain );
+    return count;
+}
+
+// Write every record already queued
+static void
+DrainLogQueueAll( void )
+{
+    while( DrainLogQueue() > 0 ) {}
+}
+
+static THREAD_RETURN
+TraceLogWriter( THREAD_PARAM arg )
+{
+    UNUSED( arg );
+
+    for( ;; )
+        {
+            if( DrainLogQueue() > 0 ) continue;
+
+            // Sleep until a producer or the shutdown wakes us; the fences pair with EnqueueTraceLog()
+            pthread_mutex_lock( &logQueue.lock );
+            ATOMIC_STORE( &logQueue.idle, true );
+            ATOMIC_FENCE();
+            if( ATOMIC_LOAD( &logQueue.running ) && !HasLogRecords() )
+                {
+                    pthread_cond_wait( &logQueue.wake, &logQueue.lock );
+                }
+            ATOMIC_STORE( &logQueue.idle, false );
+            pthread_mutex_unlock( &logQueue.lock );
+
+            if( !ATOMIC_LOAD( &logQueue.running ) )
+                {
+                    DrainLogQueueAll();
+                    break;
+                }
+        }
+
+    return 0;
+}
+
+static void
+WakeTraceLogWriter( void )
+{
+    pthread_mutex_lock( &logQueue.lock );
+    pthread_cond_signal( &logQueue.wake );
+    pthread_mutex_unlock( &logQueue.lock );
+}
+
+// Format on the caller's stack, then copy into a ring slot; false when the ring is full
+static bool
+EnqueueTraceLog( i32 logType, const char * text, va_list args )
+{
+    char         line[MAX_TRACELOG_MSG_LENGTH];
+    LogRecord *  record;
+    unsigned int ticket;
+    int          prefix, length;
+
+    prefix = snprintf( line, sizeof( line ), "[%s] ", GetLogLevelString( logType ) );
+    length = vsnprintf( line + prefix, sizeof( line ) - (size_t)prefix, text, args );
+    if( length < 0 ) return false;
+
+    length += prefix;
+    if( length > (int)sizeof( line ) - 1 ) length = (int)sizeof( line ) - 1; // Truncated
+
+    // Rather write synchronously than wait on a writer this far behind
+    if( ATOMIC_LOAD( &logQueue.claimed ) - ATOMIC_LOAD( &logQueue.written ) >= TRACELOG_RING_SIZE ) return false;
+
+    ticket = ATOMIC_ADD( &logQueue.claimed, 1 ) - 1;
+    record = &logQueue.ring[ticket & ( TRACELOG_RING_SIZE - 1 )];
+
+    // Only producers racing past the check above can find their slot still in use
+    while( ticket != ATOMIC_LOAD( &record->sequence ) ) sched_yield();
+
+    memcpy( record->text, line, (size_t)length );
+    record->text[length] = '\n';
+    record->length       = (unsigned int)length + 1;
+    ATOMIC_STORE( &record->sequence, ticket + 1 );
+
+    // Either the writer sees this record before sleeping, or this thread sees it idle (or gone)
+    ATOMIC_FENCE();
+    if( !ATOMIC_LOAD( &logQueue.running ) )
+        DrainLogQueueAll(); // Async logging was switched off meanwhile: nobody else will write it
+    else if( ATOMIC_LOAD( &logQueue.idle ) )
+        WakeTraceLogWriter();
+
+    return true;
+}
+#endif
+
 //----------------------------------------------------------------------------------------------------------------------
 // Module Functions Definition: Utilities
 //----------------------------------------------------------------------------------------------------------------------
@@ -79,8 +340,7 @@ SetLogLevel( i32 logType )
 void
 TraceLog( i32 logType, const char * text, ... )
 {
-    va_list      args;
-    const char * levelString;
+    va_list args;
 
     // Skip logging
     if( logType < logLevel ) return;
@@ -95,20 +355,35 @@ TraceLog( i32 logType, const char * text, ... )
             return;
         }
 
-    // Default logging behavior - determine log level string
-    switch( logType )
+#if defined( TRACELOG_ASYNC_SUPPORTED )
+    // Asynchronous path - falls through to the synchronous writer if the record could not be queued
+    if( ATOMIC_LOAD( &logQueue.enabled ) )
         {
-            case LOG_TRACE:   levelString = "TRACE"; break;
-            case LOG_DEBUG:   levelString = "DEBUG"; break;
-            case LOG_INFO:    levelString = "INFO"; break;
-            case LOG_WARNING: levelString = "WARNING"; break;
-            case LOG_ERROR:   levelString = "ERROR"; break;
-            case LOG_FATAL:   levelString = "FATAL"; break;
-            default:          levelString = "UNKNOWN"; break;
+            va_list copy;
+            bool    queued;
+
+            va_copy( copy, args );
+            queued = EnqueueTraceLog( logType, text, copy );
+            va_end( copy );
+
+            if( queued )
+                {
+                    va_end( args );
+                    if( logType == LOG_FATAL )
+                        {
+                            FlushTraceLog();
+                            abort();
+                        }
+                    return;
+                }
         }
 
+    // Ring full, or async logging just switched off: the records still queued go first
+    if( ATOMIC_LOAD( &logQueue.claimed ) != ATOMIC_LOAD( &logQueue.written ) ) DrainLogQueueAll();
+#endif
+
     // Print log message
-    fprintf( stderr, "[%s] ", levelString );
+    fprintf( stderr, "[%s] ", GetLogLevelString( logType ) );
     vfprintf( stderr, text, args );
     fprintf( stderr, "\n" );
 
@@ -118,6 +393,90 @@ TraceLog( i32 logType, const char * text, ... )
     if( logType == LOG_FATAL ) abort();
 }
 
+// Switch between the synchronous and the background-writer logging paths
+bool
+SetTraceLogAsync( bool enabled )
+{
+#if defined( TRACELOG_ASYNC_SUPPORTED )
+    if( enabled == ATOMIC_LOAD( &logQueue.enabled ) ) return enabled;
+
+    if( enabled )
+        {
+            // Once only: records left over from a previous session are still in the ring
+            if( !logQueue.ready )
+                {
+                    for( unsigned int i = 0; i < TRACELOG_RING_SIZE; ++i ) logQueue.ring[i].sequence = i;
+                    logQueue.ready = true;
+                }
+
+            ATOMIC_STORE( &logQueue.running, true );
+            if( 0 != THREAD_CREATE( logQueue.writer, TraceLogWriter, NULL ) )
+                {
+                    ATOMIC_STORE( &logQueue.running, false );
+                    LOG( LOG_WARNING, "TRACELOG: Failed to start writer thread, staying synchronous" );
+                    return false;
+                }
+
+            ATOMIC_STORE( &logQueue.enabled, true );
+            return true;
+        }
+
+    // New records go straight to stderr; the writer drains the backlog and exits
+    ATOMIC_STORE( &logQueue.enabled, false );
+    ATOMIC_STORE( &logQueue.running, false );
+    ATOMIC_FENCE(); // Producers still in flight either see this or have their record drained below
+    WakeTraceLogWriter();
+    THREAD_JOIN( logQueue.writer );
+
+    DrainLogQueueAll();
+
+    return false;
+#else
+    UNUSED( enabled );
+    return false;
+#endif
+}
+
+// Block until every record queued before the call has been written (bounded wait)
+void
+FlushTraceLog( void )
+{
+#if defined( TRACELOG_ASYNC_SUPPORTED )
+    unsigned int target;
+
+    if( !ATOMIC_LOAD( &logQueue.running ) ) return;
+
+    target = ATOMIC_LOAD( &logQueue.claimed );
+    for( int ms = 0; ms < TRACELOG_FLUSH_TIMEOUT_MS; ++ms )
+        {
+            if( (int)( ATOMIC_LOAD( &logQueue.written ) - target ) >= 0 ) break;
+            SleepMilliseconds( TRACELOG_POLL_MS );
+        }
+#endif
+}
+
+// Emit the `count`-th occurrence of a rate-limited message, annotating the suppression state
+void
+TraceLogLimited( i32 logType, u32 count, const char * text, ... )
+{
+    va_list args;
+    char    message[MAX_TRACELOG_MSG_LENGTH];
+
+    // Skip logging before paying for the formatting
+    if( logType < logLevel ) return;
+
+    va_start( args, text );
+    vsnprintf( message, sizeof( message ), text, args );
+    va_end( args );
+
+    if( count < LOG_LIMIT_BURST )
+        TraceLog( logType, "%s", message );
+    else if( count == LOG_LIMIT_BURST )
+        TraceLog( logType, "%s (further occurrences suppressed)", message );
+    else
+        TraceLog( logType, "%s (suppressed %u times, %u total)", message, LOG_LIMIT_PERIOD - 1, count );
+}
+
 u8 *
 LoadFileData( const char * filename, size_t * outBytesRead )
 {
@@ -173,6 +532,147 @@ LoadFileData( const char * filename, size_t * outBytesRead )
     return buffer;
 }
 
+// Map a whole file read-only; returns NULL when mapping is unsupported or fails, so callers can fall back
+// NOTE: Instances mapping the same file share its page-cache pages; release with UnmapFileData()
+u8 *
+MapFileData( const char * filename, size_t * outSize )
+{
+    *outSize = 0;
+
+#if defined( PLATFORM_POSIX )
+    struct stat st;
+    void *      data;
+    int         fd;
+
+    if( !IS_STR_VALID( filename ) || strlen( filename ) > MAX_FILEPATH_LENGTH )
+        {
+            LOG( LOG_ERROR, "FILEIO: Invalid filename provided" );
+            return NULL;
+        }
+
+    fd = open( filename, O_RDONLY );
+    if( fd < 0 )
+        {
+            LOG( LOG_WARNING, "FILEIO: [%s] Failed to open file for mapping", filename );
+            return NULL;
+        }
+
+    if( 0 != fstat( fd, &st ) || !S_ISREG( st.st_mode ) || st.st_size <= 0 )
+        {
+            close( fd );
+            return NULL;
+        }
+
+    data = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd ); // The mapping keeps its own reference to the file
+    if( MAP_FAILED == data )
+        {
+            LOG( LOG_WARNING, "FILEIO: [%s] Failed to map file", filename );
+            return NULL;
+        }
+
+    // Start read-ahead without waiting for it
+    posix_madvise( data, (size_t)st.st_size, POSIX_MADV_WILLNEED );
+
+    *outSize = (size_t)st.st_size;
+    LOG( LOG_INFO, "FILEIO: [%s] File mapped successfully (%zu bytes)", filename, *outSize );
+    return (u8 *)data;
+#else
+    UNUSED( filename );
+    return NULL;
+#endif
+}
+
+// Release a mapping obtained from MapFileData()
+void
+UnmapFileData( u8 * data, size_t size )
+{
+#if defined( PLATFORM_POSIX )
+    if( NULL != data && 0 != size ) munmap( data, size );
+#else
+    UNUSED( data );
+    UNUSED( size );
+#endif
+}
+
+// Map `size` bytes of a file for reading and writing, creating or extending it as needed
+// NOTE: Stores land in the page cache and reach the file on SyncMappedFile() or unmapping
+// NOTE: A non-NULL, page-aligned `address` places the mapping there, replacing what was mapped before
+u8 *
+MapFileShared( const char * filename, size_t size, u8 * address )
+{
+#if defined( PLATFORM_POSIX )
+    struct stat st;
+    void *      data;
+    int         fd;
+
+    if( !IS_STR_VALID( filename ) || strlen( filename ) > MAX_FILEPATH_LENGTH || 0 == size )
+        {
+            LOG( LOG_ERROR, "FILEIO: Invalid shared mapping request" );
+            return NULL;
+        }
+
+    fd = open( filename, O_RDWR | O_CREAT, 0644 );
+    if( fd < 0 )
+        {
+            LOG( LOG_WARNING, "FILEIO: [%s] Failed to open file for shared mapping", filename );
+            return NULL;
+        }
+
+    // Grow short files (new saves are zero-filled); longer ones keep their trailing data
+    if( 0 != fstat( fd, &st ) || ( (size_t)st.st_size < size && 0 != ftruncate( fd, (off_t)size ) ) )
+        {
+            LOG( LOG_WARNING, "FILEIO: [%s] Failed to size file for shared mapping", filename );
+            close( fd );
+            return NULL;
+        }
+
+    data = mmap( address, size, PROT_READ | PROT_WRITE, MAP_SHARED | ( ( NULL != address ) ? MAP_FIXED : 0 ), fd, 0 );
+    close( fd );
+    if( MAP_FAILED == data )
+        {
+            LOG( LOG_WARNING, "FILEIO: [%s] Failed to map file", filename );
+            return NULL;
+        }
+
+    LOG( LOG_INFO, "FILEIO: [%s] File mapped for writing (%zu bytes)", filename, size );
+    return (u8 *)data;
+#else
+    UNUSED( filename );
+    UNUSED( size );
+    UNUSED( address );
+    return NULL;
+#endif
+}
+
+// Write back the dirty pages of a shared mapping; `wait` blocks until they reach storage
+bool
+SyncMappedFile( u8 * data, size_t size, bool wait )
+{
+#if defined( PLATFORM_POSIX )
+    if( NULL == data || 0 == size ) return false;
+    return 0 == msync( data, size, ( wait ) ? MS_SYNC : MS_ASYNC );
+#else
+    UNUSED( data );
+    UNUSED( size );
+    UNUSED( wait );
+    return false;
+#endif
+}
+
+void
+SleepMilliseconds( u32 ms )
+{
+#if defined( PLATFORM_POSIX )
+    struct timespec ts = { (time_t)( ms / 1000 ), (long)( ms % 1000 ) * 1000000L };
+
+    // Resume after signals until the full delay elapsed
+    while( 0 != nanosleep( &ts, &ts ) && EINTR == errno );
+#else
+    Sleep( ms );
+#endif
+}
+
 bool
 SaveFileData( const char * filename, const u8 * data, size_t dataSize )
 {
@@ -0,0 +1,269 @@
+/****************************** CameCore *********************************
+ *
+ * Module: Warm Start
+ *
+ * On-disk cache of the machine state at a fixed checkpoint, so sessions skip the boot logos
+ * and title screens they would otherwise emulate every time.
+ *
+ * Key Features:
+ * - Checkpoint: a frame count after power on, plus the input script played up to it
+ * - Entries keyed by ROM content hash, battery RAM hash, checkpoint, script hash and core version (one file each)
+ * - Hits map the entry and load the raw state in place; misses emulate, then store the entry
+ * - Loads keep the cartridge's battery RAM and clock: the player's save is never overwritten by an entry
+ * - Entries from another core version or of another shape are ignored and rebuilt
+ * - Entries are written next to their destination and renamed over it (readers never see a torn file)
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *      wrote the original software. If you use this software in a product, an acknowledgment
+ *      in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#include "camecore/camecore.h"
+#include "camecore/machine.h"
+#include "camecore/utils.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( _WIN32 ) || defined( _WIN64 )
+#    include <direct.h>
+#    define MAKE_DIRECTORY( path ) _mkdir( path )
+#else
+#    include <sys/stat.h>
+#    define MAKE_DIRECTORY( path ) mkdir( ( path ), 0755 )
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Defines and Macros
+//----------------------------------------------------------------------------------------------------------------------
+#define WARM_MAGIC          0x53574343U /**< "CCWS" */
+#define WARM_VERSION_LENGTH 16          /**< Core version string, zero padded */
+#define WARM_PATH_LENGTH    4096        /**< Longest entry path */
+
+//----------------------------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------------------------------------------
+// Everything a cached state depends on; hashed into the entry name
+typedef struct WarmKey
+{
+    RomHash rom;                           // ROM content
+    u64     script;                        // Input script played up to the checkpoint
+    u64     save;                          // Battery RAM at power on: games read their save while booting
+    u32     frames;                        // Checkpoint
+    u32     reserved;                      // Zero
+    char    version[WARM_VERSION_LENGTH];  // Core version: emulation changes invalidate every entry
+} WarmKey;
+
+// Entry file header; the raw save state follows
+typedef struct WarmHeader
+{
+    u32     magic;
+    u32     frames;
+    RomHash key;                           // Hash of the WarmKey, also the entry name
+    char    version[WARM_VERSION_LENGTH];
+    u64     state_size;
+} WarmHeader;
+
+STATIC_ASSERT( 0 == sizeof( WarmHeader ) % 8, "Cached states must stay 8-byte aligned" );
+
+typedef struct WarmStartContext
+{
+    bool enabled;
+    u32  frames;
+    u64  script;
+    char directory[WARM_PATH_LENGTH];
+} WarmStartContext;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------------------------------------------
+static WarmStartContext warm_ctx = { 0 };
+
+extern THREAD_LOCAL Machine * machine_ctx;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Declarations
+//----------------------------------------------------------------------------------------------------------------------
+extern u64     ComputeHash64( const void * data, size_t size, u64 seed );
+extern RomHash ComputeHash128( const void * data, size_t size, u64 * outByteSum );
+extern size_t  GetCartridgeRAMSize( void );
+extern bool    LoadStateKeepingSave( const u8 * data, size_t size );
+
+void ApplyWarmStart( void );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+static void
+GetCoreVersion( char * version )
+{
+    memset( version, 0, WARM_VERSION_LENGTH );
+    snprintf( version, WARM_VERSION_LENGTH, "%s", CAMECORE_VERSION );
+}
+
+// Hash the checkpoint of the loaded ROM into the entry key
+static RomHash
+GetWarmKey( void )
+{
+    WarmKey key;
+
+    memset( &key, 0, sizeof( key ) );
+    key.rom    = GetCartridgeHash();
+    key.script = warm_ctx.script;
+    key.save   = ( 0 != GetCartridgeRAMSize() ) ? ComputeHash64( machine_ctx->cart_ram, GetCartridgeRAMSize(), 0 ) : 0;
+    key.frames = warm_ctx.frames;
+    GetCoreVersion( key.version );
+
+    return ComputeHash128( &key, sizeof( key ), NULL );
+}
+
+// Check an entry image and load the state it holds
+static bool
+LoadWarmEntry( const u8 * data, size_t size, const RomHash * key )
+{
+    const WarmHeader * const header = (const WarmHeader *)data;
+    char                     version[WARM_VERSION_LENGTH];
+
+    GetCoreVersion( version );
+
+    if( size < sizeof( WarmHeader ) || WARM_MAGIC != header->magic ) return false;
+    if( header->key.lo != key->lo || header->key.hi != key->hi || header->frames != warm_ctx.frames ) return false;
+    if( 0 != memcmp( header->version, version, WARM_VERSION_LENGTH ) ) return false;
+    if( header->state_size != size - sizeof( WarmHeader ) ) return false;
+
+    return LoadStateKeepingSave( data + sizeof( WarmHeader ), (size_t)header->state_size );
+}
+
+// Load the entry at `path`, mapped rather than read where the platform allows it
+static bool
+LoadWarmState( const char * path, const RomHash * key )
+{
+    size_t size;
+    bool   loaded;
+    u8 *   data = MapFileData( path, &size );
+
+    if( NULL != data )
+        {
+            loaded = LoadWarmEntry( data, size, key );
+            UnmapFileData( data, size );
+            return loaded;
+        }
+
+    data = LoadFileData( path, &size );
+    if( NULL == data ) return false;
+
+    loaded = LoadWarmEntry( data, size, key );
+    free( data );
+    return loaded;
+}
+
+// Write the machine's state as the entry at `path`, through a temporary file renamed over it
+static bool
+StoreWarmState( const char * path, const RomHash * key )
+{
+    const size_t capacity = GetStateSize();
+    u8 * const   data     = (u8 *)malloc( sizeof( WarmHeader ) + capacity );
+    WarmHeader   header;
+    char         tempPath[WARM_PATH_LENGTH];
+    size_t       size;
+    bool         result;
+
+    if( NULL == data ) return false;
+
+    memset( &header, 0, sizeof( header ) );
+    size = SaveStateToMemory( data + sizeof( WarmHeader ), capacity );
+
+    header.magic      = WARM_MAGIC;
+    header.frames     = warm_ctx.frames;
+    header.key        = *key;
+    header.state_size = size;
+    GetCoreVersion( header.version );
+    memcpy( data, &header, sizeof( header ) );
+
+    result = ( 0 != size ) && (int)sizeof( tempPath ) > snprintf( tempPath, sizeof( tempPath ), "%s.tmp", path );
+    result = result && SaveFileData( tempPath, data, sizeof( WarmHeader ) + size ) && 0 == rename( tempPath, path );
+
+    free( data );
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Bring this thread's machine to the checkpoint: load it from the cache, or emulate up to it and cache it
+// NOTE: Called by InitEmulator() on the power-on machine, before the CPU thread starts
+void
+ApplyWarmStart( void )
+{
+    RomHash key;
+    char    path[WARM_PATH_LENGTH];
+
+    if( !warm_ctx.enabled || NULL == machine_ctx ) return;
+
+    key = GetWarmKey();
+    if( (int)sizeof( path ) <= snprintf( path, sizeof( path ), "%s/%016llX%016llX.ccws", warm_ctx.directory,
+                                         (unsigned long long)key.hi, (unsigned long long)key.lo ) )
+        {
+            LOG( LOG_WARNING, "WARMSTART: Cache path too long" );
+            return;
+        }
+
+    if( LoadWarmState( path, &key ) )
+        {
+            LOG( LOG_INFO, "WARMSTART: [%s] Resumed at frame %u", path, warm_ctx.frames );
+            return;
+        }
+
+    LOG( LOG_INFO, "WARMSTART: Emulating %u frames to the checkpoint", warm_ctx.frames );
+    if( !RunInstance( machine_ctx, warm_ctx.frames ) )
+        {
+            LOG( LOG_WARNING, "WARMSTART: CPU stopped before the checkpoint; nothing cached" );
+            return;
+        }
+
+    if( !StoreWarmState( path, &key ) ) LOG( LOG_WARNING, "WARMSTART: [%s] Failed to store the entry", path );
+}
+
+// Start the emulation `frames` frames after power on (0: off), caching that state in `cacheDirectory`
+// NOTE: `inputScript` is the input played up to the checkpoint; only its hash is kept, as part of the key
+bool
+SetWarmStart( const char * cacheDirectory, u32 frames, const u8 * inputScript, size_t scriptSize )
+{
+    warm_ctx.enabled = false;
+
+    if( 0 == frames ) return true;
+    if( !IS_STR_VALID( cacheDirectory ) || strlen( cacheDirectory ) >= sizeof( warm_ctx.directory ) ) return false;
+
+    if( 0 != MAKE_DIRECTORY( cacheDirectory ) && EEXIST != errno )
+        {
+            LOG( LOG_WARNING, "WARMSTART: [%s] Failed to create the cache directory", cacheDirectory );
+            return false;
+        }
+
+    snprintf( warm_ctx.directory, sizeof( warm_ctx.directory ), "%s", cacheDirectory );
+    warm_ctx.frames  = frames;
+    warm_ctx.script  = ( NULL != inputScript ) ? ComputeHash64( inputScript, scriptSize, 0 ) : 0;
+    warm_ctx.enabled = true;
+
+    return true;
+}
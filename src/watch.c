@@ -0,0 +1,260 @@
+/****************************** CameCore *********************************
+ *
+ * Module: Watchpoints
+ *
+ * Provides read/write/execute watchpoints over the 16-bit address space without
+ * adding any check to the bus fast path.
+ *
+ * Key Features:
+ * - Pages holding a watched byte are swapped to "trapping" bus pages
+ * - Unwatched pages keep their direct host pointers (zero cost when unused)
+ * - Byte-granular hit bitmaps, one per access kind
+ * - User callback invoked on every matching access
+ * - Edits from any thread are queued; the emulation thread swaps the traps between two instructions
+ * - Each machine keeps its own copy, bitmaps and traps (instances pick up edits when they next run)
+ *
+ *                               LICENSE
+ * ------------------------------------------------------------------------
+ * Copyright (c) 2025 SOHNE, Leandro Peres (@zschzen)
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the use
+ * of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including
+ * commercial applications, and to alter it and redistribute it freely, subject to the
+ * following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that
+ *      you wrote the original software. If you use this software in a product, an
+ *      acknowledgment in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *      as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ *
+ *************************************************************************/
+
+#include "camecore/camecore.h"
+#include "camecore/machine.h"
+#include "camecore/utils.h"
+
+#include <string.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Defines and Macros
+//----------------------------------------------------------------------------------------------------------------------
+#define WATCH_POLL_MS       1 /**< Editor wake-up granularity while the edit is pending */
+
+#define BITMAP_TEST( m, a ) ( ( m )[( a ) >> 3] & BIT( ( a ) & 7 ) )
+#define BITMAP_SET( m, a )  ( ( m )[( a ) >> 3] |= (u8)BIT( ( a ) & 7 ) )
+
+//----------------------------------------------------------------------------------------------------------------------
+// Structs Definition
+//----------------------------------------------------------------------------------------------------------------------
+// Shared list, edited by any thread; each machine traps its own copy (see WatchState)
+typedef struct WatchContext
+{
+    Watchpoint points[MAX_WATCHPOINTS];
+    long       lock;   /**< Guards `points` and `serial` */
+    u32        serial; /**< Bumped on every edit */
+} WatchContext;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------------------------------------------
+static WatchContext watch_ctx = { 0 };
+
+extern THREAD_LOCAL Machine * machine_ctx;
+extern u64                    service_deadline; // Cleared to have the emulation thread serve pending edits
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Declarations
+//----------------------------------------------------------------------------------------------------------------------
+extern void SetBusPageTrap( u8 page, u8 kinds );
+extern bool IsMachineOnOtherThread( void );
+
+void CheckWatchpoint( u16 addr, u8 value, WatchKind kind );
+void UpdateWatchpoints( void );
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Internal Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Get the bitmap slot of a single access kind
+static INLINE int
+GetKindIndex( WatchKind kind )
+{
+    switch( kind )
+        {
+            case WATCH_READ:    return 0;
+            case WATCH_WRITE:   return 1;
+            case WATCH_EXECUTE: return 2;
+            default:            return -1;
+        }
+}
+
+// Rebuild the machine's hit bitmaps and swap trapping pages in/out of its bus page table
+static void
+RebuildWatchpoints( void )
+{
+    WatchState * const watch                     = &machine_ctx->watch;
+    u8                 page_trap[BUS_PAGE_COUNT] = { 0 };
+
+    memset( watch->bitmap, 0, sizeof( watch->bitmap ) );
+
+    for( int i = 0; i < MAX_WATCHPOINTS; ++i )
+        {
+            const Watchpoint * wp = &watch->points[i];
+            if( NULL == wp->callback ) continue;
+
+            for( u32 addr = wp->start; addr < wp->end; ++addr )
+                {
+                    for( int k = 0; k < WATCH_KIND_COUNT; ++k )
+                        {
+                            if( wp->kind & BIT( k ) ) BITMAP_SET( watch->bitmap[k], addr );
+                        }
+                    page_trap[addr >> BUS_PAGE_SHIFT] |= (u8)wp->kind;
+                }
+        }
+
+    // Pages whose trapped kinds did not change are left alone by the bus
+    for( u32 page = 0; page < BUS_PAGE_COUNT; ++page ) SetBusPageTrap( (u8)page, page_trap[page] );
+}
+
+// Wait until the calling thread's machine runs with the watchpoint list of edit `serial`
+// NOTE: Unless another thread (the CPU thread) runs that machine, the caller owns it and swaps the traps itself
+static void
+CommitWatchpoints( u32 serial )
+{
+    if( NULL == machine_ctx ) return; // Machines pick the list up when they start running
+
+    while( (i32)( ATOMIC_LOAD( &machine_ctx->watch.serial ) - serial ) < 0 )
+        {
+            if( !IsMachineOnOtherThread() )
+                {
+                    UpdateWatchpoints();
+                    return;
+                }
+
+            ATOMIC_STORE( &service_deadline, 0 );
+            THREAD_SLEEP( WATCH_POLL_MS );
+        }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Module Functions Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Trap handler: invoked by the bus for accesses on trapping pages
+void
+CheckWatchpoint( u16 addr, u8 value, WatchKind kind )
+{
+    const int index = GetKindIndex( kind );
+
+    // Same page, but not a watched byte
+    if( index < 0 || !BITMAP_TEST( machine_ctx->watch.bitmap[index], addr ) ) return;
+
+    for( int i = 0; i < MAX_WATCHPOINTS; ++i )
+        {
+            const Watchpoint * wp = &machine_ctx->watch.points[i];
+
+            if( NULL != wp->callback && ( wp->kind & kind ) && BETWEEN( addr, wp->start, wp->end - 1 ) )
+                {
+                    wp->callback( addr, value, kind );
+                }
+        }
+}
+
+// Swap the latest watchpoint list and its traps into this thread's machine
+// NOTE: Called by the thread running the machine: between two instructions, while paused, or before a run
+void
+UpdateWatchpoints( void )
+{
+    WatchState * watch;
+    u32          serial;
+
+    if( NULL == machine_ctx ) return;
+
+    watch = &machine_ctx->watch;
+    if( ATOMIC_LOAD( &watch_ctx.serial ) == watch->serial ) return;
+
+    SPIN_LOCK( watch_ctx.lock );
+    memcpy( watch->points, watch_ctx.points, sizeof( watch->points ) );
+    serial = watch_ctx.serial;
+    SPIN_UNLOCK( watch_ctx.lock );
+
+    RebuildWatchpoints();
+    ATOMIC_STORE( &watch->serial, serial );
+}
+
+// Watch `len` bytes from `addr` for the given access kinds
+// NOTE: Returns the watchpoint id, or -1 on failure
+i32
+AddWatchpoint( u16 addr, u16 len, WatchKind kind, WatchpointCallback callback )
+{
+    u32 serial;
+
+    if( NULL == callback || 0 == len || 0 == ( kind & ( WATCH_READ | WATCH_WRITE | WATCH_EXECUTE ) ) )
+        {
+            LOG( LOG_WARNING, "WATCH: Invalid watchpoint %04X+%X (kind %d)", addr, len, kind );
+            return -1;
+        }
+
+    SPIN_LOCK( watch_ctx.lock );
+    for( i32 i = 0; i < MAX_WATCHPOINTS; ++i )
+        {
+            Watchpoint * wp = &watch_ctx.points[i];
+            if( NULL != wp->callback ) continue;
+
+            wp->callback = callback;
+            wp->start    = addr;
+            wp->end      = ( 0x10000U < (u32)addr + len ) ? 0x10000U : (u32)addr + len;
+            wp->kind     = kind;
+
+            serial = ATOMIC_INC( &watch_ctx.serial );
+            SPIN_UNLOCK( watch_ctx.lock );
+
+            CommitWatchpoints( serial );
+            return i;
+        }
+    SPIN_UNLOCK( watch_ctx.lock );
+
+    LOG( LOG_WARNING, "WATCH: No free watchpoint slot (max %d)", MAX_WATCHPOINTS );
+    return -1;
+}
+
+// Remove a watchpoint by id
+bool
+RemoveWatchpoint( i32 id )
+{
+    u32 serial;
+
+    if( !INDEX_VALID( id, watch_ctx.points ) ) return false;
+
+    SPIN_LOCK( watch_ctx.lock );
+    if( NULL == watch_ctx.points[id].callback )
+        {
+            SPIN_UNLOCK( watch_ctx.lock );
+            return false;
+        }
+    memset( &watch_ctx.points[id], 0, sizeof( watch_ctx.points[id] ) );
+    serial = ATOMIC_INC( &watch_ctx.serial );
+    SPIN_UNLOCK( watch_ctx.lock );
+
+    CommitWatchpoints( serial );
+    return true;
+}
+
+// Remove every watchpoint, restoring the direct bus path on all pages
+void
+ClearWatchpoints( void )
+{
+    u32 serial;
+
+    SPIN_LOCK( watch_ctx.lock );
+    memset( watch_ctx.points, 0, sizeof( watch_ctx.points ) );
+    serial = ATOMIC_INC( &watch_ctx.serial );
+    SPIN_UNLOCK( watch_ctx.lock );
+
+    CommitWatchpoints( serial );
+}
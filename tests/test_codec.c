@@ -0,0 +1,294 @@
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "camecore/camecore.h"
+
+#define BLOCK_SIZE 0x10000 // Raw bytes per codec block
+#define FRAME_HEAD 4       // Magic
+#define BLOCK_HEAD 8       // Raw size + packed size
+#define STORED     0x80000000U
+
+typedef struct Buffer {
+    u8 *data;
+    size_t size;
+    size_t capacity;
+} Buffer;
+
+static u8 *make_random(size_t size, u64 seed) {
+    u8 *data = malloc(size ? size : 1);
+
+    for (size_t i = 0; i < size; ++i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        data[i] = (u8)seed;
+    }
+    return data;
+}
+
+// Text-like data: a 1000-byte pattern with sparse edits, so matches reach across block boundaries
+static u8 *make_pattern(size_t size) {
+    u8 *data = malloc(size ? size : 1);
+
+    for (size_t i = 0; i < size; ++i) data[i] = (u8)("CameCore codec"[(i % 1000) % 14] + (i % 1000) / 100);
+    for (size_t i = 997; i < size; i += 4099) data[i] ^= 0x5A;
+    return data;
+}
+
+static u32 read32(const u8 *p) {
+    u32 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void write32(u8 *p, u32 v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static size_t compress(const u8 *data, size_t size, u8 **frame, u32 threads) {
+    const size_t bound = GetCompressBound(size);
+    size_t packed;
+
+    *frame = malloc(bound);
+    packed = CompressData(data, size, *frame, bound, threads);
+    ck_assert_uint_ne(packed, 0);
+    ck_assert_uint_le(packed, bound);
+    return packed;
+}
+
+static void assert_round_trip(const u8 *data, size_t size, u32 threads) {
+    u8 *frame;
+    const size_t packed = compress(data, size, &frame, threads);
+    u8 *out = malloc(size ? size : 1);
+
+    ck_assert_uint_eq(GetDecompressedSize(frame, packed), size);
+    if (0 != size) {
+        ck_assert_uint_eq(DecompressData(frame, packed, out, size, threads), size);
+        ck_assert_msg(0 == memcmp(out, data, size), "round trip differs at size %zu", size);
+
+        // One byte short of room is refused, not overrun
+        ck_assert_uint_eq(DecompressData(frame, packed, out, size - 1, threads), 0);
+    }
+
+    free(out);
+    free(frame);
+}
+
+static bool append(const u8 *data, size_t size, void *user) {
+    Buffer *buffer = user;
+
+    if (buffer->size + size > buffer->capacity) return false;
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+    return true;
+}
+
+// Push `data` through a stream in `chunk`-byte writes
+static bool stream(bool compress, const u8 *data, size_t size, size_t chunk, Buffer *out) {
+    CodecStream *s = OpenCodecStream(compress, append, out);
+    bool ok = NULL != s;
+
+    for (size_t pos = 0; ok && pos < size; pos += chunk) {
+        ok = WriteCodecStream(s, data + pos, (size - pos < chunk) ? size - pos : chunk);
+    }
+    return CloseCodecStream(s) && ok;
+}
+
+START_TEST(test_zero_runs)
+{
+    const size_t size = 17 * BLOCK_SIZE + 5;
+    u8 *data = calloc(1, size);
+    u8 *frame;
+
+    ck_assert_uint_lt(compress(data, size, &frame, 1), size / 100);
+    free(frame);
+
+    assert_round_trip(data, size, 1);
+    assert_round_trip(data, size, 0);
+
+    // Short zero runs between literals
+    for (size_t i = 0; i < size; i += 37) data[i] = (u8)i;
+    assert_round_trip(data, size, 1);
+    free(data);
+}
+END_TEST
+
+START_TEST(test_incompressible)
+{
+    const size_t size = 3 * BLOCK_SIZE + 1234;
+    u8 *data = make_random(size, 0x243F6A8885A308D3ULL);
+    u8 *frame;
+
+    // Every block falls back to stored, which is exactly the bound
+    ck_assert_uint_eq(compress(data, size, &frame, 1), GetCompressBound(size));
+    ck_assert(read32(frame + FRAME_HEAD + 4) & STORED);
+    free(frame);
+
+    assert_round_trip(data, size, 1);
+    assert_round_trip(data, size, 4);
+    free(data);
+}
+END_TEST
+
+START_TEST(test_block_boundaries)
+{
+    static const size_t SIZES[] = {
+        0, 1, 12, 13, 17, BLOCK_SIZE - 1, BLOCK_SIZE, BLOCK_SIZE + 1, 2 * BLOCK_SIZE - 1, 2 * BLOCK_SIZE + 7,
+        16 * BLOCK_SIZE, 17 * BLOCK_SIZE + 3,
+    };
+    u8 *data = make_pattern(17 * BLOCK_SIZE + 3);
+
+    for (size_t i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); ++i) {
+        assert_round_trip(data, SIZES[i], 1);
+        assert_round_trip(data, SIZES[i], 4);
+    }
+    free(data);
+}
+END_TEST
+
+START_TEST(test_threads_match)
+{
+    const size_t size = 40 * BLOCK_SIZE + 99;
+    u8 *data = make_pattern(size);
+    u8 *single, *multi;
+    const size_t singleSize = compress(data, size, &single, 1);
+    const size_t multiSize = compress(data, size, &multi, 0);
+
+    // Blocks are independent: the frame does not depend on the thread count
+    ck_assert_uint_eq(singleSize, multiSize);
+    ck_assert(0 == memcmp(single, multi, singleSize));
+
+    free(single);
+    free(multi);
+    free(data);
+}
+END_TEST
+
+START_TEST(test_stream_round_trip)
+{
+    const size_t size = 2 * BLOCK_SIZE + 4321;
+    u8 *data = make_pattern(size);
+    u8 *frame;
+    const size_t packed = compress(data, size, &frame, 1);
+    Buffer encoded = { malloc(GetCompressBound(size)), 0, GetCompressBound(size) };
+    Buffer decoded = { malloc(size), 0, size };
+
+    // Chunks that never line up with a block
+    ck_assert(stream(true, data, size, 4097, &encoded));
+    ck_assert_uint_eq(encoded.size, packed);
+    ck_assert(0 == memcmp(encoded.data, frame, packed));
+
+    ck_assert(stream(false, encoded.data, encoded.size, 333, &decoded));
+    ck_assert_uint_eq(decoded.size, size);
+    ck_assert(0 == memcmp(decoded.data, data, size));
+
+    free(encoded.data);
+    free(decoded.data);
+    free(frame);
+    free(data);
+}
+END_TEST
+
+START_TEST(test_truncated_frames)
+{
+    const size_t size = 2 * BLOCK_SIZE + 500;
+    u8 *data = make_pattern(size);
+    u8 *out = malloc(size);
+    u8 *frame;
+    const size_t packed = compress(data, size, &frame, 1);
+
+    // Every prefix lacks the end marker
+    for (size_t cut = 0; cut < packed; ++cut) {
+        ck_assert_uint_eq(GetDecompressedSize(frame, cut), 0);
+        ck_assert_uint_eq(DecompressData(frame, cut, out, size, 1), 0);
+    }
+
+    // Streams notice on close
+    for (size_t cut = 0; cut < packed; cut += 97) {
+        Buffer decoded = { out, 0, size };
+        ck_assert(!stream(false, frame, cut, 64, &decoded));
+    }
+
+    free(frame);
+    free(out);
+    free(data);
+}
+END_TEST
+
+// Corrupt a copy of `frame` at `offset` with `value`; it must be rejected by both decoders
+static void assert_rejected(const u8 *frame, size_t packed, size_t offset, u32 value, size_t size) {
+    u8 *copy = malloc(packed);
+    u8 *out = malloc(size);
+    Buffer decoded = { out, 0, size };
+
+    memcpy(copy, frame, packed);
+    write32(copy + offset, value);
+
+    ck_assert_msg(0 == DecompressData(copy, packed, out, size, 1), "accepted 0x%08X at %zu", value, offset);
+    ck_assert_msg(!stream(false, copy, packed, 1000, &decoded), "stream accepted 0x%08X at %zu", value, offset);
+
+    free(out);
+    free(copy);
+}
+
+START_TEST(test_corrupted_frames)
+{
+    const size_t size = 2 * BLOCK_SIZE;
+    u8 *data = calloc(1, size);
+    u8 *frame;
+    const size_t packed = compress(data, size, &frame, 1);
+    const size_t block = FRAME_HEAD;
+    const size_t payload = block + BLOCK_HEAD;
+    const u32 packedSize = read32(frame + block + 4);
+    u32 token;
+
+    ck_assert(0 == (packedSize & STORED));
+
+    // Framing
+    assert_rejected(frame, packed, 0, 0x12345678, size);                            // Magic
+    assert_rejected(frame, packed, block, BLOCK_SIZE + 1, size);                    // Raw size past a block
+    assert_rejected(frame, packed, block + 4, (u32)packed, size);                   // Payload past the frame
+    assert_rejected(frame, packed, block + 4, packedSize | STORED, size);           // Stored, but not raw sized
+    assert_rejected(frame, packed, block + 4, BLOCK_SIZE + 1, size);                // Payload past a block
+
+    // Sizes that disagree with the payload
+    assert_rejected(frame, packed, block, BLOCK_SIZE - 1, size);                    // Output overrun
+    assert_rejected(frame, packed, block + 4, packedSize - 1, size);                // Payload cut short
+
+    // A zero run starts with one literal, then a match at offset 1: point it before the block, then at 0
+    token = read32(frame + payload);
+    ck_assert_uint_eq(token & 0xF0, 0x10);
+    ck_assert_uint_eq((token >> 16) & 0xFFFF, 1);
+    assert_rejected(frame, packed, payload, (token & 0xFFFF) | (2U << 16), size);
+    assert_rejected(frame, packed, payload, token & 0xFFFF, size);
+
+    free(frame);
+    free(data);
+}
+END_TEST
+
+Suite *codec_suite(void) {
+    Suite *s = suite_create("codec");
+    TCase *tc = tcase_create("frames");
+
+    tcase_add_test(tc, test_zero_runs);
+    tcase_add_test(tc, test_incompressible);
+    tcase_add_test(tc, test_block_boundaries);
+    tcase_add_test(tc, test_threads_match);
+    tcase_add_test(tc, test_stream_round_trip);
+    tcase_add_test(tc, test_truncated_frames);
+    tcase_add_test(tc, test_corrupted_frames);
+
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = codec_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    int nf = srunner_ntests_failed(sr);
+
+    srunner_free(sr);
+    return nf == 0 ? 0 : -1;
+}
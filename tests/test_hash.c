@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+
+// Build a second, plain C copy of the hash module next to the library's (SSE2 where the target has it)
+#define HASH_PORTABLE
+#define ComputeHash64  PortableHash64
+#define ComputeHash128 PortableHash128
+#include "../src/hash.c"
+#undef ComputeHash64
+#undef ComputeHash128
+
+extern RomHash ComputeHash128(const void *data, size_t size, u64 *outByteSum);
+
+#define BUFFER_SIZE (1024 * 1024 + 77)
+
+static u8 *make_buffer(void) {
+    u8 *buffer = malloc(BUFFER_SIZE);
+    u64 state = 0x9E3779B97F4A7C15ULL;
+
+    for (size_t i = 0; i < BUFFER_SIZE; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        buffer[i] = (u8)state;
+    }
+    return buffer;
+}
+
+static void assert_same_hash(const u8 *data, size_t size) {
+    u64 sum = 0, portableSum = 0;
+    RomHash hash = ComputeHash128(data, size, &sum);
+    RomHash portable = PortableHash128(data, size, &portableSum);
+
+    ck_assert_msg(hash.lo == portable.lo && hash.hi == portable.hi, "hash differs at size %zu", size);
+    ck_assert_msg(sum == portableSum, "byte sum differs at size %zu", size);
+}
+
+START_TEST(test_small_sizes)
+{
+    u8 *buffer = make_buffer();
+
+    // Every partial stripe and block length, aligned and not
+    for (size_t size = 0; size <= 3 * 1024 + 65; ++size) {
+        assert_same_hash(buffer, size);
+        assert_same_hash(buffer + 1, size);
+    }
+    free(buffer);
+}
+END_TEST
+
+START_TEST(test_large_sizes)
+{
+    u8 *buffer = make_buffer();
+
+    assert_same_hash(buffer, BUFFER_SIZE);
+    assert_same_hash(buffer + 3, BUFFER_SIZE - 3);
+    assert_same_hash(buffer, 32 * 1024);
+    free(buffer);
+}
+END_TEST
+
+START_TEST(test_extreme_bytes)
+{
+    u8 *buffer = calloc(1, 64 * 1024);
+
+    // All zero, then all 0xFF: the accumulators and byte sums hit their edge cases
+    assert_same_hash(buffer, 64 * 1024);
+    memset(buffer, 0xFF, 64 * 1024);
+    assert_same_hash(buffer, 64 * 1024);
+    assert_same_hash(buffer, 64 * 1024 - 1);
+    free(buffer);
+}
+END_TEST
+
+START_TEST(test_null_byte_sum)
+{
+    u8 *buffer = make_buffer();
+    RomHash hash = ComputeHash128(buffer, 4096, NULL);
+    RomHash portable = PortableHash128(buffer, 4096, NULL);
+
+    ck_assert(hash.lo == portable.lo && hash.hi == portable.hi);
+    free(buffer);
+}
+END_TEST
+
+Suite *hash_suite(void) {
+    Suite *s = suite_create("hash");
+    TCase *tc = tcase_create("simd");
+
+    // The SSE2 path must give the portable path's results bit for bit
+    tcase_add_test(tc, test_small_sizes);
+    tcase_add_test(tc, test_large_sizes);
+    tcase_add_test(tc, test_extreme_bytes);
+    tcase_add_test(tc, test_null_byte_sum);
+
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = hash_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    int nf = srunner_ntests_failed(sr);
+
+    srunner_free(sr);
+    return nf == 0 ? 0 : -1;
+}
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "camecore/camecore.h"
+
+#define BANK_SIZE 0x4000 // ROM bank
+#define OPEN_BUS  0xFF
+
+// Cartridge types without a battery, so no `.sav` file is created
+#define TYPE_MBC1_RAM 0x02
+#define TYPE_MBC3_RAM 0x12
+#define TYPE_MBC5_RAM 0x1A
+
+static Machine *root;
+
+// Write a cartridge whose switchable banks start with their own number (little endian); bank 0 reads 0
+static void write_rom(const char *path, u8 type, u8 romCode, u8 ramCode) {
+    const size_t size = (size_t)0x8000 << romCode;
+    u8 *rom = calloc(1, size);
+
+    for (size_t bank = 1; bank < size / BANK_SIZE; ++bank) {
+        rom[bank * BANK_SIZE] = (u8)bank;
+        rom[bank * BANK_SIZE + 1] = (u8)(bank >> 8);
+    }
+    rom[0x100] = 0x18; // JR -2: spin at the entry point
+    rom[0x101] = 0xFE;
+    rom[0x147] = type;
+    rom[0x148] = romCode;
+    rom[0x149] = ramCode;
+
+    ck_assert(SaveFileData(path, rom, size));
+    free(rom);
+}
+
+// Load the cartridge, then run a fork of its machine on this thread; the CPU thread stays paused
+static void start(const char *path, u8 type, u8 romCode, u8 ramCode) {
+    Machine *fork;
+
+    write_rom(path, type, romCode, ramCode);
+    ck_assert(LoadCartridge((char *)path));
+
+    InitEmulator();
+    PauseEmulator();
+    root = GetCurrentInstance();
+    fork = ForkInstance(NULL);
+    ck_assert_ptr_nonnull(fork);
+    SetCurrentInstance(fork);
+}
+
+static void stop(const char *path) {
+    DestroyInstance(SetCurrentInstance(root));
+    StopEmulator();
+    UnloadCartridge();
+    remove(path);
+}
+
+static u16 bank_at(u16 window) {
+    return (u16)(ReadBus(window) | (ReadBus(window + 1) << 8));
+}
+
+START_TEST(test_mbc1)
+{
+    static const char *path = "test_mbc1.gb";
+
+    start(path, TYPE_MBC1_RAM, 0x05, 0x03); // 1 MiB (64 banks), 32 KiB RAM
+    ck_assert_uint_eq(bank_at(0x0000), 0);
+    ck_assert_uint_eq(bank_at(0x4000), 1);
+
+    // 5-bit register; 0 selects 1, including once the upper bits are masked off
+    WriteBus(0x2000, 0x05);
+    ck_assert_uint_eq(bank_at(0x4000), 5);
+    WriteBus(0x2000, 0x00);
+    ck_assert_uint_eq(bank_at(0x4000), 1);
+    WriteBus(0x2000, 0x20);
+    ck_assert_uint_eq(bank_at(0x4000), 1);
+    WriteBus(0x3FFF, 0x1F);
+    ck_assert_uint_eq(bank_at(0x4000), 0x1F);
+
+    // Upper bits extend the bank: 00/20 select 21, and banks past the image wrap
+    WriteBus(0x4000, 0x01);
+    ck_assert_uint_eq(bank_at(0x4000), 0x3F);
+    WriteBus(0x2000, 0x00);
+    ck_assert_uint_eq(bank_at(0x4000), 0x21);
+    WriteBus(0x4000, 0x03);
+    ck_assert_uint_eq(bank_at(0x4000), 0x21);
+
+    // Mode 1 also applies them to 0000-3FFF
+    ck_assert_uint_eq(bank_at(0x0000), 0);
+    WriteBus(0x6000, 0x01);
+    ck_assert_uint_eq(bank_at(0x0000), 0x20);
+    WriteBus(0x4000, 0x01);
+    ck_assert_uint_eq(bank_at(0x0000), 0x20);
+    WriteBus(0x6000, 0x00);
+    ck_assert_uint_eq(bank_at(0x0000), 0);
+
+    // RAM: any 0A low nibble enables it; only mode 1 switches its bank
+    ck_assert_uint_eq(ReadBus(0xA000), OPEN_BUS);
+    WriteBus(0x0000, 0x1A);
+    WriteBus(0xA000, 0x11);
+    WriteBus(0x6000, 0x01);
+    WriteBus(0x4000, 0x02);
+    ck_assert_uint_eq(ReadBus(0xA000), 0x00);
+    WriteBus(0xA000, 0x22);
+    WriteBus(0x6000, 0x00);
+    ck_assert_uint_eq(ReadBus(0xA000), 0x11);
+    WriteBus(0x6000, 0x01);
+    ck_assert_uint_eq(ReadBus(0xA000), 0x22);
+
+    WriteBus(0x0000, 0x00);
+    ck_assert_uint_eq(ReadBus(0xA000), OPEN_BUS);
+    WriteBus(0xA000, 0x33);
+    WriteBus(0x0000, 0x0A);
+    ck_assert_uint_eq(ReadBus(0xA000), 0x22);
+
+    stop(path);
+}
+END_TEST
+
+START_TEST(test_mbc3)
+{
+    static const char *path = "test_mbc3.gb";
+
+    start(path, TYPE_MBC3_RAM, 0x06, 0x03); // 2 MiB (128 banks), 32 KiB RAM
+
+    // 7-bit register; 0 selects 1, bank 0 stays fixed
+    WriteBus(0x2000, 0x7F);
+    ck_assert_uint_eq(bank_at(0x4000), 0x7F);
+    ck_assert_uint_eq(bank_at(0x0000), 0);
+    WriteBus(0x2000, 0x00);
+    ck_assert_uint_eq(bank_at(0x4000), 1);
+    WriteBus(0x2000, 0x80);
+    ck_assert_uint_eq(bank_at(0x4000), 1);
+    WriteBus(0x2000, 0x40);
+    ck_assert_uint_eq(bank_at(0x4000), 0x40);
+    WriteBus(0x6000, 0x01); // Clock latch: no banking mode
+    ck_assert_uint_eq(bank_at(0x0000), 0);
+
+    // Each RAM bank keeps its own bytes
+    WriteBus(0x0000, 0x0A);
+    for (u8 bank = 0; bank < 4; ++bank) {
+        WriteBus(0x4000, bank);
+        WriteBus(0xA000, (u8)(0x40 + bank));
+        WriteBus(0xBFFF, (u8)(0x80 + bank));
+    }
+    for (u8 bank = 0; bank < 4; ++bank) {
+        WriteBus(0x4000, bank);
+        ck_assert_uint_eq(ReadBus(0xA000), 0x40 + bank);
+        ck_assert_uint_eq(ReadBus(0xBFFF), 0x80 + bank);
+    }
+
+    // Clock registers select nothing without a clock
+    WriteBus(0x4000, 0x08);
+    ck_assert_uint_eq(ReadBus(0xA000), OPEN_BUS);
+    WriteBus(0x4000, 0x01);
+    ck_assert_uint_eq(ReadBus(0xA000), 0x41);
+
+    stop(path);
+}
+END_TEST
+
+START_TEST(test_mbc5)
+{
+    static const char *path = "test_mbc5.gb";
+
+    start(path, TYPE_MBC5_RAM, 0x08, 0x04); // 8 MiB (512 banks), 128 KiB RAM
+
+    // 9-bit register split over 2000-2FFF and 3000-3FFF; bank 0 can be mapped at 4000
+    WriteBus(0x2000, 0x00);
+    ck_assert_uint_eq(bank_at(0x4000), 0);
+    WriteBus(0x2FFF, 0xFF);
+    ck_assert_uint_eq(bank_at(0x4000), 0xFF);
+    WriteBus(0x3000, 0x01);
+    ck_assert_uint_eq(bank_at(0x4000), 0x1FF);
+    WriteBus(0x2000, 0x05);
+    ck_assert_uint_eq(bank_at(0x4000), 0x105);
+    WriteBus(0x3000, 0x00);
+    ck_assert_uint_eq(bank_at(0x4000), 0x05);
+    ck_assert_uint_eq(bank_at(0x0000), 0);
+
+    // Only 0A itself enables RAM
+    WriteBus(0x0000, 0x1A);
+    ck_assert_uint_eq(ReadBus(0xA000), OPEN_BUS);
+    WriteBus(0x0000, 0x0A);
+    for (u8 bank = 0; bank < 16; ++bank) {
+        WriteBus(0x4000, bank);
+        WriteBus(0xA000, (u8)(0x60 + bank));
+    }
+    for (u8 bank = 0; bank < 16; ++bank) {
+        WriteBus(0x4000, bank);
+        ck_assert_uint_eq(ReadBus(0xA000), 0x60 + bank);
+    }
+
+    stop(path);
+}
+END_TEST
+
+Suite *mbc_suite(void) {
+    Suite *s = suite_create("mbc");
+    TCase *tc = tcase_create("banks");
+
+    // Bank maps as seen through the bus
+    tcase_add_test(tc, test_mbc1);
+    tcase_add_test(tc, test_mbc3);
+    tcase_add_test(tc, test_mbc5);
+
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    SetLogLevel(LOG_WARNING); // No per-cartridge load details
+
+    Suite *s = mbc_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    int nf = srunner_ntests_failed(sr);
+
+    srunner_free(sr);
+    return nf == 0 ? 0 : -1;
+}
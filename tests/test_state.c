@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "camecore/camecore.h"
+
+#define ROM_SIZE      0x10000 // 4 banks
+#define BANK_SIZE     0x4000
+#define TYPE_MBC5_RAM 0x1A    // No battery, so no `.sav` file is created
+
+// State layout: 32-byte header (magic, version, chunk count, size, reserved, ROM hash), then tagged chunks
+#define HEADER_SIZE   32
+#define CHUNK_HEAD    8 // Tag + payload size
+#define SIZE_OFFSET   8
+#define HASH_OFFSET   16
+
+static const char *ROM_PATH = "test_state.gb";
+static const char *OTHER_ROM_PATH = "test_state_other.gb";
+static const char *STATE_PATH = "test_state.ccs";
+
+static Machine *root;
+
+// Count up at C000 forever, so every frame changes the machine
+static const u8 PROGRAM[] = {
+    0x21, 0x00, 0xC0, // LD HL, C000
+    0x34,             // INC (HL)
+    0x18, 0xFD,       // JR -3
+};
+
+static void write_rom(const char *path, u8 seed) {
+    u8 *rom = calloc(1, ROM_SIZE);
+
+    for (u32 bank = 1; bank < ROM_SIZE / BANK_SIZE; ++bank) rom[bank * BANK_SIZE] = (u8)(bank + seed);
+    rom[0x101] = 0xC3; // JP 0150
+    rom[0x102] = 0x50;
+    rom[0x103] = 0x01;
+    rom[0x147] = TYPE_MBC5_RAM;
+    rom[0x148] = 0x01; // 64 KiB
+    rom[0x149] = 0x02; // 8 KiB RAM
+    memcpy(rom + 0x150, PROGRAM, sizeof(PROGRAM));
+
+    ck_assert(SaveFileData(path, rom, ROM_SIZE));
+    free(rom);
+}
+
+// Load the cartridge, then run a fork of its machine on this thread; the CPU thread stays paused
+static void start(const char *path) {
+    Machine *fork;
+
+    ck_assert(LoadCartridge((char *)path));
+
+    InitEmulator();
+    PauseEmulator();
+    root = GetCurrentInstance();
+    fork = ForkInstance(NULL);
+    ck_assert_ptr_nonnull(fork);
+    SetCurrentInstance(fork);
+}
+
+static void stop(void) {
+    DestroyInstance(SetCurrentInstance(root));
+    StopEmulator();
+    UnloadCartridge();
+}
+
+static void run(u32 frames) {
+    ck_assert(RunInstance(GetCurrentInstance(), frames));
+}
+
+static u8 *save(size_t *outSize) {
+    const size_t size = GetStateSize();
+    u8 *state = malloc(size);
+
+    ck_assert_uint_eq(SaveStateToMemory(state, size), size);
+    ck_assert_uint_eq(SaveStateToMemory(state, size - 1), 0); // One byte short of room is refused
+    *outSize = size;
+    return state;
+}
+
+// Offset of the chunk tagged `tag`, walking the chunk headers
+static size_t find_chunk(const u8 *state, size_t size, const char *tag) {
+    size_t offset = HEADER_SIZE;
+
+    while (offset + CHUNK_HEAD <= size) {
+        u32 payload;
+
+        if (0 == memcmp(state + offset, tag, 4)) return offset;
+        memcpy(&payload, state + offset + 4, sizeof(payload));
+        offset += CHUNK_HEAD + ((payload + 7) & ~7U);
+    }
+    ck_abort_msg("no %s chunk", tag);
+    return 0;
+}
+
+START_TEST(test_round_trip)
+{
+    size_t size, otherSize;
+    u8 *state, *other, *later, *replay;
+    u8 counter;
+
+    write_rom(ROM_PATH, 0);
+    start(ROM_PATH);
+
+    // Something in every chunk: CPU and WRAM (the counter), banks and cartridge RAM
+    run(10);
+    WriteBus(0x2000, 0x02);
+    WriteBus(0x0000, 0x0A);
+    WriteBus(0xA000, 0x5A);
+    counter = ReadBus(0xC000);
+    state = save(&size);
+
+    run(10);
+    WriteBus(0x2000, 0x03);
+    WriteBus(0xA000, 0x00);
+    ck_assert_uint_ne(ReadBus(0xC000), counter);
+    later = save(&otherSize);
+
+    // Loading brings every byte back
+    ck_assert(LoadStateFromMemory(state, size));
+    ck_assert_uint_eq(ReadBus(0xC000), counter);
+    ck_assert_uint_eq(ReadBus(0x4000), 2);
+    ck_assert_uint_eq(ReadBus(0xA000), 0x5A);
+    other = save(&otherSize);
+    ck_assert_uint_eq(otherSize, size);
+    ck_assert(0 == memcmp(other, state, size));
+
+    // And the emulation picks up exactly where it was
+    run(10);
+    free(other);
+    other = save(&otherSize);
+    ck_assert(LoadStateFromMemory(state, size));
+    run(10);
+    replay = save(&otherSize);
+    ck_assert(0 == memcmp(other, replay, size));
+    ck_assert(0 != memcmp(other, later, size)); // Banks and RAM were changed differently
+
+    free(replay);
+    free(later);
+    free(other);
+    free(state);
+    stop();
+    remove(ROM_PATH);
+}
+END_TEST
+
+START_TEST(test_file_round_trip)
+{
+    size_t size, otherSize;
+    u8 *state, *other;
+
+    write_rom(ROM_PATH, 0);
+    start(ROM_PATH);
+
+    run(5);
+    state = save(&size);
+    ck_assert(SaveState(STATE_PATH));
+
+    run(5);
+    ck_assert(LoadState(STATE_PATH));
+    other = save(&otherSize);
+    ck_assert(0 == memcmp(other, state, size));
+
+    free(other);
+    free(state);
+    stop();
+    remove(STATE_PATH);
+    remove(ROM_PATH);
+}
+END_TEST
+
+// Corrupt a copy of `state` with `size` bytes of `value` at `offset`; it must be refused without touching the machine
+static void assert_rejected(const u8 *state, size_t size, size_t offset, const void *value, size_t valueSize) {
+    size_t before, after;
+    u8 *copy = malloc(size);
+    u8 *machine = save(&before);
+    u8 *untouched;
+
+    memcpy(copy, state, size);
+    memcpy(copy + offset, value, valueSize);
+    ck_assert_msg(!LoadStateFromMemory(copy, size), "accepted a state corrupted at %zu", offset);
+
+    untouched = save(&after);
+    ck_assert(0 == memcmp(machine, untouched, before));
+
+    free(untouched);
+    free(machine);
+    free(copy);
+}
+
+START_TEST(test_corrupted_states)
+{
+    static const u32 BAD_MAGIC = 0x12345678;
+    static const u16 BAD_VERSION = 0xFFFF;
+    static const u8 OTHER_MBC = 1;
+    size_t size;
+    u8 *state;
+    u32 value;
+    size_t chunk;
+    u8 flipped;
+
+    write_rom(ROM_PATH, 0);
+    start(ROM_PATH);
+    run(3);
+    state = save(&size);
+    run(3);
+
+    // Header
+    assert_rejected(state, size, 0, &BAD_MAGIC, sizeof(BAD_MAGIC));
+    assert_rejected(state, size, 4, &BAD_VERSION, sizeof(BAD_VERSION));
+    value = (u32)size + 1;
+    assert_rejected(state, size, SIZE_OFFSET, &value, sizeof(value)); // Longer than the data
+    value = HEADER_SIZE - 1;
+    assert_rejected(state, size, SIZE_OFFSET, &value, sizeof(value));
+    flipped = state[HASH_OFFSET] ^ 1;
+    assert_rejected(state, size, HASH_OFFSET, &flipped, 1);           // Another ROM's hash
+
+    // Chunks: a size that does not fit the machine, one past the end, another cartridge's MBC
+    chunk = find_chunk(state, size, "CPU ");
+    memcpy(&value, state + chunk + 4, sizeof(value));
+    ++value;
+    assert_rejected(state, size, chunk + 4, &value, sizeof(value));
+    value = 0xFFFFFF00;
+    assert_rejected(state, size, chunk + 4, &value, sizeof(value));
+    chunk = find_chunk(state, size, "MBC ");
+    assert_rejected(state, size, chunk + CHUNK_HEAD + 5, &OTHER_MBC, 1);
+    chunk = find_chunk(state, size, "WRAM");
+    value = 0;
+    assert_rejected(state, size, chunk + 4, &value, sizeof(value));
+
+    // Cut short
+    ck_assert(!LoadStateFromMemory(state, size - 1));
+    ck_assert(!LoadStateFromMemory(state, HEADER_SIZE - 1));
+    ck_assert(!LoadStateFromMemory(NULL, size));
+
+    // The intact state still loads
+    ck_assert(LoadStateFromMemory(state, size));
+
+    free(state);
+    stop();
+    remove(ROM_PATH);
+}
+END_TEST
+
+START_TEST(test_other_rom)
+{
+    size_t size;
+    u8 *state;
+
+    write_rom(ROM_PATH, 0);
+    write_rom(OTHER_ROM_PATH, 0x10);
+
+    start(ROM_PATH);
+    run(1);
+    state = save(&size);
+    stop();
+
+    // Same header and size, different banks: the hash tells them apart
+    start(OTHER_ROM_PATH);
+    run(1);
+    ck_assert(!LoadStateFromMemory(state, size));
+    stop();
+
+    free(state);
+    remove(OTHER_ROM_PATH);
+    remove(ROM_PATH);
+}
+END_TEST
+
+Suite *state_suite(void) {
+    Suite *s = suite_create("state");
+    TCase *tc = tcase_create("save");
+
+    tcase_add_test(tc, test_round_trip);
+    tcase_add_test(tc, test_file_round_trip);
+    tcase_add_test(tc, test_corrupted_states);
+    tcase_add_test(tc, test_other_rom);
+
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    SetLogLevel(LOG_ERROR); // Rejected states log warnings
+
+    Suite *s = state_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    int nf = srunner_ntests_failed(sr);
+
+    srunner_free(sr);
+    return nf == 0 ? 0 : -1;
+}
@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "camecore/camecore.h"
+
+#define ROM_SIZE  0x8000
+#define MAX_HITS  64
+
+typedef struct Hit {
+    u16 addr;
+    u8 value;
+    WatchKind kind;
+} Hit;
+
+static const char *ROM_PATH = "test_watch.gb";
+
+// Count up at C000 forever: one data read and one write of C000 per loop
+static const u8 PROGRAM[] = {
+    0x21, 0x00, 0xC0, // 0150: LD HL, C000
+    0x34,             // 0153: INC (HL)
+    0x18, 0xFD,       // 0154: JR -3
+};
+
+static Machine *root;
+static Hit hits[MAX_HITS];
+static u32 hitCount;
+
+static void record_hit(u16 addr, u8 value, WatchKind kind) {
+    if (hitCount < MAX_HITS) hits[hitCount] = (Hit){ addr, value, kind };
+    ++hitCount;
+}
+
+// Load a ROM-only cartridge running PROGRAM, then run a fork of its machine on this thread
+static void start(void) {
+    u8 *rom = calloc(1, ROM_SIZE);
+    Machine *fork;
+
+    rom[0x101] = 0xC3; // JP 0150
+    rom[0x102] = 0x50;
+    rom[0x103] = 0x01;
+    memcpy(rom + 0x150, PROGRAM, sizeof(PROGRAM));
+    ck_assert(SaveFileData(ROM_PATH, rom, ROM_SIZE));
+    free(rom);
+    ck_assert(LoadCartridge((char *)ROM_PATH));
+
+    InitEmulator();
+    PauseEmulator();
+    root = GetCurrentInstance();
+    fork = ForkInstance(NULL);
+    ck_assert_ptr_nonnull(fork);
+    SetCurrentInstance(fork);
+    hitCount = 0;
+}
+
+static void stop(void) {
+    ClearWatchpoints();
+    DestroyInstance(SetCurrentInstance(root));
+    StopEmulator();
+    UnloadCartridge();
+    remove(ROM_PATH);
+}
+
+static void assert_hit(u32 index, u16 addr, u8 value, WatchKind kind) {
+    ck_assert_uint_gt(hitCount, index);
+    ck_assert_uint_eq(hits[index].addr, addr);
+    ck_assert_uint_eq(hits[index].value, value);
+    ck_assert_uint_eq(hits[index].kind, kind);
+}
+
+START_TEST(test_single_byte)
+{
+    i32 id;
+
+    start();
+    id = AddWatchpoint(0xC180, 1, WATCH_READ, record_hit);
+    ck_assert_int_ge(id, 0);
+
+    // Neighbours share the trapped page, but are not watched
+    WriteBus(0xC180, 0x42);
+    ReadBus(0xC17F);
+    ReadBus(0xC181);
+    ReadBus(0xC100);
+    ReadBus(0xC1FF);
+    ck_assert_uint_eq(hitCount, 0);
+
+    ck_assert_uint_eq(ReadBus(0xC180), 0x42);
+    ck_assert_uint_eq(hitCount, 1);
+    assert_hit(0, 0xC180, 0x42, WATCH_READ);
+
+    // Removed: silent again
+    ck_assert(RemoveWatchpoint(id));
+    ck_assert(!RemoveWatchpoint(id));
+    ReadBus(0xC180);
+    ck_assert_uint_eq(hitCount, 1);
+
+    stop();
+}
+END_TEST
+
+START_TEST(test_range_across_pages)
+{
+    start();
+
+    // C0FE-C101: the last two bytes of one bus page, the first two of the next
+    ck_assert_int_ge(AddWatchpoint(0xC0FE, 4, WATCH_WRITE, record_hit), 0);
+
+    WriteBus(0xC0FD, 1);
+    WriteBus(0xC102, 2);
+    ReadBus(0xC0FF);
+    ck_assert_uint_eq(hitCount, 0);
+
+    WriteBus(0xC0FE, 3);
+    WriteBus(0xC0FF, 4);
+    WriteBus(0xC100, 5);
+    WriteBus(0xC101, 6);
+    ck_assert_uint_eq(hitCount, 4);
+    assert_hit(0, 0xC0FE, 3, WATCH_WRITE);
+    assert_hit(1, 0xC0FF, 4, WATCH_WRITE);
+    assert_hit(2, 0xC100, 5, WATCH_WRITE);
+    assert_hit(3, 0xC101, 6, WATCH_WRITE);
+
+    // The writes went through
+    ck_assert_uint_eq(ReadBus(0xC0FE), 3);
+    ck_assert_uint_eq(ReadBus(0xC101), 6);
+
+    ClearWatchpoints();
+    WriteBus(0xC100, 7);
+    ck_assert_uint_eq(hitCount, 4);
+
+    stop();
+}
+END_TEST
+
+START_TEST(test_kinds)
+{
+    start();
+
+    // Two watchpoints on one byte, each with its own kind
+    ck_assert_int_ge(AddWatchpoint(0xD000, 1, WATCH_READ, record_hit), 0);
+    ck_assert_int_ge(AddWatchpoint(0xD000, 1, WATCH_WRITE, record_hit), 0);
+
+    WriteBus(0xD000, 0x99);
+    ck_assert_uint_eq(hitCount, 1);
+    assert_hit(0, 0xD000, 0x99, WATCH_WRITE);
+
+    ReadBus(0xD000);
+    ck_assert_uint_eq(hitCount, 2);
+    assert_hit(1, 0xD000, 0x99, WATCH_READ);
+
+    // Invalid requests are refused
+    ck_assert_int_eq(AddWatchpoint(0xD000, 0, WATCH_READ, record_hit), -1);
+    ck_assert_int_eq(AddWatchpoint(0xD000, 1, 0, record_hit), -1);
+    ck_assert_int_eq(AddWatchpoint(0xD000, 1, WATCH_READ, NULL), -1);
+
+    stop();
+}
+END_TEST
+
+START_TEST(test_running_cpu)
+{
+    start();
+
+    // INC (HL) at 0153 reads and writes C000; 0155 is the JR operand, never an opcode or a data read
+    ck_assert_int_ge(AddWatchpoint(0x0153, 1, WATCH_EXECUTE, record_hit), 0);
+    ck_assert_int_ge(AddWatchpoint(0x0155, 1, WATCH_READ | WATCH_EXECUTE, record_hit), 0);
+    ck_assert_int_ge(AddWatchpoint(0xC000, 1, WATCH_READ | WATCH_WRITE, record_hit), 0);
+    ck_assert_int_ge(AddWatchpoint(0xC001, 1, WATCH_READ | WATCH_WRITE, record_hit), 0);
+
+    // Each loop fetches INC (HL), reads the count from C000, then writes it back incremented
+    ck_assert(RunInstance(GetCurrentInstance(), 1));
+    ck_assert_uint_gt(hitCount, MAX_HITS);
+    for (u32 i = 0; i + 2 < MAX_HITS; i += 3) {
+        const u8 count = (u8)(i / 3);
+
+        assert_hit(i, 0x0153, 0x34, WATCH_EXECUTE);
+        assert_hit(i + 1, 0xC000, count, WATCH_READ);
+        assert_hit(i + 2, 0xC000, (u8)(count + 1), WATCH_WRITE);
+    }
+
+    stop();
+}
+END_TEST
+
+Suite *watch_suite(void) {
+    Suite *s = suite_create("watch");
+    TCase *tc = tcase_create("hits");
+
+    // Hits and misses at byte granularity, through the bus and from the CPU
+    tcase_add_test(tc, test_single_byte);
+    tcase_add_test(tc, test_range_across_pages);
+    tcase_add_test(tc, test_kinds);
+    tcase_add_test(tc, test_running_cpu);
+
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    SetLogLevel(LOG_ERROR); // Refused watchpoints log warnings
+
+    Suite *s = watch_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    int nf = srunner_ntests_failed(sr);
+
+    srunner_free(sr);
+    return nf == 0 ? 0 : -1;
+}